@@ -6,8 +6,8 @@
 #endif
 
 struct liActionRegexStackElement {
-	GString *string;
-	GMatchInfo *match_info;
+	GString *string; /* subject owned by the element; NULL if vr->condition_cache owns it */
+	liRegexMatch *match;
 };
 
 struct liActionStack {
@@ -68,6 +68,12 @@ struct liAction {
 
 		GArray* list; /** array of (action*) */
 
+		struct {
+			liConditionSwitch *sw;
+			GPtrArray *targets; /** (action*) for each entry of the switch, may be NULL */
+			liAction *target_else; /** if no entry matched */
+		} cswitch; /** created by li_action_compile from chains of conditions */
+
 		liBalancerFunc balancer;
 	} data;
 };
@@ -81,6 +87,11 @@ LI_API void li_action_stack_clear(liVRequest *vr, liActionStack *as);
 LI_API void li_action_enter(liVRequest *vr, liAction *a);
 LI_API liHandlerResult li_action_execute(liVRequest *vr);
 
+/* prepare a loaded config for execution: flattens nested lists (in place, also for shared actions),
+ * drops empty actions and turns "else if" chains of string conditions into switches.
+ * call once before the actions are used by workers */
+LI_API void li_action_compile(liServer *srv, liAction *a);
+
 
 LI_API void li_action_release(liServer *srv, liAction *a);
 LI_API void li_action_acquire(liAction *a);
@@ -2,6 +2,8 @@
 #define _LIGHTTPD_ANGEL_H_
 
 typedef void (*liAngelListenCB)(liServer *srv, int fd, gpointer data);
+/* fds: array of int (one per requested socket), NULL on error; callback takes ownership of the fds */
+typedef void (*liAngelListenReuseportCB)(liServer *srv, GArray *fds, gpointer data);
 
 typedef void (*liAngelLogOpen)(liServer *srv, int fd, gpointer data);
 
@@ -11,6 +13,9 @@ LI_API void li_angel_setup(liServer *srv);
 /* listen to a socket (mainloop context) */
 LI_API void li_angel_listen(liServer *srv, GString *str, liAngelListenCB cb, gpointer data);
 
+/* listen to a socket address with count SO_REUSEPORT sockets (mainloop context) */
+LI_API void li_angel_listen_reuseport(liServer *srv, GString *str, guint count, liAngelListenReuseportCB cb, gpointer data);
+
 /* send log messages during startup to angel, frees the string */
 LI_API void li_angel_log(liServer *srv, GString *str);
 
@@ -18,6 +23,7 @@ LI_API void li_angel_log_open_file(liServer *srv, liEventLoop *loop, GString *fi
 
 /* angle_fake definitions, only for internal use */
 int li_angel_fake_listen(liServer *srv, GString *str);
+GArray* li_angel_fake_listen_reuseport(liServer *srv, GString *str, guint count);
 gboolean li_angel_fake_log(liServer *srv, GString *str);
 int li_angel_fake_log_open_file(liServer *srv, GString *filename);
 
@@ -0,0 +1,32 @@
+#ifndef _LIGHTTPD_ARENA_H_
+#define _LIGHTTPD_ARENA_H_
+
+#include <lighttpd/settings.h>
+
+/* bump allocator for objects with a common lifetime (e.g. one request):
+ * memory can't be freed piecewise, li_arena_reset releases all allocations at once
+ * and keeps the first block for the next round, so a steady workload doesn't call
+ * the system allocator at all.
+ * not thread-safe.
+ */
+
+typedef struct liArenaBlock liArenaBlock;
+
+typedef struct liArena liArena;
+struct liArena {
+	liArenaBlock *blocks;             /* current block first */
+	gsize block_size;
+
+	/* statistics */
+	guint64 allocations, block_allocations;
+};
+
+LI_API liArena* li_arena_new(gsize block_size);
+LI_API void li_arena_free(liArena *arena);
+LI_API void li_arena_reset(liArena *arena);
+
+/* memory is aligned for any type; never returns NULL */
+LI_API gpointer li_arena_alloc(liArena *arena, gsize size);
+LI_API gpointer li_arena_alloc0(liArena *arena, gsize size);
+
+#endif
@@ -13,15 +13,20 @@
 #include <lighttpd/angel_data.h>
 #include <lighttpd/angel_connection.h>
 
+#include <lighttpd/arena.h>
 #include <lighttpd/buffer.h>
 #include <lighttpd/chunk.h>
 #include <lighttpd/chunk_parser.h>
+#include <lighttpd/network.h>
 
 #include <lighttpd/waitqueue.h>
+#include <lighttpd/uring.h>
 #include <lighttpd/stream.h>
 #include <lighttpd/filter.h>
 #include <lighttpd/filter_chunked.h>
 #include <lighttpd/radix.h>
+#include <lighttpd/regex.h>
+#include <lighttpd/regex_set.h>
 #include <lighttpd/fetch.h>
 
 #include <lighttpd/value.h>
@@ -43,12 +48,12 @@
 #include <lighttpd/environment.h>
 #include <lighttpd/virtualrequest.h>
 #include <lighttpd/stat_cache.h>
+#include <lighttpd/content_cache.h>
 #include <lighttpd/mimetype.h>
 
 #include <lighttpd/connection.h>
 
 #include <lighttpd/collect.h>
-#include <lighttpd/network.h>
 #include <lighttpd/etag.h>
 #include <lighttpd/utils.h>
 
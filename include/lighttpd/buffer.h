@@ -6,12 +6,15 @@
 #include <lighttpd/mempool.h>
 
 typedef struct liBuffer liBuffer;
+typedef struct liBufferPool liBufferPool;
+
 struct liBuffer {
 	gchar *addr;
 	gsize alloc_size;
 	gsize used;
 	gint refcount;
 	liMempoolPtr mptr;
+	liBufferPool *pool; /* put back into the pool after the last reference is released (if released in the pool thread) */
 };
 
 /* shared buffer; free memory after last reference is released */
@@ -24,4 +27,30 @@ LI_API liBuffer* li_buffer_new_slice(gsize max_size);
 LI_API void li_buffer_acquire(liBuffer *buf);
 LI_API void li_buffer_release(liBuffer *buf);
 
+/* pool of free buffers in size classes (4k, 16k, 64k) for one thread (worker);
+ * buffers released in other threads, or while the free buffers already use max_free bytes, are freed instead of put back.
+ */
+#define LI_BUFFER_POOL_CLASSES 3
+
+struct liBufferPool {
+	gint refcount; /* one from the owner + one per pooled buffer */
+	GThread *owner; /* NULL after li_buffer_pool_free */
+
+	GPtrArray *free[LI_BUFFER_POOL_CLASSES];
+	guint low_water[LI_BUFFER_POOL_CLASSES]; /* minimum free[i]->len since last trim */
+	gsize free_size, max_free; /* bytes in the free buffers, limit */
+
+	/* statistics */
+	guint64 hits, misses;
+};
+
+/** creates a pool owned by the current thread, keeping at most max_free bytes in free buffers */
+LI_API liBufferPool* li_buffer_pool_new(gsize max_free);
+/** frees the free buffers; buffers still in use keep the pool struct alive until released */
+LI_API void li_buffer_pool_free(liBufferPool *pool);
+/** new buffer with at least size bytes; larger sizes than the biggest class (or pool == NULL) use li_buffer_new */
+LI_API liBuffer* li_buffer_pool_get(liBufferPool *pool, gsize size);
+/** release free buffers which weren't needed since the last trim (call periodically) */
+LI_API void li_buffer_pool_trim(liBufferPool *pool);
+
 #endif
@@ -6,6 +6,9 @@
 #endif
 
 #include <lighttpd/events.h>
+#include <lighttpd/tasklet.h>
+
+#include <sys/uio.h>
 
 /* Open a file only once, so it shouldn't get lost;
  * as a file may get split into many chunks, we
@@ -19,8 +22,20 @@ struct liChunkFile {
 	gboolean is_temp; /* file is temporary and will be deleted on cleanup */
 };
 
+/* pipe for splice() (linux): data gets spliced from a socket into the pipe and from the pipe
+ * into another socket without being copied to userspace. PIPE_CHUNKs refer to ranges of the
+ * byte stream written into the pipe; the data can only be consumed in order, so data skipped in
+ * a chunkqueue is discarded from the pipe right before the next chunk is sent.
+ */
+struct liChunkPipe {
+	gint refcount;
+
+	int fd_read, fd_write;
+	goffset read_pos, write_pos; /* bytes consumed from / written to the pipe */
+};
+
 struct liChunk {
-	enum { UNUSED_CHUNK, STRING_CHUNK, MEM_CHUNK, FILE_CHUNK, BUFFER_CHUNK } type;
+	enum { UNUSED_CHUNK, STRING_CHUNK, MEM_CHUNK, FILE_CHUNK, BUFFER_CHUNK, PIPE_CHUNK } type;
 
 	goffset offset;
 	/* if type == FILE_CHUNK and mem != NULL,
@@ -41,11 +56,18 @@ struct liChunk {
 				size_t length; /* size of the mmap'ed area */
 				off_t  offset; /* start is <n> octets away from the start of the file */
 			} mmap;
+
+			liChunkAsyncRead *async_read; /* pending (or failed) li_chunkiter_read_async() */
 		} file;
 		struct {
 			liBuffer *buffer;
 			gsize offset, length;
 		} buffer;
+		struct {
+			liChunkPipe *pipe;
+			goffset start; /* position of the data in the pipe stream */
+			goffset length;
+		} pipe;
 	} data;
 
 	/* a chunk can only be in one queue, so we just reserve the memory for the link in it */
@@ -70,7 +92,7 @@ struct liChunkQueue {
 	gboolean is_closed;
 /* read only */
 	goffset bytes_in, bytes_out, length, mem_usage;
-	liCQLimit *limit; /* limit is the sum of all { c->mem->len | c->type == STRING_CHUNK } */
+	liCQLimit *limit; /* limit is the sum of the lengths of all memory and pipe chunks */
 /* private */
 	GQueue queue;
 };
@@ -96,6 +118,18 @@ LI_API void li_chunkfile_release(liChunkFile *cf);
  */
 LI_API liHandlerResult li_chunkfile_open(liChunkFile *cf, GError **err);
 
+/******************
+ *   chunkpipe    *
+ ******************/
+
+/* returns NULL if splice() is not supported or pipe() failed */
+LI_API liChunkPipe *li_chunkpipe_new(void);
+LI_API void li_chunkpipe_acquire(liChunkPipe *cp);
+LI_API void li_chunkpipe_release(liChunkPipe *cp);
+
+/* read (and drop) data from the pipe until cp->read_pos == pos; returns FALSE on error */
+LI_API gboolean li_chunkpipe_discard(liChunkPipe *cp, goffset pos, GError **err);
+
 /******************
  * chunk iterator *
  ******************/
@@ -106,6 +140,7 @@ INLINE goffset li_chunkiter_length(liChunkIter iter);
 
 /* get the data from a chunk; easy in case of a STRING_CHUNK,
  * but needs to do io in case of FILE_CHUNK; the data is _not_ marked as "done"
+ * PIPE_CHUNKs can't be read.
  * may return HANDLER_GO_ON, HANDLER_ERROR
  */
 LI_API liHandlerResult li_chunkiter_read(liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err);
@@ -115,6 +150,22 @@ LI_API liHandlerResult li_chunkiter_read(liChunkIter iter, off_t start, off_t le
  */
 LI_API liHandlerResult li_chunkiter_read_mmap(liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err);
 
+/* same as li_chunkiter_read, but doesn't block on file io: if the data of a FILE_CHUNK isn't loaded yet,
+ * it is read with pread() in the tasklet pool (with a readahead hint for the following data) and
+ * HANDLER_WAIT_FOR_EVENT is returned; wakeup is triggered when the data is ready, call again then.
+ * the tasklet pool must run in the loop of the wakeup job.
+ * may return less data than requested (only the part already loaded)
+ * may return HANDLER_GO_ON, HANDLER_WAIT_FOR_EVENT, HANDLER_ERROR
+ */
+LI_API liHandlerResult li_chunkiter_read_async(liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, liTaskletPool *pool, liJobRef *wakeup, GError **err);
+
+/* fills iov with the memory chunks (STRING_CHUNK, MEM_CHUNK, BUFFER_CHUNK) starting at *iter, until
+ * iov_max entries or max_length bytes are reached or another chunk type is found.
+ * returns the number of entries, the number of bytes in *length; *iter is moved to the first chunk
+ * not gathered (the last chunk may be gathered partially if max_length was reached)
+ */
+LI_API guint li_chunkiter_gather_iovec(liChunkIter *iter, struct iovec *iov, guint iov_max, goffset max_length, goffset *length);
+
 /******************
  *     chunk      *
  ******************/
@@ -168,6 +219,10 @@ LI_API void li_chunkqueue_append_mem(liChunkQueue *cq, const void *mem, gssize l
 /* increases reference for cf (if length > 0) */
 LI_API void li_chunkqueue_append_chunkfile(liChunkQueue *cq, liChunkFile *cf, off_t start, off_t length);
 
+/* length bytes were written to the pipe: appends them (extends the last chunk if possible) and
+ * increases cp->write_pos; increases reference for cp */
+LI_API void li_chunkqueue_append_pipe(liChunkQueue *cq, liChunkPipe *cp, goffset length);
+
 /* pass ownership of filename, do not free it */
 LI_API void li_chunkqueue_append_file(liChunkQueue *cq, GString *filename, off_t start, off_t length);
 /* if you already opened the file, you can pass the fd here - do not close it */
@@ -248,6 +303,8 @@ INLINE goffset li_chunk_length(liChunk *c) {
 		return c->data.file.length - c->offset;
 	case BUFFER_CHUNK:
 		return c->data.buffer.length - c->offset;
+	case PIPE_CHUNK:
+		return c->data.pipe.length - c->offset;
 	}
 	return 0;
 }
@@ -90,7 +90,7 @@ struct liConditionRValue {
 
 	gboolean b;
 	GString *string;
-	GRegex *regex;
+	liRegex *regex;
 	gint64 i;
 	struct {
 		guint32 addr;
@@ -130,6 +130,18 @@ LI_API liCondLValue li_cond_lvalue_from_string(const gchar *str, guint len);
 
 LI_API liHandlerResult li_condition_check(liVRequest *vr, liCondition *cond, gboolean *result);
 
+/* multi-way match for a chain of string conditions with the same lvalue and operator (==, =^ or =$):
+ * finds the first matching entry with a hash table (==) or a radix tree (=^, =$ reversed)
+ * instead of comparing each string in turn */
+LI_API liConditionSwitch* li_condition_switch_new(liCondition *first); /* NULL if the condition can't be used */
+LI_API gboolean li_condition_switch_add(liConditionSwitch *sw, liCondition *cond); /* FALSE if cond doesn't fit */
+LI_API guint li_condition_switch_count(liConditionSwitch *sw);
+LI_API void li_condition_switch_free(liConditionSwitch *sw);
+/* *ndx: index of the first matching entry (in order of adding), G_MAXUINT if none matched */
+LI_API liHandlerResult li_condition_switch_check(liVRequest *vr, liConditionSwitch *sw, guint *ndx);
+/* same for a given value of the lvalue (val[len] must be 0) */
+LI_API guint li_condition_switch_match(liConditionSwitch *sw, const gchar *val, gsize len);
+
 /* condition values */
 
 typedef enum {
@@ -152,6 +164,30 @@ typedef struct {
 	} data;
 } liConditionValue;
 
+/* per vrequest memo of condition values. entries are checked against the current request state
+ * before they are used (stat results against physical.path, header values against the header list
+ * version, string copies against the field), so rewrites, docroot or header changes need no explicit
+ * invalidation.
+ */
+struct liConditionCache {
+	/* stat() of physical.path for physical.exists/isdir/isfile/size */
+	GString *stat_path; /* physical.path the result belongs to */
+	gboolean stat_valid, stat_found, stat_isdir, stat_isfile;
+	goffset stat_size;
+
+	/* request/response header values */
+	GArray *headers;
+	guint headers_next; /* slot to replace next if all are used */
+
+	/* copies of string fields regex conditions matched against (match info references the subject) */
+	GString *snapshots[LI_COND_LVALUE_FIRST_WITH_KEY];
+	GPtrArray *retired; /* outdated snapshots, might still be referenced from the regex stack */
+};
+
+LI_API void li_condition_cache_init(liConditionCache *cache);
+LI_API void li_condition_cache_reset(liConditionCache *cache);
+LI_API void li_condition_cache_clear(liConditionCache *cache);
+
 LI_API liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liConditionLValue *lvalue, liConditionValue *res, liConditionValueType prefer);
 /* tmpstr can be the same as for li_condition_get_value */
 LI_API gchar const* li_condition_value_to_string(GString *tmpstr, liConditionValue *value);
@@ -40,6 +40,8 @@ struct liConnectionSocketCallbacks {
 	void (*finish)(liConnection *con, gboolean aborted);
 	liThrottleState* (*throttle_out)(liConnection *con);
 	liThrottleState* (*throttle_in)(liConnection *con);
+	/* optional: waiting for the next keep-alive request; release buffers not needed for that */
+	void (*idle)(liConnection *con);
 };
 
 struct liConnectionSocket {
@@ -57,6 +59,7 @@ struct liConnection {
 	liConnectionSocket con_sock;
 
 	liConInfo info;
+	liSockAddr remote_addr_storage, local_addr_storage; /* memory for info.remote_addr / info.local_addr, reused */
 
 	liConnectionState state;
 	gboolean response_headers_sent, expect_100_cont, out_has_all_data;
@@ -97,7 +100,7 @@ LI_API void li_connection_update_io_wait(liConnection *con);
 /** aborts an active connection, calls all plugin cleanup handlers */
 LI_API void li_connection_error(liConnection *con); /* used in worker.c */
 
-LI_API void li_connection_start(liConnection *con, liSocketAddress remote_addr, int s, liServerSocket *srv_sock);
+LI_API void li_connection_start(liConnection *con, const liSockAddr *remote_addr, socklen_t remote_addr_len, int s, liServerSocket *srv_sock);
 
 /* public function */
 LI_API gchar *li_connection_state_str(liConnectionState state);
@@ -0,0 +1,56 @@
+/*
+ * content cache - small static files in memory
+ *
+ * Each worker keeps the content of small files (content_cache.max_file_size) in liBuffers, so the static action can
+ * send them as BUFFER_CHUNK together with the response headers in one writev() - no fd per request, no sendfile().
+ * The memory limit (content_cache.memory) is for all workers together; every worker gets an equal share of it and
+ * evicts the least recently used entries when its share is full.
+ *
+ * Entries are keyed by path and only used if the stat() result (from the stat cache) still shows the same inode,
+ * size, mtime and ctime; so content is at most as stale as the stat cache.
+ * Filling the cache reads the (small) file synchronously with pread() from an already opened fd, like the network
+ * backends do for FILE_CHUNKs anyway.
+ */
+
+#ifndef _LIGHTTPD_CONTENT_CACHE_H_
+#define _LIGHTTPD_CONTENT_CACHE_H_
+
+#ifndef _LIGHTTPD_BASE_H_
+#error Please include <lighttpd/base.h> instead of this file
+#endif
+
+struct liContentCacheEntry {
+	GString *path;
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	time_t mtime, ctime;
+	liBuffer *buf;
+	GList lru_link;                   /* in cc->lru, head is the most recently used */
+};
+
+struct liContentCache {
+	GHashTable *entries;              /* GString* path => liContentCacheEntry* */
+	GQueue lru;
+	gsize mem_used, mem_max;
+	goffset max_file_size;
+
+	guint64 hits;
+	guint64 misses;
+	guint64 evictions;
+	guint64 bytes_served;             /* body bytes served from the cache */
+};
+
+LI_API liContentCache* li_content_cache_new(gsize mem_max, goffset max_file_size);
+LI_API void li_content_cache_free(liContentCache *cc);
+
+/* whether a file with stat info st could be cached */
+LI_API gboolean li_content_cache_usable(liContentCache *cc, const struct stat *st);
+
+/* returns a new buffer reference (buf->used == st->st_size) or NULL if path is not cached with the same stat info */
+LI_API liBuffer* li_content_cache_lookup(liContentCache *cc, GString *path, const struct stat *st);
+
+/* reads the file from fd and inserts it; returns a new buffer reference or NULL on failure (or if it doesn't fit) */
+LI_API liBuffer* li_content_cache_insert(liContentCache *cc, GString *path, const struct stat *st, int fd);
+
+#endif
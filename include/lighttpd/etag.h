@@ -13,4 +13,11 @@ LI_API gboolean li_http_response_handle_cachable(liVRequest *vr);
 LI_API void li_etag_mutate(GString *mut, GString *etag);
 LI_API void li_etag_set_header(liVRequest *vr, struct stat *st, gboolean *cachable);
 
+/* ETag value for st with the etag.use flags (flags must not be 0) */
+LI_API void li_etag_format(GString *out, guint flags, struct stat *st);
+/* value for the Last-Modified header; returns FALSE if mtime couldn't be converted */
+LI_API gboolean li_etag_format_last_modified(GString *out, time_t mtime);
+/* like li_etag_set_header with precomputed values; etag == NULL removes the ETag header, last_modified == NULL is ignored */
+LI_API void li_etag_set_header_values(liVRequest *vr, GString *etag, GString *last_modified, gboolean *cachable);
+
 #endif
@@ -4,6 +4,8 @@
 #include <lighttpd/settings.h>
 #include <lighttpd/utils.h>
 
+#include <time.h>
+
 enum {
 	LI_EV_READ    = 0x01,
 	LI_EV_WRITE   = 0x02,
@@ -123,8 +125,15 @@ LI_API const char* li_event_loop_backend_string(liEventLoop *loop);
 
 INLINE li_tstamp li_event_time(void);
 INLINE li_tstamp li_event_now(liEventLoop *loop);
+/* CLOCK_MONOTONIC: for measuring durations, doesn't jump if the system time is changed */
+INLINE li_tstamp li_event_monotonic_time(void);
 
 LI_API void li_event_add_closing_socket(liEventLoop *loop, int fd);
+/* cb (if not NULL) gets called with closing = FALSE each time the socket wakes up (readable or error) while
+ * waiting for EOF and after EOF; returning TRUE then delays the close (until cb returns FALSE or the timeout).
+ * gets called with closing = TRUE right before close(fd), the return value is ignored */
+typedef gboolean (*liEventClosingSocketCB)(int fd, gboolean closing, gpointer data);
+LI_API void li_event_add_closing_socket_cb(liEventLoop *loop, int fd, liEventClosingSocketCB cb, gpointer data);
 
 INLINE void li_event_attach_(liEventLoop *loop, liEventBase *base);
 INLINE void li_event_detach_(liEventBase *base);
@@ -184,6 +193,8 @@ INLINE liEventSignal* li_event_signal_from(liEventBase *base);
 
 /* defaults to keep_loop_alive = FALSE, starts immediately */
 LI_API void li_event_prepare_init(liEventLoop *loop, const char *event_name, liEventPrepare *prepare, liEventCallback callback);
+/* run after all other prepare watchers (like the jobqueue), i.e. right before the loop blocks */
+LI_API void li_event_prepare_run_last(liEventPrepare *prepare);
 INLINE liEventPrepare* li_event_prepare_from(liEventBase *base);
 
 /* defaults to keep_loop_alive = FALSE, starts immediately */
@@ -206,6 +217,12 @@ INLINE li_tstamp li_event_time(void) {
 	return ev_time();
 }
 
+INLINE li_tstamp li_event_monotonic_time(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 INLINE void li_event_attach_(liEventLoop *loop, liEventBase *base) {
 	LI_FORCE_ASSERT(NULL == base->link_watchers.data);
 	LI_FORCE_ASSERT(NULL != loop);
@@ -32,6 +32,12 @@ LI_API liFilter* li_filter_new(liVRequest *vr, liFilterHandlerCB handle_data, li
 LI_API liFilter* li_vrequest_add_filter_in(liVRequest *vr, liFilterHandlerCB handle_data, liFilterFreeCB handle_free, liFilterEventCB handle_event, gpointer param);
 LI_API liFilter* li_vrequest_add_filter_out(liVRequest *vr, liFilterHandlerCB handle_data, liFilterFreeCB handle_free, liFilterEventCB handle_event, gpointer param);
 
+/* reads file data with li_chunkiter_read_async() in the tasklet pool of the worker instead of blocking it;
+ * returns HANDLER_WAIT_FOR_EVENT while loading, the filter gets called again when the data is ready.
+ * falls back to li_chunkiter_read() if the vrequest is gone.
+ */
+LI_API liHandlerResult li_filter_chunkiter_read(liFilter *f, liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err);
+
 LI_API void li_vrequest_filters_init(liVRequest *vr);
 LI_API void li_vrequest_filters_clear(liVRequest *vr);
 LI_API void li_vrequest_filters_reset(liVRequest *vr);
@@ -14,13 +14,79 @@
 #define LI_HEADER_KEY_LEN(h) \
 	((h)->data->str), ((h)->keylen)
 
+/* well-known header names are interned to an id when the header is created;
+ * lookups for them use the per-list index instead of comparing names */
+typedef enum {
+	LI_HTTP_HEADER_OTHER = 0, /** not a well-known header name */
+	LI_HTTP_HEADER_ACCEPT,
+	LI_HTTP_HEADER_ACCEPT_CHARSET,
+	LI_HTTP_HEADER_ACCEPT_ENCODING,
+	LI_HTTP_HEADER_ACCEPT_LANGUAGE,
+	LI_HTTP_HEADER_ACCEPT_RANGES,
+	LI_HTTP_HEADER_AGE,
+	LI_HTTP_HEADER_ALLOW,
+	LI_HTTP_HEADER_AUTHORIZATION,
+	LI_HTTP_HEADER_CACHE_CONTROL,
+	LI_HTTP_HEADER_CONNECTION,
+	LI_HTTP_HEADER_CONTENT_ENCODING,
+	LI_HTTP_HEADER_CONTENT_LANGUAGE,
+	LI_HTTP_HEADER_CONTENT_LENGTH,
+	LI_HTTP_HEADER_CONTENT_LOCATION,
+	LI_HTTP_HEADER_CONTENT_RANGE,
+	LI_HTTP_HEADER_CONTENT_TYPE,
+	LI_HTTP_HEADER_COOKIE,
+	LI_HTTP_HEADER_DATE,
+	LI_HTTP_HEADER_ETAG,
+	LI_HTTP_HEADER_EXPECT,
+	LI_HTTP_HEADER_EXPIRES,
+	LI_HTTP_HEADER_HOST,
+	LI_HTTP_HEADER_IF_MATCH,
+	LI_HTTP_HEADER_IF_MODIFIED_SINCE,
+	LI_HTTP_HEADER_IF_NONE_MATCH,
+	LI_HTTP_HEADER_IF_RANGE,
+	LI_HTTP_HEADER_IF_UNMODIFIED_SINCE,
+	LI_HTTP_HEADER_KEEP_ALIVE,
+	LI_HTTP_HEADER_LAST_MODIFIED,
+	LI_HTTP_HEADER_LOCATION,
+	LI_HTTP_HEADER_PRAGMA,
+	LI_HTTP_HEADER_PROXY_AUTHORIZATION,
+	LI_HTTP_HEADER_RANGE,
+	LI_HTTP_HEADER_REFERER,
+	LI_HTTP_HEADER_SERVER,
+	LI_HTTP_HEADER_SET_COOKIE,
+	LI_HTTP_HEADER_TE,
+	LI_HTTP_HEADER_TRAILER,
+	LI_HTTP_HEADER_TRANSFER_ENCODING,
+	LI_HTTP_HEADER_UPGRADE,
+	LI_HTTP_HEADER_USER_AGENT,
+	LI_HTTP_HEADER_VARY,
+	LI_HTTP_HEADER_VIA,
+	LI_HTTP_HEADER_WWW_AUTHENTICATE,
+	LI_HTTP_HEADER_X_FORWARDED_FOR,
+	LI_HTTP_HEADER_X_FORWARDED_PROTO,
+	LI_HTTP_HEADER_X_SENDFILE,
+	LI_HTTP_HEADER__COUNT
+} liHttpHeaderId;
+
 struct liHttpHeader {
 	guint keylen;     /** length of "headername" in data */
 	GString *data;    /** "headername: value" */
+	liHttpHeaderId id;
 };
 
 struct liHttpHeaders {
 	GQueue entries;
+
+	/* if not NULL all entries (including strings and list links) are allocated from the arena,
+	 * and are only released by li_http_headers_reset/li_http_headers_free.
+	 * don't let GString functions grow header data: use the li_http_header_* functions. */
+	liArena *arena;
+
+	/* first and last entry for each well-known header name (NULL if not present) */
+	GList *first[LI_HTTP_HEADER__COUNT], *last[LI_HTTP_HEADER__COUNT];
+
+	/* incremented by every change through the li_http_header(s)_* functions; lets lookups be cached */
+	guint version;
 };
 
 typedef struct liHttpHeaderTokenizer liHttpHeaderTokenizer;
@@ -31,7 +97,13 @@ struct liHttpHeaderTokenizer {
 
 /* strings always get copied, so you should free key and value yourself */
 
+/** id of a well-known header name (case-insensitive), LI_HTTP_HEADER_OTHER otherwise */
+LI_API liHttpHeaderId li_http_header_id(const gchar *key, size_t keylen);
+
 LI_API liHttpHeaders* li_http_headers_new(void);
+/* for header lists that are reset regularly (request/response headers) */
+#define LI_HTTP_HEADERS_ARENA_BLOCK_SIZE (4*1024)
+LI_API liHttpHeaders* li_http_headers_new_with_arena(gsize block_size);
 LI_API void li_http_headers_reset(liHttpHeaders* headers);
 LI_API void li_http_headers_free(liHttpHeaders* headers);
 
@@ -18,8 +18,33 @@ LI_API ssize_t li_net_write(int fd, void *buf, ssize_t nbyte);
 /** repeats read after EINTR */
 LI_API ssize_t li_net_read(int fd, void *buf, ssize_t nbyte);
 
-LI_API liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, GError **err);
-LI_API liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBuffer **buffer, GError **err);
+/* zc: zero copy state of the socket (NULL: always copy) */
+LI_API liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, liNetworkZeroCopy *zc, GError **err);
+/* li_network_write without zero copy */
+LI_API liNetworkStatus li_network_write_chunks(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
+/* TCP_NOTSENT_LOWAT (linux 3.12): the socket only gets writable while less than lowat bytes are unsent.
+ * returns FALSE if not supported
+ */
+LI_API gboolean li_network_set_notsent_lowat(int fd, goffset lowat);
+/* number of bytes in the socket send buffer not sent yet (SIOCOUTQNSD), -1 if unknown */
+LI_API goffset li_network_unsent_bytes(int fd);
+
+/* per socket state of li_network_read */
+struct liNetworkReadState {
+	gsize read_size; /* size of new buffers, adapted to the data available per read event (0: default) */
+	guint64 syscalls; /* number of read syscalls */
+};
+
+/* reads with readv() into the rest of the current buffer and a new buffer, and stops after a short read
+ * (instead of waiting for EAGAIN): returns LI_NETWORK_STATUS_WAIT_FOR_EVENT then, even if data was read.
+ * new buffers are taken from pool (if not NULL); state may be NULL (fixed buffer size)
+ */
+LI_API liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBuffer **buffer, liBufferPool *pool, liNetworkReadState *state, GError **err);
+
+/* splice() from fd into the pipe cp (PIPE_CHUNKs); falls back to li_network_read if the pipe is full
+ * or splice() is not supported
+ */
+LI_API liNetworkStatus li_network_read_splice(int fd, liChunkQueue *cq, goffset read_max, liChunkPipe *cp, liBuffer **buffer, liBufferPool *pool, liNetworkReadState *state, GError **err);
 
 /* use writev for mem chunks, buffered read/write for files */
 LI_API liNetworkStatus li_network_write_writev(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
@@ -29,9 +54,25 @@ LI_API liNetworkStatus li_network_write_writev(int fd, liChunkQueue *cq, goffset
 LI_API liNetworkStatus li_network_write_sendfile(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
 #endif
 
+/* MSG_ZEROCOPY (linux): runs of buffer chunks with at least min_size bytes are sent without copying them into
+ * the kernel. the buffers stay referenced until the kernel reports the send as completed on the socket error
+ * queue, which is read on every write and with li_network_zerocopy_reap (the socket becomes readable).
+ * falls back to the normal backends if not supported.
+ */
+LI_API liNetworkZeroCopy* li_network_zerocopy_new(goffset min_size);
+/* releases all buffers; only use if the socket is already gone, see li_network_zerocopy_close */
+LI_API void li_network_zerocopy_free(liNetworkZeroCopy *zc);
+LI_API gboolean li_network_zerocopy_pending(liNetworkZeroCopy *zc);
+LI_API void li_network_zerocopy_reap(int fd, liNetworkZeroCopy *zc);
+/* call right before close(fd); resets the connection on close if the kernel still uses some buffers. frees zc
+ * for a normal close wait (li_worker_add_closing_socket_cb) until li_network_zerocopy_pending is FALSE */
+LI_API void li_network_zerocopy_close(int fd, liNetworkZeroCopy *zc);
+LI_API liNetworkStatus li_network_write_zerocopy(int fd, liChunkQueue *cq, goffset *write_max, liNetworkZeroCopy *zc, GError **err);
+
 /* write backends */
 LI_API liNetworkStatus li_network_backend_write(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
 LI_API liNetworkStatus li_network_backend_writev(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
+LI_API liNetworkStatus li_network_backend_splice(int fd, liChunkQueue *cq, goffset *write_max, GError **err);
 
 #define LI_NETWORK_FALLBACK(f, write_max) do { \
 	liNetworkStatus res; \
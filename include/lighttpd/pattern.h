@@ -20,7 +20,7 @@ LI_API void li_pattern_eval(liVRequest *vr, GString *dest, liPattern *pattern, l
 
 /* default array callback, expects a GArray* containing GString* elements */
 LI_API void li_pattern_array_cb(GString *pattern_result, guint from, guint to, gpointer data);
-/* default regex callback, expects a GMatchInfo* */
+/* default regex callback, expects a liRegexMatch* */
 LI_API void li_pattern_regex_cb(GString *pattern_result, guint from, guint to, gpointer data);
 
 #endif
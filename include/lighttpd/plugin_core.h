@@ -9,6 +9,8 @@ enum liCoreOptions {
 	LI_CORE_OPTION_DEBUG_REQUEST_HANDLING = 0,
 
 	LI_CORE_OPTION_STATIC_RANGE_REQUESTS,
+	LI_CORE_OPTION_STATIC_HEADER_CACHE,
+	LI_CORE_OPTION_STATIC_INLINE_MAX_SIZE,
 
 	LI_CORE_OPTION_MAX_KEEP_ALIVE_IDLE,
 	LI_CORE_OPTION_MAX_KEEP_ALIVE_REQUESTS,
@@ -20,6 +22,8 @@ enum liCoreOptions {
 	LI_CORE_OPTION_BUFFER_ON_DISK_REQUEST_BODY,
 
 	LI_CORE_OPTION_STRICT_POST_CONTENT_LENGTH,
+
+	LI_CORE_OPTION_BACKEND_SPLICE,
 };
 
 enum liCoreOptionPtrs {
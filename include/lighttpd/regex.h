@@ -0,0 +1,50 @@
+#ifndef _LIGHTTPD_REGEX_H_
+#define _LIGHTTPD_REGEX_H_
+
+#include <lighttpd/settings.h>
+
+/* liRegex: compiled regular expression (PCRE syntax, subjects are raw bytes - no utf-8 checks)
+ *
+ * engines:
+ *  - pcre2 (if built with pcre2): JIT compiled patterns; matching uses match data and a JIT stack (up to 1M)
+ *    owned by the calling (worker) thread, only the offsets of successful matches get copied out. if the JIT
+ *    stack isn't enough, the match is retried with the interpreter
+ *  - glib: GRegex; also used for patterns pcre2 doesn't accept
+ */
+
+#define LI_REGEX_ERROR li_regex_error_quark()
+LI_API GQuark li_regex_error_quark(void);
+
+typedef enum {
+	LI_REGEX_ENGINE_GLIB,
+	LI_REGEX_ENGINE_PCRE2
+} liRegexEngine;
+
+typedef struct liRegex liRegex;
+
+/* captures of a successful match; references the subject string */
+typedef struct liRegexMatch liRegexMatch;
+
+/* engine for regexes created afterwards (default pcre2 if available);
+ * returns FALSE if the engine isn't available */
+LI_API gboolean li_regex_engine_set(liRegexEngine engine);
+LI_API liRegexEngine li_regex_engine_get(void);
+LI_API const gchar* li_regex_engine_name(liRegexEngine engine);
+
+LI_API liRegex* li_regex_new(const gchar *pattern, GError **error);
+LI_API void li_regex_acquire(liRegex *regex);
+LI_API void li_regex_release(liRegex *regex);
+
+LI_API const gchar* li_regex_get_pattern(liRegex *regex);
+LI_API liRegexEngine li_regex_get_engine(liRegex *regex);
+
+/* match may be NULL; it is only set for a successful match (free with li_regex_match_free).
+ * a failed match (like exceeding the match limit) returns FALSE too and sets error (may be NULL) */
+LI_API gboolean li_regex_match(liRegex *regex, const gchar *string, liRegexMatch **match, GError **error);
+
+LI_API void li_regex_match_free(liRegexMatch *match);
+LI_API const gchar* li_regex_match_get_string(liRegexMatch *match);
+/* returns FALSE if the regex has no group n or it didn't take part in the match */
+LI_API gboolean li_regex_match_fetch_pos(liRegexMatch *match, guint n, gint *start_pos, gint *end_pos);
+
+#endif
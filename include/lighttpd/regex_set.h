@@ -0,0 +1,34 @@
+#ifndef _LIGHTTPD_REGEX_SET_H_
+#define _LIGHTTPD_REGEX_SET_H_
+
+#include <lighttpd/settings.h>
+#include <lighttpd/regex.h>
+
+/* liRegexSet: find the first matching regex of a list (same result as trying li_regex_match on each in order)
+ *
+ * for each regex a literal string every match has to contain is extracted from the pattern (a prefix if the
+ * pattern starts with '^'); all literals go into one Aho-Corasick automaton. one pass over the subject
+ * marks the regexes whose literal was found, only those are matched (in order).
+ * regexes without a usable literal are always tried.
+ */
+
+typedef struct liRegexSet liRegexSet;
+
+LI_API liRegexSet* li_regex_set_new(void);
+LI_API void li_regex_set_free(liRegexSet *set);
+
+/* entries are numbered in order of adding, starting with 0. regex NULL: entry always matches (without
+ * match info). doesn't take a reference, the regex has to stay alive as long as the set */
+LI_API void li_regex_set_add(liRegexSet *set, liRegex *regex);
+/* call after adding all entries, before using li_regex_set_match (the set is read-only afterwards) */
+LI_API void li_regex_set_prepare(liRegexSet *set);
+
+/* returns the index of the first matching entry or -1; match and error (may be NULL) like li_regex_match.
+ * an entry failing with an error doesn't match; error is set for the first one */
+LI_API gint li_regex_set_match(liRegexSet *set, const gchar *string, liRegexMatch **match, GError **error);
+
+/* literal every subject matching pattern contains; anchored: every matching subject starts with it.
+ * returns FALSE if no literal could be found */
+LI_API gboolean li_regex_literal(const gchar *pattern, GString *literal, gboolean *anchored);
+
+#endif
@@ -30,6 +30,7 @@ typedef enum {
 struct liServerSocket {
 	gint refcount;
 	liServer *srv;
+	liWorker *wrk; /** NULL: main worker accepts and hands over to the least loaded worker; otherwise wrk accepts itself (SO_REUSEPORT) */
 	liEventIO watcher;
 
 	liSocketAddress local_addr;
@@ -76,6 +77,7 @@ struct liServer {
 	liEventTimer srv_1sec_timer;
 
 	GPtrArray *sockets;          /** array of (server_socket*) */
+	GPtrArray *reuseport_listen; /** array of (GString*): addresses to listen on with one SO_REUSEPORT socket per worker */
 
 	liModules *modules;
 
@@ -119,8 +121,19 @@ struct liServer {
 	guint keep_alive_queue_timeout;
 
 	gdouble io_timeout;
+	guint io_uring_entries; /* per worker, 0: don't use io_uring */
+	goffset zerocopy_min_size; /* send buffer chunks of at least that size with MSG_ZEROCOPY; 0: disabled */
+	goffset notsent_lowat; /* TCP_NOTSENT_LOWAT for client connections; 0: disabled */
+	goffset buffer_pool_max_free; /* per worker, bytes kept in free buffers for reuse */
 
 	gdouble stat_cache_ttl;
+	gdouble stat_cache_inotify_ttl; /* 0: don't use inotify */
+	guint stat_cache_shared_entries; /* 0: no shared stat cache */
+	liStatCacheShared *stat_cache_shared;
+	guint stat_cache_fd_entries;     /* per worker, 0: no open fd cache */
+	guint stat_cache_header_entries; /* per worker, static.header_cache entries */
+	guint64 content_cache_memory;    /* all workers, 0: no content cache */
+	goffset content_cache_max_file_size;
 	gint tasklet_pool_threads;
 };
 
@@ -130,6 +143,8 @@ LI_API void li_server_free(liServer* srv);
 LI_API void li_server_loop_init(liServer *srv);
 
 LI_API liServerSocket* li_server_listen(liServer *srv, int fd);
+/* only before workers are running: wrk accepts connections on fd in its own loop */
+LI_API liServerSocket* li_server_listen_worker(liServer *srv, liWorker *wrk, int fd);
 
 /* exit asap with cleanup */
 LI_API void li_server_exit(liServer *srv);
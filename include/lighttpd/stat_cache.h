@@ -9,10 +9,28 @@
  *
  * Entries are removed after 10 seconds (adjustable through stat_cache.ttl setup)
  *
+ * On linux the stat cache can use inotify (stat_cache.inotify_ttl setup): before the stat() is queued the parent directory
+ * (or the directory itself for dirlists) gets watched, and the entry is moved to the watch_queue with the longer TTL;
+ * a change while the stat() is running removes the (still waiting) entry, so the result isn't kept.
+ * Any change event for the entry's name in the directory (or any event at all for dirlists, and events for the
+ * directory itself) removes the entry from the cache. If the watch can't be added the entry stays in the delete_queue.
+ * Changes the watch can't see (symlink targets in other directories, renamed parent directories further up)
+ * are only noticed after the inotify TTL.
+ *
+ * Optionally (stat_cache.shared setup) all workers also share a fixed size table with the stat() results of single
+ * entries. Each slot is protected by a seqlock: readers never write to shared memory (no mutex, no atomic
+ * read-modify-write), they copy the slot and retry as miss if a writer was active. Writers (results from the tasklet
+ * pool or synchronous stat()s of the workers) take a mutex; writes only happen on misses.
+ * A hit in the shared table returns the cached struct stat (up to stat_cache.ttl old) without a stat() syscall.
+ * Misses still go through the per-worker cache and its tasklet pool. Calls that need an fd always open() the file.
+ *
+ * The optional open fd cache (stat_cache.fd_cache setup) keeps up to n files per worker open for one TTL;
+ * li_stat_cache_get_chunkfile validates a cached fd with the (cached) stat() result (inode, size, mtime, ctime)
+ * and shares the liChunkFile between concurrent requests. inotify events drop cached fds too.
+ *
  * TODO:
  *     - create ETAGs
  *     - get content type from xattr
- *     - add support for inotify (linux). TTL for entries can be increased to 60s
  *
  * Technical details:
  * If a stat is requested, the following procedure takes place:
@@ -65,8 +83,34 @@ struct liStatCacheEntry {
 	liStatCache *sc;
 	GPtrArray *vrequests;             /* vrequests waiting for this info */
 	guint refcount;                   /* vrequests, delete_queue and tasklet hold references; dirlist/entrie cache entries are always in delete_queue too */
-	liWaitQueueElem queue_elem;       /* queue element for the delete_queue */
+	liWaitQueueElem queue_elem;       /* queue element for the delete_queue (or watch_queue if watch != NULL) */
 	gboolean cached;
+
+	liStatCacheWatch *watch;          /* inotify watch (on the parent directory for STAT_CACHE_ENTRY_SINGLE) */
+	GList watch_link;                 /* link in watch->entries */
+	gchar *watch_name;                /* name in the watched directory, NULL for STAT_CACHE_ENTRY_DIR (matches all events) */
+};
+
+/* paths longer than this are not stored in the shared table */
+#define LI_STAT_CACHE_SHARED_PATH_MAX 256
+
+typedef struct liStatCacheSharedSlot liStatCacheSharedSlot;
+struct liStatCacheSharedSlot {
+	volatile gint seq;                /* odd while a writer is active */
+	guint hash;
+	guint path_len;                   /* 0: empty slot */
+	gboolean failed;
+	int err;
+	li_tstamp ts;
+	struct stat st;
+	gchar path[LI_STAT_CACHE_SHARED_PATH_MAX];
+};
+
+struct liStatCacheShared {
+	liStatCacheSharedSlot *slots;
+	guint mask;                       /* number of slots - 1 */
+	gdouble ttl;
+	GMutex *write_lock;
 };
 
 struct liStatCache {
@@ -75,13 +119,47 @@ struct liStatCache {
 	liWaitQueue delete_queue;
 	gdouble ttl;
 
+	/* inotify; inotify_fd is -1 if disabled or not supported */
+	int inotify_fd;
+	liEventIO inotify_watcher;
+	GHashTable *watches;              /* (int) wd => liStatCacheWatch* */
+	liWaitQueue watch_queue;          /* entries with a watch; uses inotify_ttl */
+
 	guint64 hits;
 	guint64 misses;
 	guint64 errors;
+	guint64 invalidations;            /* entries removed because of an inotify event */
+
+	liStatCacheShared *shared;        /* srv->stat_cache_shared, may be NULL */
+	guint64 shared_hits;
+	guint64 shared_misses;
+
+	/* open fd cache; files is NULL if disabled */
+	GHashTable *files;                /* GString* path => stat_cache_file* */
+	liWaitQueue file_queue;
+	guint files_max;
+	guint64 file_hits;
+	guint64 file_misses;
+
+	/* precomputed ETag/Last-Modified values (static.header_cache option) */
+	GHashTable *headers;              /* GString* path => stat_cache_headers* */
+	liWaitQueue headers_queue;        /* least recently used first */
+	guint headers_max;
 };
 
-LI_API liStatCache* li_stat_cache_new(liWorker *wrk, gdouble ttl);
+/* inotify_ttl: TTL for entries watched with inotify, 0 disables inotify */
+LI_API liStatCache* li_stat_cache_new(liWorker *wrk, gdouble ttl, gdouble inotify_ttl);
 LI_API void li_stat_cache_free(liStatCache *sc);
+/* stop timers and the inotify watcher (worker stop) */
+LI_API void li_stat_cache_stop(liStatCache *sc);
+
+/* entries is rounded up to a power of 2; slots are grouped into sets of 4 (least recently written slot gets replaced) */
+LI_API liStatCacheShared* li_stat_cache_shared_new(guint entries, gdouble ttl);
+LI_API void li_stat_cache_shared_free(liStatCacheShared *shared);
+/* lock-free; returns TRUE if a valid entry (not older than ttl) was found and copies the result */
+LI_API gboolean li_stat_cache_shared_lookup(liStatCacheShared *shared, GString *path, li_tstamp now, struct stat *st, int *err, gboolean *failed);
+LI_API void li_stat_cache_shared_insert(liStatCacheShared *shared, GString *path, li_tstamp now, const struct stat *st, int err, gboolean failed);
+LI_API void li_stat_cache_shared_remove(liStatCacheShared *shared, GString *path);
 
 /*
  gets a stat_cache_entry for a specified path
@@ -90,6 +168,21 @@ LI_API void li_stat_cache_free(liStatCache *sc);
 */
 LI_API liHandlerResult li_stat_cache_get(liVRequest *vr, GString *path, struct stat *st, int *err, int *fd);
 
+/*
+ like li_stat_cache_get with fd, but returns a (new) reference to a liChunkFile, which may come from the open fd cache
+ (shared with other requests; don't change the file position, use pread/sendfile with offsets)
+ *cf is always set on HANDLER_GO_ON for regular files, but may be NULL for other types (if the fd cache is enabled)
+*/
+LI_API liHandlerResult li_stat_cache_get_chunkfile(liVRequest *vr, GString *path, struct stat *st, int *err, liChunkFile **cf);
+
+/*
+ ETag (with the current etag.use flags) and Last-Modified values for path with stat info st, formatted once per file
+ (stat_cache.header_cache entries per worker, dropped after one stat cache TTL without use or if the cache is full)
+ returns FALSE if the stat cache is disabled; *etag/*last_modified may be NULL (no ETag / no Last-Modified)
+ the strings belong to the cache and stay valid until the worker returns to the event loop
+*/
+LI_API gboolean li_stat_cache_get_headers(liVRequest *vr, GString *path, struct stat *st, GString **etag, GString **last_modified);
+
 /* doesn't return HANDLER_WAIT_FOR_EVENT, blocks instead of async lookup */
 LI_API liHandlerResult li_stat_cache_get_sync(liVRequest *vr, GString *path, struct stat *st, int *err, int *fd);
 
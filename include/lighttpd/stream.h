@@ -40,6 +40,12 @@ LI_API void li_stream_notify_later(liStream *stream);
 LI_API void li_stream_again(liStream *stream); /* more data to be generated in stream with event NEW_DATA or more data to be read from stream->source->cq */
 LI_API void li_stream_again_later(liStream *stream);
 
+/* reads file data with li_chunkiter_read_async() in the tasklet pool instead of blocking the loop; returns
+ * HANDLER_WAIT_FOR_EVENT while loading, stream gets NEW_DATA again when the data is ready.
+ * pool must run in stream->loop; falls back to li_chunkiter_read() if pool is NULL or the stream is detached.
+ */
+LI_API liHandlerResult li_stream_chunkiter_read(liStream *stream, liTaskletPool *pool, liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err);
+
 /* detach from jobqueue, stops all event handling. you have to detach all connected streams to move streams between threads */
 LI_API void li_stream_detach(liStream *stream);
 LI_API void li_stream_attach(liStream *stream, liEventLoop *loop); /* attach to another loop - possibly after switching threads */
@@ -72,6 +78,8 @@ struct liIOStream {
 	guint in_closed:1, out_closed:1;
 	guint can_read:1, can_write:1; /* set to FALSE if you got EAGAIN */
 	guint throttled_in:1, throttled_out:1;
+	guint use_uring:1;     /* stream never moves to another worker; writes may go through the worker io_uring */
+	guint write_pending:1; /* async write in flight; neither write nor wait for LI_EV_WRITE until it completed */
 
 	/* throttle needs to be handled by the liIOStreamCB cb */
 	liThrottleState *throttle_in;
@@ -80,6 +88,12 @@ struct liIOStream {
 	liIOStreamCB cb;
 
 	gpointer data; /* data for the callback */
+
+	liUringOp *write_op; /* see stream_simple_socket.c */
+	liNetworkZeroCopy *zerocopy; /* MSG_ZEROCOPY state of the socket (NULL: disabled) */
+	liChunkPipe *splice_in; /* read with splice() into this pipe (NULL: read into buffers) */
+	goffset notsent_lowat; /* TCP_NOTSENT_LOWAT of the socket (0: not set), limits the unsent data per write */
+	liNetworkReadState read_state;
 };
 
 LI_API const gchar* li_iostream_event_string(liIOStreamEvent event);
@@ -91,6 +105,12 @@ INLINE void li_iostream_safe_release(liIOStream** piostream);
 
 LI_API int li_iostream_reset(liIOStream *iostream); /* returns fd, disconnects everything, stop callbacks, releases one reference */
 
+/* read the data of stream_in with splice() into a pipe (PIPE_CHUNKs) from now on; the consumers
+ * must be able to handle PIPE_CHUNKs (usually only the network write backends can).
+ * returns FALSE if splice() is not supported
+ */
+LI_API gboolean li_iostream_splice_in(liIOStream *iostream);
+
 /* unset throttle_out and throttle_in */
 LI_API void li_iostream_throttle_clear(liIOStream *iostream);
 
@@ -102,6 +122,8 @@ LI_API void li_iostream_attach(liIOStream *iostream, liWorker *wrk);
 LI_API void li_stream_simple_socket_close(liIOStream *stream, gboolean aborted);
 LI_API void li_stream_simple_socket_io_cb(liIOStream *stream, liIOStreamEvent event);
 LI_API void li_stream_simple_socket_io_cb_with_context(liIOStream *stream, liIOStreamEvent event, gpointer *data);
+/* releases the read buffer in the context (back into the worker buffer pool) if nothing else references it */
+LI_API void li_stream_simple_socket_release_buffer(gpointer *data);
 /* tries to flush TCP sockets by disabling nagle */
 LI_API void li_stream_simple_socket_flush(liIOStream *stream);
 
@@ -5,4 +5,8 @@
 
 LI_API liStream* li_stream_http_response_handle(liStream *http_in, liVRequest *vr, gboolean accept_cgi, gboolean accept_nph, gboolean keepalive);
 
+/* http_in of the response stream is backend->stream_in: the body may be read with splice() (see option backend.splice)
+ * if it isn't chunked and goes directly to a plain connection socket */
+LI_API void li_stream_http_response_allow_splice(liStream *stream, liIOStream *backend);
+
 #endif
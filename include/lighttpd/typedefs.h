@@ -39,7 +39,8 @@ typedef enum {
 	LI_ACTION_TFUNCTION,
 	LI_ACTION_TCONDITION,
 	LI_ACTION_TLIST,
-	LI_ACTION_TBALANCER
+	LI_ACTION_TBALANCER,
+	LI_ACTION_TSWITCH
 } liActionType;
 
 typedef enum {
@@ -55,6 +56,10 @@ typedef struct liLuaState liLuaState;
 
 typedef struct liChunkFile liChunkFile;
 
+typedef struct liChunkPipe liChunkPipe;
+
+typedef struct liChunkAsyncRead liChunkAsyncRead;
+
 typedef struct liChunk liChunk;
 
 typedef struct liCQLimit liCQLimit;
@@ -77,6 +82,10 @@ typedef struct liConditionLValue liConditionLValue;
 
 typedef struct liCondition liCondition;
 
+typedef struct liConditionSwitch liConditionSwitch;
+
+typedef struct liConditionCache liConditionCache;
+
 /* connection.h */
 
 typedef struct liConnection liConnection;
@@ -133,9 +142,13 @@ typedef enum {
 	LI_NETWORK_STATUS_SUCCESS,             /**< socket probably could have done more */
 	LI_NETWORK_STATUS_FATAL_ERROR,
 	LI_NETWORK_STATUS_CONNECTION_CLOSE,
-	LI_NETWORK_STATUS_WAIT_FOR_EVENT       /**< read/write returned -1 with errno=EAGAIN/EWOULDBLOCK */
+	LI_NETWORK_STATUS_WAIT_FOR_EVENT       /**< read/write returned -1 with errno=EAGAIN/EWOULDBLOCK, or a short read/write */
 } liNetworkStatus;
 
+typedef struct liNetworkZeroCopy liNetworkZeroCopy;
+
+typedef struct liNetworkReadState liNetworkReadState;
+
 /* options.h */
 
 typedef union liOptionValue liOptionValue;
@@ -264,5 +277,10 @@ typedef struct liWorker liWorker;
 typedef struct liStatCacheEntryData liStatCacheEntryData;
 typedef struct liStatCacheEntry liStatCacheEntry;
 typedef struct liStatCache liStatCache;
+typedef struct liStatCacheWatch liStatCacheWatch;
+typedef struct liStatCacheShared liStatCacheShared;
+
+typedef struct liContentCacheEntry liContentCacheEntry;
+typedef struct liContentCache liContentCache;
 
 #endif
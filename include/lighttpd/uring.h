@@ -0,0 +1,52 @@
+#ifndef _LIGHTTPD_URING_H_
+#define _LIGHTTPD_URING_H_
+
+#ifndef _LIGHTTPD_BASE_H_
+#error Please include <lighttpd/base.h> instead of this file
+#endif
+
+#include <lighttpd/events.h>
+
+#include <sys/uio.h>
+
+/* per worker io_uring (linux, needs liburing)
+ *
+ * operations are queued while the event loop handles events and jobs; all queued operations are
+ * submitted with a single io_uring_enter() right before the loop blocks again (low priority
+ * prepare watcher, runs after the jobqueue). completions are reaped in an io watcher on the ring fd.
+ */
+
+#define LI_URING_DEFAULT_ENTRIES 256
+#define LI_URING_IOV_MAX 64
+
+typedef struct liUring liUring;
+typedef struct liUringOp liUringOp;
+
+/* res: syscall result, negative errno on failure */
+typedef void (*liUringCB)(liUringOp *op, int res);
+
+struct liUringOp {
+	liUringCB callback; /* called exactly once for each queued operation */
+	guint in_flight:1;
+	guint cancelled:1;
+
+	/* iovecs have to stay valid until the operation completed */
+	struct iovec iov[LI_URING_IOV_MAX];
+	guint iovcnt;
+};
+
+/* returns NULL and sets err if io_uring is not available (not compiled in, kernel too old, ...)
+ * the ring is bound to the loop (thread) it was created in */
+LI_API liUring* li_uring_new(liEventLoop *loop, guint entries, GError **err);
+/* waits for all operations still in flight (calling their callbacks) */
+LI_API void li_uring_free(liUring *uring);
+
+/* queues writev(fd, op->iov, op->iovcnt); returns FALSE if the ring is full (use the synchronous path instead) */
+LI_API gboolean li_uring_writev(liUring *uring, liUringOp *op, int fd);
+
+/* tries to cancel an operation in flight; the callback still gets called (-ECANCELED if the cancel was successful).
+ * submits everything queued right away, so the fd of the operation can be closed afterwards (the kernel keeps
+ * the file open until the operation completed). only the first cancel of a queued operation does anything. */
+LI_API void li_uring_cancel(liUring *uring, liUringOp *op);
+
+#endif
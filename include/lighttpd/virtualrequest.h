@@ -51,6 +51,7 @@ struct liConInfo {
 	liSocketAddress remote_addr, local_addr;
 	GString *remote_addr_str, *local_addr_str;
 	gboolean is_ssl;
+	gboolean splice_out; /* resp is written to a plain socket: PIPE_CHUNKs can be sent with splice() */
 	gboolean keep_alive;
 	gboolean aborted; /* network aborted connection before response was sent completely */
 
@@ -107,6 +108,7 @@ struct liVRequest {
 	liChunkQueue *direct_out; /* NULL for indirect responses, backend_source->out for direct responses. do not set this yourself for indirect responses! */
 
 	liActionStack action_stack;
+	liConditionCache condition_cache;
 
 	liJob job;
 
@@ -10,6 +10,10 @@
 
 struct lua_State;
 
+#define LI_ACCEPT_BATCH 64 /* max. connections accepted per event on a listening socket */
+#define LI_ACTIONS_TIMING_SAMPLE 16 /* only every n-th li_action_execute call gets timed */
+#define LI_ACCEPT_LATENCY_BUCKETS 5 /* < 0.1ms, < 1ms, < 10ms, < 100ms, more */
+
 typedef struct liStatistics liStatistics;
 struct liStatistics {
 	guint64 bytes_out;        /** bytes transfered, outgoing */
@@ -19,6 +23,8 @@ struct liStatistics {
 	guint64 active_cons_cum;  /** cummulative value of active connections, updated once a second */
 
 	guint64 actions_executed; /** actions executed */
+	guint64 actions_ns;       /** time spent in li_action_execute (nanoseconds, estimated from every LI_ACTIONS_TIMING_SAMPLE-th call) */
+	guint64 read_syscalls;    /** read syscalls on sockets */
 
 	/* 5 seconds frame avg */
 	guint64 requests_5s;
@@ -42,6 +48,19 @@ struct liStatistics {
 	guint64 last_requests;
 	double requests_per_sec;
 	li_tstamp last_update;
+
+	/* new connections (li_worker_new_cons) */
+	guint64 accepted;         /** connections started */
+	guint64 accept_handoffs;  /** batches of new connections received */
+	guint64 accept_latency[LI_ACCEPT_LATENCY_BUCKETS]; /** connections by time from accept() to start */
+};
+
+typedef struct liWorkerNewCon liWorkerNewCon;
+struct liWorkerNewCon {
+	liSockAddr remote_addr;
+	socklen_t remote_addr_len;
+	int s;
+	liServerSocket *srv_sock; /* passes a reference */
 };
 
 typedef struct liWorkerTS liWorkerTS;
@@ -60,7 +79,7 @@ struct liWorker {
 
 	liEventLoop loop;
 	liEventPrepare loop_prepare;
-	liEventAsync worker_stop_watcher, worker_stopping_watcher, worker_suspend_watcher, worker_exit_watcher;
+	liEventAsync worker_stop_watcher, worker_stopping_watcher, worker_suspend_watcher, worker_exit_watcher, worker_listen_watcher;
 
 	liLogWorkerData logs;
 
@@ -83,6 +102,11 @@ struct liWorker {
 
 	guint connection_load;    /** incremented by server_accept_cb, decremented by worker_con_put. use atomic access */
 
+	/* sockets this worker accepts on itself (SO_REUSEPORT), see li_server_listen_worker */
+	GPtrArray *listen_sockets;   /** array of (liServerSocket*), references owned by srv->sockets */
+	gint listen_active;          /** whether the server wants listen_sockets to be active; atomic access */
+	gboolean listen_limit_hit;   /** stopped listen_sockets because of the connection limit */
+
 	GArray *timestamps_gmt; /** array of (worker_ts), use only from local worker context and through li_worker_current_timestamp(wrk, LI_GMTIME, ndx) */
 	GArray *timestamps_local;
 
@@ -95,6 +119,7 @@ struct liWorker {
 
 	liEventTimer stats_watcher;
 	liStatistics stats;
+	guint actions_timing;      /** li_action_execute calls since the last timed one */
 
 	/* collect framework */
 	liEventAsync collect_watcher;
@@ -103,8 +128,10 @@ struct liWorker {
 	liTaskletPool *tasklets;
 
 	liStatCache *stat_cache;
+	liContentCache *content_cache;
 
-	liBuffer *network_read_buf; /** available buffer - steal it if you need it, can be NULL. refcount must be 1, no other references. */
+	liBufferPool *buffer_pool; /** read buffers; created in li_worker_run (owned by the worker thread) */
+	liUring *uring;            /** NULL if io_uring is disabled or not available */
 };
 
 LI_API liWorker* li_worker_new(liServer *srv, struct ev_loop *loop);
@@ -121,7 +148,15 @@ LI_API void li_worker_stopping(liWorker *context, liWorker *wrk);
 LI_API void li_worker_suspend(liWorker *context, liWorker *wrk);
 LI_API void li_worker_exit(liWorker *context, liWorker *wrk);
 
-LI_API void li_worker_new_con(liWorker *ctx, liWorker *wrk, liSocketAddress remote_addr, int s, liServerSocket *srv_sock);
+/* start/stop accepting on the sockets owned by the worker (SO_REUSEPORT) */
+LI_API void li_worker_listen(liWorker *context, liWorker *wrk, gboolean active);
+/* worker context only: stop accepting until the server connection load is below 7/8 of the limit */
+LI_API void li_worker_listen_limit_hit(liWorker *wrk);
+
+/* start count accepted connections in wrk; from another worker (ctx) they are handed over as one batch with a single wakeup.
+ * ts_accepted: li_event_monotonic_time() after accepting them
+ */
+LI_API void li_worker_new_cons(liWorker *ctx, liWorker *wrk, const liWorkerNewCon *cons, guint count, li_tstamp ts_accepted);
 
 LI_API void li_worker_check_keepalive(liWorker *wrk);
 
@@ -129,6 +164,8 @@ LI_API GString* li_worker_current_timestamp(liWorker *wrk, liTimeFunc, guint for
 
 /* shutdown write and wait for eof before shutdown read and close */
 LI_API void li_worker_add_closing_socket(liWorker *wrk, int fd);
+/* cb: see li_event_add_closing_socket_cb */
+LI_API void li_worker_add_closing_socket_cb(liWorker *wrk, int fd, liEventClosingSocketCB cb, gpointer data);
 
 /* internal function to recycle connection */
 LI_API void li_worker_con_put(liConnection *con);
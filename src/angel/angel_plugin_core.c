@@ -21,6 +21,9 @@ struct listen_socket {
 
 	liSocketAddress addr;
 	int fd;
+
+	/* SO_REUSEPORT group (one socket per worker, int), NULL for normal sockets; fd is -1 then */
+	GArray *reuseport_fds;
 };
 
 struct listen_ref_resource {
@@ -512,7 +515,14 @@ static void _listen_socket_free(gpointer ptr) {
 	listen_socket *sock = ptr;
 
 	li_sockaddr_clear(&sock->addr);
-	close(sock->fd);
+	if (-1 != sock->fd) close(sock->fd);
+	if (NULL != sock->reuseport_fds) {
+		guint i;
+		for (i = 0; i < sock->reuseport_fds->len; i++) {
+			close(g_array_index(sock->reuseport_fds, int, i));
+		}
+		g_array_free(sock->reuseport_fds, TRUE);
+	}
 
 	g_slice_free(listen_socket, sock);
 }
@@ -605,7 +615,22 @@ static gboolean listen_check_acl(liServer *srv, liPluginCoreConfig *config, liSo
 	return FALSE;
 }
 
-static int do_listen(liServer *srv, liSocketAddress *addr, GString *str) {
+static gboolean listen_set_reuseport(liServer *srv, int s) {
+#ifdef SO_REUSEPORT
+	int v = 1;
+	if (-1 == setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &v, sizeof(v))) {
+		ERROR(srv, "Couldn't setsockopt(SO_REUSEPORT): %s", g_strerror(errno));
+		return FALSE;
+	}
+	return TRUE;
+#else
+	UNUSED(s);
+	ERROR(srv, "%s", "SO_REUSEPORT not supported on this platform");
+	return FALSE;
+#endif
+}
+
+static int do_listen(liServer *srv, liSocketAddress *addr, GString *str, gboolean reuseport) {
 	int s, v;
 	GString *ipv6_str;
 
@@ -621,6 +646,10 @@ static int do_listen(liServer *srv, liSocketAddress *addr, GString *str) {
 			ERROR(srv, "Couldn't setsockopt(SO_REUSEADDR): %s", g_strerror(errno));
 			return -1;
 		}
+		if (reuseport && !listen_set_reuseport(srv, s)) {
+			close(s);
+			return -1;
+		}
 		if (-1 == bind(s, &addr->addr->plain, addr->len)) {
 			close(s);
 			ERROR(srv, "Couldn't bind socket to '%s': %s", str->str, g_strerror(errno));
@@ -660,6 +689,11 @@ static int do_listen(liServer *srv, liSocketAddress *addr, GString *str) {
 			g_string_free(ipv6_str, TRUE);
 			return -1;
 		}
+		if (reuseport && !listen_set_reuseport(srv, s)) {
+			close(s);
+			g_string_free(ipv6_str, TRUE);
+			return -1;
+		}
 		if (-1 == bind(s, &addr->addr->plain, addr->len)) {
 			close(s);
 			ERROR(srv, "Couldn't bind socket to '%s': %s", ipv6_str->str, g_strerror(errno));
@@ -682,6 +716,10 @@ static int do_listen(liServer *srv, liSocketAddress *addr, GString *str) {
 #endif
 #ifdef HAVE_SYS_UN_H
 	case AF_UNIX:
+		if (reuseport) {
+			ERROR(srv, "SO_REUSEPORT not supported for unix socket '%s'", str->str);
+			return -1;
+		}
 		if (-1 == unlink(addr->addr->un.sun_path)) {
 			switch (errno) {
 			case ENOENT:
@@ -749,8 +787,19 @@ static void core_listen(liServer *srv, liPlugin *p, liInstance *i, gint32 id, GS
 		return;
 	}
 
-	if (NULL == (sock = g_hash_table_lookup(config->listen_sockets, &addr))) {
-		fd = do_listen(srv, &addr, data);
+	if (NULL != (sock = g_hash_table_lookup(config->listen_sockets, &addr)) && NULL != sock->reuseport_fds) {
+		GString *error = g_string_sized_new(0);
+		li_sockaddr_clear(&addr);
+		g_string_printf(error, "Already listening on '%s' with SO_REUSEPORT", data->str);
+		if (!li_angel_send_result(i->acon, id, error, NULL, NULL, &err)) {
+			ERROR(srv, "Couldn't send result: %s", err->message);
+			g_error_free(err);
+		}
+		return;
+	}
+
+	if (NULL == sock) {
+		fd = do_listen(srv, &addr, data, FALSE);
 
 		if (-1 == fd) {
 			GString *error = g_string_sized_new(0);
@@ -795,6 +844,110 @@ static void core_listen(liServer *srv, liPlugin *p, liInstance *i, gint32 id, GS
 	}
 }
 
+/* data: "<count> <socket-address>"; returns <count> sockets bound to the same address with SO_REUSEPORT */
+static void core_listen_reuseport(liServer *srv, liPlugin *p, liInstance *i, gint32 id, GString *data) {
+	GError *err = NULL;
+	GArray *fds;
+	liPluginCoreConfig *config = (liPluginCoreConfig*) p->data;
+	liSocketAddress addr;
+	listen_socket *sock;
+	GString *addrstr, *error;
+	gchar *endptr;
+	guint64 count;
+	guint n;
+
+	if (-1 == id) return; /* ignore simple calls */
+
+	count = g_ascii_strtoull(data->str, &endptr, 10);
+	if (endptr == data->str || ' ' != *endptr || 0 == count || count > 1024) {
+		error = g_string_sized_new(0);
+		g_string_printf(error, "Invalid listen-reuseport request: '%s'", data->str);
+		goto send_error;
+	}
+	addrstr = g_string_new(endptr + 1);
+
+	addr = li_sockaddr_from_string(addrstr, 80);
+	if (!addr.addr) {
+		error = g_string_sized_new(0);
+		g_string_printf(error, "Invalid socket address: '%s'", addrstr->str);
+		g_string_free(addrstr, TRUE);
+		goto send_error;
+	}
+
+	if (!listen_check_acl(srv, config, &addr)) {
+		error = g_string_sized_new(0);
+		li_sockaddr_clear(&addr);
+		g_string_printf(error, "Socket address not allowed: '%s'", addrstr->str);
+		g_string_free(addrstr, TRUE);
+		goto send_error;
+	}
+
+	if (NULL == (sock = g_hash_table_lookup(config->listen_sockets, &addr))) {
+		sock = listen_new_socket(&addr, -1);
+		sock->reuseport_fds = g_array_sized_new(FALSE, FALSE, sizeof(int), count);
+
+		for (n = 0; n < count; n++) {
+			int fd = do_listen(srv, &sock->addr, addrstr, TRUE);
+
+			if (-1 == fd) {
+				_listen_socket_free(sock);
+				error = g_string_sized_new(0);
+				g_string_printf(error, "Couldn't listen to '%s'", addrstr->str);
+				g_string_free(addrstr, TRUE);
+				goto send_error;
+			}
+
+			li_fd_init(fd);
+			g_array_append_val(sock->reuseport_fds, fd);
+		}
+
+		g_hash_table_insert(config->listen_sockets, &sock->addr, sock);
+	} else {
+		li_sockaddr_clear(&addr);
+
+		/* the kernel balances over all sockets in the group; handing out only some of them would lose connections */
+		if (NULL == sock->reuseport_fds || sock->reuseport_fds->len != count) {
+			error = g_string_sized_new(0);
+			g_string_printf(error, "Already listening on '%s' with a different socket count, restart required", addrstr->str);
+			g_string_free(addrstr, TRUE);
+			goto send_error;
+		}
+	}
+
+	g_string_free(addrstr, TRUE);
+
+	listen_socket_add(i, p, sock);
+
+	fds = g_array_sized_new(FALSE, FALSE, sizeof(int), count);
+	for (n = 0; n < sock->reuseport_fds->len; n++) {
+		int fd = dup(g_array_index(sock->reuseport_fds, int, n));
+
+		if (-1 == fd) {
+			/* socket ref will be released when instance is released */
+			guint k;
+			for (k = 0; k < fds->len; k++) close(g_array_index(fds, int, k));
+			g_array_free(fds, TRUE);
+			error = g_string_sized_new(0);
+			g_string_printf(error, "Couldn't duplicate fd");
+			goto send_error;
+		}
+
+		g_array_append_val(fds, fd);
+	}
+
+	if (!li_angel_send_result(i->acon, id, NULL, NULL, fds, &err)) {
+		ERROR(srv, "Couldn't send result: %s", err->message);
+		g_error_free(err);
+	}
+	return;
+
+send_error:
+	if (!li_angel_send_result(i->acon, id, error, NULL, NULL, &err)) {
+		ERROR(srv, "Couldn't send result: %s", err->message);
+		g_error_free(err);
+	}
+}
+
 static void core_reached_state(liServer *srv, liPlugin *p, liInstance *i, gint32 id, GString *data) {
 	UNUSED(srv);
 	UNUSED(p);
@@ -975,6 +1128,7 @@ static gboolean core_init(liServer *srv, liPlugin *p) {
 	config->listen_masks = g_ptr_array_new();
 
 	li_angel_plugin_add_angel_cb(p, "listen", core_listen);
+	li_angel_plugin_add_angel_cb(p, "listen-reuseport", core_listen_reuseport);
 	li_angel_plugin_add_angel_cb(p, "reached-state", core_reached_state);
 	li_angel_plugin_add_angel_cb(p, "log-open-file", core_log_open_file);
 
@@ -0,0 +1,102 @@
+
+#include <lighttpd/arena.h>
+
+#include <string.h>
+
+#define ARENA_ALIGN (2 * sizeof(gpointer))
+#define ARENA_ALIGN_SIZE(size) (((size) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+struct liArenaBlock {
+	liArenaBlock *next;
+	gsize size, used;
+};
+
+/* data starts after the (aligned) block header */
+#define ARENA_BLOCK_DATA(block) (((gchar*) (block)) + ARENA_ALIGN_SIZE(sizeof(liArenaBlock)))
+
+static liArenaBlock* arena_block_new(gsize size) {
+	liArenaBlock *block = g_malloc(ARENA_ALIGN_SIZE(sizeof(liArenaBlock)) + size);
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+liArena* li_arena_new(gsize block_size) {
+	liArena *arena = g_slice_new0(liArena);
+	arena->block_size = ARENA_ALIGN_SIZE(block_size);
+	return arena;
+}
+
+void li_arena_free(liArena *arena) {
+	liArenaBlock *block, *next;
+
+	if (NULL == arena) return;
+
+	for (block = arena->blocks; NULL != block; block = next) {
+		next = block->next;
+		g_free(block);
+	}
+
+	g_slice_free(liArena, arena);
+}
+
+void li_arena_reset(liArena *arena) {
+	liArenaBlock *block, *next, *keep = NULL;
+
+	/* keep one normal sized block, free the others */
+	for (block = arena->blocks; NULL != block; block = next) {
+		next = block->next;
+		if (block->size == arena->block_size) {
+			if (NULL != keep) g_free(keep);
+			keep = block;
+		} else {
+			g_free(block);
+		}
+	}
+
+	if (NULL != keep) {
+		keep->used = 0;
+		keep->next = NULL;
+	}
+	arena->blocks = keep;
+}
+
+gpointer li_arena_alloc(liArena *arena, gsize size) {
+	liArenaBlock *block = arena->blocks;
+	gpointer p;
+
+	size = ARENA_ALIGN_SIZE(size);
+	arena->allocations++;
+
+	if (NULL == block || block->size - block->used < size) {
+		arena->block_allocations++;
+
+		if (size > arena->block_size / 4) {
+			/* big allocations get their own block, behind the current one */
+			liArenaBlock *big = arena_block_new(size);
+			big->used = size;
+			if (NULL == block) {
+				arena->blocks = big;
+			} else {
+				big->next = block->next;
+				block->next = big;
+			}
+			return ARENA_BLOCK_DATA(big);
+		}
+
+		block = arena_block_new(arena->block_size);
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+
+	p = ARENA_BLOCK_DATA(block) + block->used;
+	block->used += size;
+	return p;
+}
+
+gpointer li_arena_alloc0(liArena *arena, gsize size) {
+	gpointer p = li_arena_alloc(arena, size);
+	memset(p, 0, size);
+	return p;
+}
@@ -16,9 +16,28 @@ static void _buffer_init_slice(liBuffer *buf, gsize alloc_size) {
 	buf->addr = g_slice_alloc(alloc_size);
 }
 
+static const gsize buffer_pool_sizes[LI_BUFFER_POOL_CLASSES] = { 4*1024, 16*1024, 64*1024 };
+
+static void _buffer_pool_release(liBufferPool *pool) {
+	guint i;
+
+	LI_FORCE_ASSERT(g_atomic_int_get(&pool->refcount) > 0);
+	if (!g_atomic_int_dec_and_test(&pool->refcount)) return;
+
+	for (i = 0; i < LI_BUFFER_POOL_CLASSES; i++) {
+		g_ptr_array_free(pool->free[i], TRUE);
+	}
+	g_slice_free(liBufferPool, pool);
+}
+
 static void _buffer_destroy(liBuffer *buf) {
+	liBufferPool *pool;
+
 	if (!buf || NULL == buf->addr) return;
 
+	pool = buf->pool;
+	buf->pool = NULL;
+
 	if (NULL == buf->mptr.data) {
 		g_slice_free1(buf->alloc_size, buf->addr);
 	} else {
@@ -29,6 +48,32 @@ static void _buffer_destroy(liBuffer *buf) {
 	}
 
 	g_slice_free(liBuffer, buf);
+
+	if (NULL != pool) _buffer_pool_release(pool);
+}
+
+static guint _buffer_pool_class(gsize size) {
+	guint i;
+	for (i = 0; i < LI_BUFFER_POOL_CLASSES && buffer_pool_sizes[i] < size; i++) ;
+	return i;
+}
+
+/* returns FALSE if the buffer can't be put back (other thread or pool already freed) */
+static gboolean _buffer_pool_put(liBufferPool *pool, liBuffer *buf) {
+	guint cls;
+
+	if (pool->owner != g_thread_self()) return FALSE;
+
+	/* alloc_size is page aligned and might be bigger than the class size */
+	for (cls = LI_BUFFER_POOL_CLASSES; cls > 0 && buf->alloc_size < buffer_pool_sizes[cls-1]; cls--) ;
+	if (0 == cls) return FALSE;
+
+	if (pool->free_size + buf->alloc_size > pool->max_free) return FALSE;
+	pool->free_size += buf->alloc_size;
+
+	buf->used = 0;
+	g_ptr_array_add(pool->free[cls-1], buf);
+	return TRUE;
 }
 
 
@@ -50,6 +95,7 @@ void li_buffer_release(liBuffer *buf) {
 	if (!buf) return;
 	LI_FORCE_ASSERT(g_atomic_int_get(&buf->refcount) > 0);
 	if (g_atomic_int_dec_and_test(&buf->refcount)) {
+		if (NULL != buf->pool && _buffer_pool_put(buf->pool, buf)) return;
 		_buffer_destroy(buf);
 	}
 }
@@ -58,3 +104,83 @@ void li_buffer_acquire(liBuffer *buf) {
 	LI_FORCE_ASSERT(g_atomic_int_get(&buf->refcount) > 0);
 	g_atomic_int_inc(&buf->refcount);
 }
+
+liBufferPool* li_buffer_pool_new(gsize max_free) {
+	liBufferPool *pool = g_slice_new0(liBufferPool);
+	guint i;
+
+	pool->refcount = 1;
+	pool->owner = g_thread_self();
+	pool->max_free = max_free;
+	for (i = 0; i < LI_BUFFER_POOL_CLASSES; i++) {
+		pool->free[i] = g_ptr_array_new();
+	}
+
+	return pool;
+}
+
+void li_buffer_pool_free(liBufferPool *pool) {
+	guint i;
+
+	if (NULL == pool) return;
+
+	pool->owner = NULL;
+	for (i = 0; i < LI_BUFFER_POOL_CLASSES; i++) {
+		GPtrArray *a = pool->free[i];
+		while (a->len > 0) {
+			_buffer_destroy(g_ptr_array_remove_index_fast(a, a->len - 1));
+		}
+	}
+	pool->free_size = 0;
+
+	_buffer_pool_release(pool);
+}
+
+liBuffer* li_buffer_pool_get(liBufferPool *pool, gsize size) {
+	liBuffer *buf;
+	GPtrArray *a;
+	guint cls;
+
+	if (NULL == pool || (cls = _buffer_pool_class(size)) >= LI_BUFFER_POOL_CLASSES) {
+		return li_buffer_new(size);
+	}
+
+	a = pool->free[cls];
+	if (a->len > 0) {
+		buf = g_ptr_array_remove_index_fast(a, a->len - 1);
+		if (a->len < pool->low_water[cls]) pool->low_water[cls] = a->len;
+		pool->free_size -= buf->alloc_size;
+		buf->refcount = 1;
+		pool->hits++;
+		return buf;
+	}
+
+	pool->low_water[cls] = 0;
+	pool->misses++;
+
+	buf = li_buffer_new(buffer_pool_sizes[cls]);
+	buf->pool = pool;
+	g_atomic_int_inc(&pool->refcount);
+	return buf;
+}
+
+void li_buffer_pool_trim(liBufferPool *pool) {
+	guint i;
+
+	if (NULL == pool) return;
+
+	for (i = 0; i < LI_BUFFER_POOL_CLASSES; i++) {
+		GPtrArray *a = pool->free[i];
+		guint j, unused = MIN(pool->low_water[i], a->len);
+
+		/* the oldest buffers weren't needed since the last trim */
+		for (j = 0; j < unused; j++) {
+			liBuffer *buf = g_ptr_array_index(a, j);
+			pool->free_size -= buf->alloc_size;
+			_buffer_destroy(buf);
+		}
+		if (unused > 0) g_ptr_array_remove_range(a, 0, unused);
+
+		pool->low_water[i] = a->len;
+	}
+}
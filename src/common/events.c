@@ -10,9 +10,14 @@ struct closing_socket {
 	GList sockets_link;
 	int fd;
 	li_tstamp close_timeout;
+	gboolean eof;
+
+	liEventClosingSocketCB cb;
+	gpointer cb_data;
 };
 
 static void close_socket_now(closing_socket *cs) {
+	if (NULL != cs->cb) cs->cb(cs->fd, TRUE, cs->cb_data);
 	close(cs->fd);
 	cs->fd = -1;
 	g_queue_unlink(&cs->loop->closing_sockets, &cs->sockets_link);
@@ -31,9 +36,12 @@ static void closing_socket_cb(int revents, void* arg) {
 	}
 
 	/* empty the input buffer, wait for EOF or timeout or a socket error to close it */
-	for (;!loop->end;) {
+	for (;!loop->end && !cs->eof;) {
 		r = read(cs->fd, trash, sizeof(trash));
-		if (0 == r) break; /* got EOF */
+		if (0 == r) { /* got EOF */
+			cs->eof = TRUE;
+			break;
+		}
 		if (0 > r) { /* error */
 			switch (errno) {
 			case EINTR:
@@ -45,6 +53,9 @@ static void closing_socket_cb(int revents, void* arg) {
 #endif
 				/* check timeout: */
 				if (remaining > 0 && !(revents & EV_TIMEOUT)) {
+					/* let the owner handle what else woke us up (like pending errors, which keep
+					 * the socket readable), otherwise the next wait returns immediately again */
+					if (NULL != cs->cb) cs->cb(cs->fd, FALSE, cs->cb_data);
 					/* wait again */
 					ev_once(cs->loop->loop, cs->fd, EV_READ, remaining, closing_socket_cb, cs);
 					return;
@@ -60,17 +71,28 @@ static void closing_socket_cb(int revents, void* arg) {
 		}
 	}
 
+	if (cs->eof && !loop->end && remaining > 0 && NULL != cs->cb && cs->cb(cs->fd, FALSE, cs->cb_data)) {
+		/* the owner still needs the socket open; it stays readable after EOF, so check again a little later */
+		ev_once(cs->loop->loop, -1, 0, MIN(remaining, 0.05), closing_socket_cb, cs);
+		return;
+	}
+
 	close_socket_now(cs);
 	g_slice_free(closing_socket, cs);
 }
 
 void li_event_add_closing_socket(liEventLoop *loop, int fd) {
+	li_event_add_closing_socket_cb(loop, fd, NULL, NULL);
+}
+
+void li_event_add_closing_socket_cb(liEventLoop *loop, int fd, liEventClosingSocketCB cb, gpointer data) {
 	closing_socket *cs;
 
 	if (-1 == fd) return;
 
 	shutdown(fd, SHUT_WR);
 	if (loop->end) {
+		if (NULL != cb) cb(fd, TRUE, data);
 		close(fd);
 		return;
 	}
@@ -78,6 +100,8 @@ void li_event_add_closing_socket(liEventLoop *loop, int fd) {
 	cs = g_slice_new0(closing_socket);
 	cs->loop = loop;
 	cs->fd = fd;
+	cs->cb = cb;
+	cs->cb_data = data;
 	g_queue_push_tail_link(&loop->closing_sockets, &cs->sockets_link);
 	cs->close_timeout = li_event_now(loop) + 10.0;
 
@@ -368,6 +392,15 @@ void li_event_prepare_init(liEventLoop *loop, const char *event_name, liEventPre
 	li_event_start(prepare);
 }
 
+void li_event_prepare_run_last(liEventPrepare *prepare) {
+	gboolean active = li_event_active(prepare);
+
+	/* libev only allows changing the priority of inactive watchers */
+	if (active) li_event_stop(prepare);
+	ev_set_priority(&prepare->libevmess.w, EV_MINPRI);
+	if (active) li_event_start(prepare);
+}
+
 static void event_check_cb(struct ev_loop *loop, ev_check *w, int revents) {
 	liEventCheck *check = LI_CONTAINER_OF(w, liEventCheck, libevmess.check);
 	liEventLoop *my_loop = check->base.link_watchers.data;
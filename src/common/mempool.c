@@ -57,6 +57,9 @@ gsize li_mempool_align_page_size(gsize size) {
  *    + allow complex interface (don't want to replace malloc/free)
  *    + assume memory is going to be released soon again
  *    + avoid fragmentation with other allocators (like 1024*malloc(16kb); malloc(1byte); 1024*free(16kb) - 16mb "garbage")
+ *  - each thread caches freed chunks per chunk size (up to MP_CACHE_BYTES, at most MP_CACHE_MAX chunks), and reuses
+ *    them without locking; this includes chunks allocated by other threads (e.g. buffers handed to another worker).
+ *    if the cache is full half of it is returned to the magazines in one batch, locking each magazine only once.
  */
 
 # define UL_BITS (sizeof(gulong) * 8)
@@ -68,6 +71,13 @@ gsize li_mempool_align_page_size(gsize size) {
 
 # define MP_BIT_VECTOR_SIZE ((MP_MAX_ALLOC_COUNT + UL_BITS - 1)/UL_BITS)
 
+/* thread-local cache of freed chunks */
+# define MP_CACHE_MAX 32
+# define MP_CACHE_BYTES (256*1024)
+
+/* direct index of pools by page count (assuming pages are at least 4kb) */
+# define MP_POOL_INDEX_SIZE (MP_MAX_ALLOC_SIZE/MP_MIN_ALLOC_COUNT/(4*1024) + 1)
+
 # if 0
 #  define mp_assert(x) g_assert(x)
 # else
@@ -97,10 +107,20 @@ typedef gint mp_lock;
 typedef struct mp_pools mp_pools;
 typedef struct mp_pool mp_pool;
 typedef struct mp_magazine mp_magazine;
+typedef struct mp_cached_chunk mp_cached_chunk;
+
+struct mp_cached_chunk {
+	mp_magazine *mag; /* chunk still holds its reference */
+	void *data;
+};
 
 struct mp_pool {
 	guint32 chunksize;
 
+	/* freed chunks, used as stack; only accessed by the owning thread */
+	guint cache_used, cache_max;
+	mp_cached_chunk cache[MP_CACHE_MAX];
+
 	/* if magazines[i+1] != NULL => magazines[i] != NULL - only the "head" entries are not NULL */
 	/* so we can stop searching if an entry is NULL */
 	mp_magazine *magazines[MP_MAX_MAGAZINES];
@@ -125,11 +145,18 @@ struct mp_magazine {
 struct mp_pools {
 	/* one pool per chunksize; queue is sorted ASC by chunksize */
 	GQueue queue;
+
+	/* pool for chunksize (n * pagesize) at index[n] (if not NULL) */
+	mp_pool *index[MP_POOL_INDEX_SIZE];
 };
 
 static void mp_pools_free(gpointer _pools);
 
 static GPrivate *thread_pools = NULL;
+# ifdef HAVE___THREAD
+/* cached g_private_get(thread_pools) */
+static __thread mp_pools *mp_thread_pools = NULL;
+# endif
 static gboolean mp_initialized = 0;
 static gsize mp_pagesize = 0;
 
@@ -311,17 +338,49 @@ static inline void mp_mag_free(mp_magazine *mag, void *ptr) {
 static mp_pool* mp_pool_new(gsize size) {
 	mp_pool *pool = g_slice_new0(mp_pool);
 	pool->chunksize = size;
+	pool->cache_max = CLAMP(MP_CACHE_BYTES / size, 1, MP_CACHE_MAX);
 	pool->pools_list.data = pool;
 	pool->magazines[0] = mp_mag_new(pool);
 
 	return pool;
 }
 
+/* return the first count cached chunks to their magazines; chunks of the same magazine are freed with one lock */
+static void mp_pool_cache_flush(mp_pool *pool, guint count) {
+	mp_cached_chunk *cache = pool->cache;
+	guint i, j, freed;
+	mp_magazine *mag;
+
+	mp_assert(count <= pool->cache_used);
+
+	for (i = 0; i < count; i++) {
+		if (NULL == (mag = cache[i].mag)) continue;
+
+		freed = 0;
+		MP_LOCK(mag->mutex);
+		for (j = i; j < count; j++) {
+			if (cache[j].mag != mag) continue;
+			mp_mag_free(mag, cache[j].data);
+			cache[j].mag = NULL;
+			freed++;
+		}
+		MP_UNLOCK(mag->mutex);
+
+		/* release always after unlock; the last release might free the magazine */
+		for ( ; freed > 0; freed--) mp_mag_release(mag);
+	}
+
+	pool->cache_used -= count;
+	memmove(cache, cache + count, pool->cache_used * sizeof(mp_cached_chunk));
+}
+
 static void mp_pool_free(mp_pool *pool) {
 	guint i;
 	mp_magazine *mag;
 	if (!pool) return;
 
+	mp_pool_cache_flush(pool, pool->cache_used);
+
 	for (i = 0; i < MP_MAX_MAGAZINES; i++) {
 		mag = pool->magazines[i];
 		pool->magazines[i] = NULL;
@@ -348,6 +407,11 @@ static void mp_pools_free(gpointer _pools) {
 	mp_pool *pool;
 	GList *iter;
 
+# ifdef HAVE___THREAD
+	/* called from li_mempool_cleanup or the GPrivate destructor in the thread owning the pools */
+	if (mp_thread_pools == pools) mp_thread_pools = NULL;
+# endif
+
 	while (NULL != (iter = g_queue_pop_head_link(&pools->queue))) {
 		pool = iter->data;
 
@@ -357,10 +421,12 @@ static void mp_pools_free(gpointer _pools) {
 	g_slice_free(mp_pools, pools);
 }
 
-static inline mp_pool* mp_pools_get(gsize size) {
-	GList *iter;
+static inline mp_pools* mp_pools_current(void) {
 	mp_pools *pools;
-	mp_pool *pool;
+
+# ifdef HAVE___THREAD
+	if (HEDLEY_LIKELY(NULL != (pools = mp_thread_pools))) return pools;
+# endif
 
 	pools = g_private_get(thread_pools);
 	if (HEDLEY_UNLIKELY(!pools)) {
@@ -368,6 +434,17 @@ static inline mp_pool* mp_pools_get(gsize size) {
 		g_private_set(thread_pools, pools);
 	}
 
+# ifdef HAVE___THREAD
+	mp_thread_pools = pools;
+# endif
+
+	return pools;
+}
+
+static mp_pool* mp_pools_lookup(mp_pools *pools, gsize size) {
+	GList *iter;
+	mp_pool *pool;
+
 	for (iter = pools->queue.head; iter; iter = iter->next) {
 		pool = iter->data;
 		if (HEDLEY_LIKELY(pool->chunksize == size)) {
@@ -386,6 +463,19 @@ done:
 	return pool;
 }
 
+static inline mp_pool* mp_pools_get(gsize size) {
+	mp_pools *pools = mp_pools_current();
+	gsize ndx = size / mp_pagesize;
+	mp_pool *pool;
+
+	if (HEDLEY_LIKELY(ndx < MP_POOL_INDEX_SIZE)) {
+		if (HEDLEY_LIKELY(NULL != (pool = pools->index[ndx]))) return pool;
+		return pools->index[ndx] = mp_pools_lookup(pools, size);
+	}
+
+	return mp_pools_lookup(pools, size);
+}
+
 liMempoolPtr li_mempool_alloc(gsize size) {
 	liMempoolPtr ptr = { NULL, NULL };
 	mp_pool *pool;
@@ -408,6 +498,14 @@ liMempoolPtr li_mempool_alloc(gsize size) {
 
 	pool = mp_pools_get(size);
 
+	if (HEDLEY_LIKELY(pool->cache_used > 0)) {
+		/* reuse a cached chunk: no locking, the chunk already has its magazine reference */
+		mp_cached_chunk *cc = &pool->cache[--pool->cache_used];
+		ptr.priv_data = cc->mag;
+		ptr.data = cc->data;
+		return ptr;
+	}
+
 	/* Try to lock a unlocked magazine if possible; creating new magazines is allowed
 	 * (new ones can't be locked as only the current thread knows this magazine)
 	 * Spinlock the first magazine if first strategy failed */
@@ -462,7 +560,8 @@ found_mag:
 }
 
 void li_mempool_free(liMempoolPtr ptr, gsize size) {
-	mp_magazine *mag;
+	mp_pool *pool;
+	mp_cached_chunk *cc;
 	if (!ptr.data) return;
 
 	size = mp_align_size(size);
@@ -474,12 +573,17 @@ void li_mempool_free(liMempoolPtr ptr, gsize size) {
 	}
 
 	mp_assert(ptr.priv_data);
-	mag = ptr.priv_data;
-	MP_LOCK(mag->mutex);
-	mp_mag_free(mag, ptr.data);
-	MP_UNLOCK(mag->mutex);
 
-	mp_mag_release(mag); /* keep track of chunk count; release always after unlock! */
+	/* put into the cache of the current thread (might be a different thread than the one the chunk was allocated in) */
+	pool = mp_pools_get(size);
+	if (HEDLEY_UNLIKELY(pool->cache_used == pool->cache_max)) {
+		/* return the older half in one batch */
+		mp_pool_cache_flush(pool, (pool->cache_max + 1) / 2);
+	}
+
+	cc = &pool->cache[pool->cache_used++];
+	cc->mag = ptr.priv_data;
+	cc->data = ptr.data;
 }
 
 void li_mempool_cleanup(void) {
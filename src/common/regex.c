@@ -0,0 +1,302 @@
+
+#include <lighttpd/regex.h>
+#include <lighttpd/utils.h>
+
+#ifdef HAVE_PCRE2
+# define PCRE2_CODE_UNIT_WIDTH 8
+# include <pcre2.h>
+#endif
+
+struct liRegex {
+	gint refcount;
+	liRegexEngine engine;
+	gchar *pattern;
+
+	GRegex *gregex;
+#ifdef HAVE_PCRE2
+	pcre2_code *code;
+	gboolean jit;
+	guint32 pairs; /* capture groups + 1 */
+#endif
+};
+
+struct liRegexMatch {
+	const gchar *string;
+	GMatchInfo *match_info; /* glib engine */
+	guint pairs; /* pcre2 engine: number of offset pairs following the struct */
+};
+
+#define REGEX_MATCH_OFFSETS(match) ((gsize*) ((match) + 1))
+#define REGEX_MATCH_SIZE(pairs) (sizeof(liRegexMatch) + 2 * (pairs) * sizeof(gsize))
+#define REGEX_UNSET G_MAXSIZE
+
+#ifdef HAVE_PCRE2
+static liRegexEngine regex_engine = LI_REGEX_ENGINE_PCRE2;
+#else
+static liRegexEngine regex_engine = LI_REGEX_ENGINE_GLIB;
+#endif
+
+gboolean li_regex_engine_set(liRegexEngine engine) {
+#ifndef HAVE_PCRE2
+	if (LI_REGEX_ENGINE_PCRE2 == engine) return FALSE;
+#endif
+	regex_engine = engine;
+	return TRUE;
+}
+
+liRegexEngine li_regex_engine_get(void) {
+	return regex_engine;
+}
+
+const gchar* li_regex_engine_name(liRegexEngine engine) {
+	switch (engine) {
+	case LI_REGEX_ENGINE_GLIB: return "glib";
+	case LI_REGEX_ENGINE_PCRE2: return "pcre2";
+	}
+	return "unknown";
+}
+
+GQuark li_regex_error_quark(void) {
+	return g_quark_from_string("li-regex-error-quark");
+}
+
+#ifdef HAVE_PCRE2
+/* JIT stack per thread: the default (32k on the machine stack) is too small for long subjects or
+ * patterns with much backtracking; grows up to the maximum on demand */
+#define REGEX_JIT_STACK_START (32*1024)
+#define REGEX_JIT_STACK_MAX (1024*1024)
+
+/* match data for pcre2_match, one per (worker) thread; allocated on first use, grows with the
+ * number of capture groups. the match context carries the JIT stack */
+typedef struct regex_match_data regex_match_data;
+struct regex_match_data {
+	pcre2_match_data *data;
+	guint32 pairs;
+
+	pcre2_match_context *context;
+	pcre2_jit_stack *jit_stack;
+};
+
+static GPrivate *regex_match_data_key = NULL;
+#ifdef HAVE___THREAD
+/* cached g_private_get(regex_match_data_key) */
+static __thread regex_match_data *regex_match_data_thread = NULL;
+#endif
+
+static void regex_match_data_free(gpointer data) {
+	regex_match_data *md = data;
+
+	if (NULL != md->data) pcre2_match_data_free(md->data);
+	if (NULL != md->context) pcre2_match_context_free(md->context);
+	if (NULL != md->jit_stack) pcre2_jit_stack_free(md->jit_stack);
+	g_slice_free(regex_match_data, md);
+}
+
+static regex_match_data* regex_match_data_get(guint32 pairs) {
+	regex_match_data *md;
+
+#ifdef HAVE___THREAD
+	md = regex_match_data_thread;
+	if (HEDLEY_LIKELY(NULL != md && md->pairs >= pairs)) return md;
+#endif
+
+	if (HEDLEY_UNLIKELY(NULL == g_atomic_pointer_get(&regex_match_data_key))) {
+		static GStaticMutex init_mutex = G_STATIC_MUTEX_INIT;
+		g_static_mutex_lock(&init_mutex);
+		if (NULL == regex_match_data_key) {
+			GPrivate *key = g_private_new(regex_match_data_free);
+			g_atomic_pointer_set(&regex_match_data_key, key);
+		}
+		g_static_mutex_unlock(&init_mutex);
+	}
+
+	if (NULL == (md = g_private_get(regex_match_data_key))) {
+		md = g_slice_new0(regex_match_data);
+		md->context = pcre2_match_context_create(NULL);
+		LI_FORCE_ASSERT(NULL != md->context);
+		/* without JIT support (or memory) pcre2_jit_match isn't used / fails and pcre2_match is used */
+		md->jit_stack = pcre2_jit_stack_create(REGEX_JIT_STACK_START, REGEX_JIT_STACK_MAX, NULL);
+		if (NULL != md->jit_stack) pcre2_jit_stack_assign(md->context, NULL, md->jit_stack);
+		g_private_set(regex_match_data_key, md);
+	}
+
+	if (md->pairs < pairs) {
+		if (NULL != md->data) pcre2_match_data_free(md->data);
+		md->pairs = MAX(pairs, 16);
+		md->data = pcre2_match_data_create(md->pairs, NULL);
+		LI_FORCE_ASSERT(NULL != md->data);
+	}
+
+#ifdef HAVE___THREAD
+	regex_match_data_thread = md;
+#endif
+
+	return md;
+}
+
+static void regex_pcre2_error(GError **error, liRegex *regex, int rc) {
+	PCRE2_UCHAR msg[256];
+
+	if (NULL == error) return;
+	if (pcre2_get_error_message(rc, msg, sizeof(msg)) < 0) g_strlcpy((gchar*) msg, "unknown error", sizeof(msg));
+	g_set_error(error, LI_REGEX_ERROR, rc, "matching regex \"%s\" failed: %s", regex->pattern, (gchar*) msg);
+}
+#endif
+
+liRegex* li_regex_new(const gchar *pattern, GError **error) {
+	liRegex *regex = g_slice_new0(liRegex);
+
+	regex->refcount = 1;
+	regex->pattern = g_strdup(pattern);
+
+#ifdef HAVE_PCRE2
+	if (LI_REGEX_ENGINE_PCRE2 == regex_engine) {
+		int errcode;
+		PCRE2_SIZE erroffset;
+		uint32_t captures = 0;
+
+		/* same options as G_REGEX_RAW: no utf-8 */
+		regex->code = pcre2_compile((PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED, 0, &errcode, &erroffset, NULL);
+		if (NULL != regex->code) {
+			pcre2_pattern_info(regex->code, PCRE2_INFO_CAPTURECOUNT, &captures);
+			regex->pairs = captures + 1;
+			/* without JIT support pcre2_match interprets the pattern */
+			regex->jit = (0 == pcre2_jit_compile(regex->code, PCRE2_JIT_COMPLETE));
+			regex->engine = LI_REGEX_ENGINE_PCRE2;
+			return regex;
+		}
+
+		/* GRegex might accept it (other PCRE version); it reports the error otherwise */
+	}
+#endif
+
+	regex->gregex = g_regex_new(pattern, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, error);
+	if (NULL == regex->gregex) {
+		g_free(regex->pattern);
+		g_slice_free(liRegex, regex);
+		return NULL;
+	}
+	regex->engine = LI_REGEX_ENGINE_GLIB;
+
+	return regex;
+}
+
+void li_regex_acquire(liRegex *regex) {
+	LI_FORCE_ASSERT(g_atomic_int_get(&regex->refcount) > 0);
+	g_atomic_int_inc(&regex->refcount);
+}
+
+void li_regex_release(liRegex *regex) {
+	if (NULL == regex) return;
+	LI_FORCE_ASSERT(g_atomic_int_get(&regex->refcount) > 0);
+	if (!g_atomic_int_dec_and_test(&regex->refcount)) return;
+
+	if (NULL != regex->gregex) g_regex_unref(regex->gregex);
+#ifdef HAVE_PCRE2
+	if (NULL != regex->code) pcre2_code_free(regex->code);
+#endif
+	g_free(regex->pattern);
+	g_slice_free(liRegex, regex);
+}
+
+const gchar* li_regex_get_pattern(liRegex *regex) {
+	return regex->pattern;
+}
+
+liRegexEngine li_regex_get_engine(liRegex *regex) {
+	return regex->engine;
+}
+
+gboolean li_regex_match(liRegex *regex, const gchar *string, liRegexMatch **match, GError **error) {
+	GMatchInfo *match_info = NULL;
+
+	if (NULL != match) *match = NULL;
+
+#ifdef HAVE_PCRE2
+	if (NULL != regex->code) {
+		regex_match_data *rmd = regex_match_data_get(regex->pairs);
+		pcre2_match_data *md = rmd->data;
+		int rc = PCRE2_ERROR_JIT_STACKLIMIT;
+
+		if (regex->jit && NULL != rmd->jit_stack) {
+			rc = pcre2_jit_match(regex->code, (PCRE2_SPTR) string, strlen(string), 0, 0, md, rmd->context);
+		}
+		/* not JIT compiled, or the JIT stack was too small: the interpreter isn't limited by it
+		 * (PCRE2_NO_JIT, pcre2_match would use the JIT code again otherwise) */
+		if (PCRE2_ERROR_JIT_STACKLIMIT == rc) {
+			rc = pcre2_match(regex->code, (PCRE2_SPTR) string, PCRE2_ZERO_TERMINATED, 0, PCRE2_NO_JIT, md, rmd->context);
+		}
+
+		if (rc < 0) {
+			/* errors (match limit, ...) don't match either, but get reported */
+			if (PCRE2_ERROR_NOMATCH != rc) regex_pcre2_error(error, regex, rc);
+			return FALSE;
+		}
+
+		if (NULL != match) {
+			PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(md);
+			liRegexMatch *m = g_slice_alloc(REGEX_MATCH_SIZE(regex->pairs));
+			gsize *offsets = REGEX_MATCH_OFFSETS(m);
+			guint i;
+
+			m->string = string;
+			m->match_info = NULL;
+			m->pairs = regex->pairs;
+
+			/* only the first rc pairs are set */
+			for (i = 0; i < 2 * regex->pairs; i++) {
+				offsets[i] = (i < 2 * (guint) rc && PCRE2_UNSET != ovector[i]) ? (gsize) ovector[i] : REGEX_UNSET;
+			}
+
+			*match = m;
+		}
+
+		return TRUE;
+	}
+#endif
+
+	if (NULL == match) return g_regex_match_full(regex->gregex, string, -1, 0, 0, NULL, error);
+
+	if (!g_regex_match_full(regex->gregex, string, -1, 0, 0, &match_info, error)) {
+		g_match_info_free(match_info);
+		return FALSE;
+	}
+
+	*match = g_slice_alloc(REGEX_MATCH_SIZE(0));
+	(*match)->string = string;
+	(*match)->match_info = match_info;
+	(*match)->pairs = 0;
+
+	return TRUE;
+}
+
+void li_regex_match_free(liRegexMatch *match) {
+	if (NULL == match) return;
+
+	if (NULL != match->match_info) g_match_info_free(match->match_info);
+	g_slice_free1(REGEX_MATCH_SIZE(match->pairs), match);
+}
+
+const gchar* li_regex_match_get_string(liRegexMatch *match) {
+	return match->string;
+}
+
+gboolean li_regex_match_fetch_pos(liRegexMatch *match, guint n, gint *start_pos, gint *end_pos) {
+	gsize *offsets;
+
+	if (NULL != match->match_info) {
+		if (n > G_MAXINT || !g_match_info_fetch_pos(match->match_info, (gint) n, start_pos, end_pos)) return FALSE;
+		/* group didn't take part in the match */
+		return *start_pos >= 0;
+	}
+
+	if (n >= match->pairs) return FALSE;
+
+	offsets = REGEX_MATCH_OFFSETS(match);
+	if (REGEX_UNSET == offsets[2*n]) return FALSE;
+
+	*start_pos = (gint) offsets[2*n];
+	*end_pos = (gint) offsets[2*n + 1];
+
+	return TRUE;
+}
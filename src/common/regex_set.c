@@ -0,0 +1,433 @@
+
+#include <lighttpd/regex_set.h>
+#include <lighttpd/utils.h>
+
+typedef struct regex_set_entry regex_set_entry;
+struct regex_set_entry {
+	liRegex *regex;
+	gboolean anchored;
+};
+
+typedef struct regex_set_edge regex_set_edge;
+struct regex_set_edge {
+	guchar c;
+	guint target;
+};
+
+typedef struct regex_set_node regex_set_node;
+struct regex_set_node {
+	guint depth;
+	guint fail;    /* node for the longest proper suffix */
+	guint dict;    /* next node on the fail chain with literals ending there, 0: none */
+	GArray *edges; /* regex_set_edge, sorted by c */
+	GArray *ends;  /* guint: entries with the literal ending here, NULL: none */
+};
+
+struct liRegexSet {
+	GArray *entries; /* regex_set_entry */
+	GArray *nodes;   /* regex_set_node, 0 is the root */
+	GArray *always;  /* guint64 bitmap: entries without literal */
+	gsize scan_limit; /* only anchored literals: no need to scan further than the longest */
+	gboolean prepared;
+};
+
+#define REGEX_SET_NODE(set, ndx) (&g_array_index((set)->nodes, regex_set_node, (ndx)))
+#define REGEX_SET_BIT(ndx) (G_GUINT64_CONSTANT(1) << ((ndx) % 64))
+
+/* literal extraction: only the top-level sequence of the pattern is looked at; groups, classes and
+ * quantified atoms end a literal run. anything unusual (alternatives at top-level, option settings,
+ * \Q..\E, backreferences, ...) gives up.
+ */
+
+/* p at '['; returns pointer after the closing ']' */
+static const gchar* regex_skip_class(const gchar *p) {
+	p++;
+	if ('^' == *p) p++;
+	if (']' == *p) p++; /* literal ']' */
+
+	for (; '\0' != *p; p++) {
+		if ('\\' == *p) {
+			if ('\0' == *++p) return NULL;
+		} else if ('[' == *p && ':' == p[1]) {
+			/* posix class [:name:] */
+			const gchar *e = p + 2;
+			if ('^' == *e) e++;
+			while (g_ascii_isalpha(*e)) e++;
+			if (':' == e[0] && ']' == e[1]) p = e + 1;
+		} else if (']' == *p) {
+			return p + 1;
+		}
+	}
+
+	return NULL;
+}
+
+/* p at '('; returns pointer after the matching ')' */
+static const gchar* regex_skip_group(const gchar *p) {
+	guint depth = 0;
+
+	while ('\0' != *p) {
+		switch (*p) {
+		case '\\':
+			if ('\0' == *++p) return NULL;
+			p++;
+			break;
+		case '[':
+			if (NULL == (p = regex_skip_class(p))) return NULL;
+			break;
+		case '(':
+			depth++;
+			p++;
+			break;
+		case ')':
+			p++;
+			if (0 == --depth) return p;
+			break;
+		default:
+			p++;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/* skips a quantifier at p (if there is one) */
+static const gchar* regex_skip_quantifier(const gchar *p, gboolean *quantified, gboolean *optional) {
+	*quantified = TRUE;
+
+	switch (*p) {
+	case '?':
+	case '*':
+		*optional = TRUE;
+		p++;
+		break;
+	case '+':
+		*optional = FALSE;
+		p++;
+		break;
+	case '{':
+		/* {n}, {n,} or {n,m}; treated as optional */
+		*optional = TRUE;
+		p++;
+		if (!g_ascii_isdigit(*p)) return NULL;
+		while (g_ascii_isdigit(*p)) p++;
+		if (',' == *p) {
+			p++;
+			while (g_ascii_isdigit(*p)) p++;
+		}
+		if ('}' != *p) return NULL;
+		p++;
+		break;
+	default:
+		*quantified = FALSE;
+		*optional = FALSE;
+		return p;
+	}
+
+	/* lazy or possessive */
+	if ('?' == *p || '+' == *p) p++;
+
+	return p;
+}
+
+gboolean li_regex_literal(const gchar *pattern, GString *literal, gboolean *anchored) {
+	GString *run = g_string_sized_new(31), *prefix = g_string_sized_new(31);
+	const gchar *p = pattern;
+	gboolean in_prefix = FALSE;
+
+	g_string_truncate(literal, 0);
+	*anchored = FALSE;
+
+	if (NULL != strstr(pattern, "\\Q") || NULL != strstr(pattern, "(*") || NULL != strstr(pattern, "(?#")) goto fail;
+
+	if ('^' == *p) {
+		in_prefix = TRUE;
+		p++;
+	}
+
+	while ('\0' != *p) {
+		gint c = -1; /* the atom is a literal character */
+		gboolean quantified, optional;
+
+		switch (*p) {
+		case '\\':
+			p++;
+			if (g_ascii_isalnum(*p)) {
+				/* character types and assertions; everything else (backreferences, \x.., \p{..}, ...) gives up */
+				if (NULL == strchr("dDwWsShHvVRXbBAzZG", *p)) goto fail;
+			} else if ('\0' == *p) {
+				goto fail;
+			} else {
+				c = (guchar) *p;
+			}
+			p++;
+			break;
+		case '[':
+			if (NULL == (p = regex_skip_class(p))) goto fail;
+			break;
+		case '(':
+			/* (?i) and the like change how the rest is matched */
+			if ('?' == p[1] && ('\0' == p[2] || NULL == strchr(":=!<>", p[2]))) goto fail;
+			if (NULL == (p = regex_skip_group(p))) goto fail;
+			break;
+		case ')':
+		case '|':
+		case '?':
+		case '*':
+		case '+':
+		case '{':
+			goto fail;
+		case '.':
+		case '^':
+		case '$':
+			p++;
+			break;
+		default:
+			c = (guchar) *p;
+			p++;
+			break;
+		}
+
+		if (NULL == (p = regex_skip_quantifier(p, &quantified, &optional))) goto fail;
+
+		if (c >= 0 && !optional) g_string_append_c(run, c);
+
+		if (c < 0 || quantified) {
+			/* end of a literal run */
+			if (in_prefix) {
+				g_string_assign(prefix, run->str);
+				in_prefix = FALSE;
+			} else if (run->len > literal->len) {
+				g_string_assign(literal, run->str);
+			}
+			g_string_truncate(run, 0);
+		}
+	}
+
+	if (in_prefix) {
+		g_string_assign(prefix, run->str);
+	} else if (run->len > literal->len) {
+		g_string_assign(literal, run->str);
+	}
+
+	/* the longer one filters better; the prefix is cheaper to check */
+	if (prefix->len > 0 && prefix->len >= literal->len) {
+		g_string_assign(literal, prefix->str);
+		*anchored = TRUE;
+	}
+
+	g_string_free(run, TRUE);
+	g_string_free(prefix, TRUE);
+	return literal->len > 0;
+
+fail:
+	g_string_truncate(literal, 0);
+	g_string_free(run, TRUE);
+	g_string_free(prefix, TRUE);
+	return FALSE;
+}
+
+/* G_MAXUINT if there is no edge for c */
+static guint regex_set_child(liRegexSet *set, guint node, guchar c) {
+	GArray *edges = REGEX_SET_NODE(set, node)->edges;
+	guint lo = 0, hi;
+
+	if (NULL == edges) return G_MAXUINT;
+
+	for (hi = edges->len; lo < hi; ) {
+		guint mid = (lo + hi) / 2;
+		regex_set_edge *e = &g_array_index(edges, regex_set_edge, mid);
+
+		if (e->c == c) return e->target;
+		if (e->c < c) lo = mid + 1; else hi = mid;
+	}
+
+	return G_MAXUINT;
+}
+
+static guint regex_set_node_new(liRegexSet *set, guint depth) {
+	regex_set_node node;
+
+	memset(&node, 0, sizeof(node));
+	node.depth = depth;
+	g_array_append_val(set->nodes, node);
+
+	return set->nodes->len - 1;
+}
+
+static void regex_set_insert(liRegexSet *set, GString *literal, guint ndx) {
+	guint node = 0, i;
+
+	for (i = 0; i < literal->len; i++) {
+		guchar c = literal->str[i];
+		guint next = regex_set_child(set, node, c);
+
+		if (G_MAXUINT == next) {
+			regex_set_node *n;
+			regex_set_edge edge;
+			guint pos;
+
+			next = regex_set_node_new(set, i + 1);
+
+			n = REGEX_SET_NODE(set, node);
+			if (NULL == n->edges) n->edges = g_array_new(FALSE, FALSE, sizeof(regex_set_edge));
+			for (pos = 0; pos < n->edges->len && g_array_index(n->edges, regex_set_edge, pos).c < c; pos++) ;
+			edge.c = c;
+			edge.target = next;
+			g_array_insert_val(n->edges, pos, edge);
+		}
+
+		node = next;
+	}
+
+	{
+		regex_set_node *n = REGEX_SET_NODE(set, node);
+		if (NULL == n->ends) n->ends = g_array_new(FALSE, FALSE, sizeof(guint));
+		g_array_append_val(n->ends, ndx);
+	}
+}
+
+liRegexSet* li_regex_set_new(void) {
+	liRegexSet *set = g_slice_new0(liRegexSet);
+
+	set->entries = g_array_new(FALSE, FALSE, sizeof(regex_set_entry));
+	set->nodes = g_array_new(FALSE, FALSE, sizeof(regex_set_node));
+	set->always = g_array_new(FALSE, TRUE, sizeof(guint64));
+	regex_set_node_new(set, 0);
+
+	return set;
+}
+
+void li_regex_set_free(liRegexSet *set) {
+	guint i;
+
+	if (NULL == set) return;
+
+	for (i = 0; i < set->nodes->len; i++) {
+		regex_set_node *n = REGEX_SET_NODE(set, i);
+		if (NULL != n->edges) g_array_free(n->edges, TRUE);
+		if (NULL != n->ends) g_array_free(n->ends, TRUE);
+	}
+	g_array_free(set->nodes, TRUE);
+	g_array_free(set->entries, TRUE);
+	g_array_free(set->always, TRUE);
+
+	g_slice_free(liRegexSet, set);
+}
+
+void li_regex_set_add(liRegexSet *set, liRegex *regex) {
+	regex_set_entry entry;
+	GString *literal = g_string_sized_new(31);
+	guint ndx = set->entries->len;
+
+	LI_FORCE_ASSERT(!set->prepared);
+
+	entry.regex = regex;
+	entry.anchored = FALSE;
+
+	g_array_set_size(set->always, ndx / 64 + 1);
+
+	/* liRegex patterns are compiled without options; inline options make li_regex_literal give up */
+	if (NULL == regex || !li_regex_literal(li_regex_get_pattern(regex), literal, &entry.anchored)) {
+		g_array_index(set->always, guint64, ndx / 64) |= REGEX_SET_BIT(ndx);
+	} else {
+		regex_set_insert(set, literal, ndx);
+		if (!entry.anchored) set->scan_limit = G_MAXSIZE;
+		else if (set->scan_limit < literal->len) set->scan_limit = literal->len;
+	}
+
+	g_array_append_val(set->entries, entry);
+	g_string_free(literal, TRUE);
+}
+
+void li_regex_set_prepare(liRegexSet *set) {
+	GQueue queue = G_QUEUE_INIT;
+	guint i;
+
+	LI_FORCE_ASSERT(!set->prepared);
+	set->prepared = TRUE;
+
+	/* li_regex_set_match copies count / 64 + 1 words */
+	g_array_set_size(set->always, set->entries->len / 64 + 1);
+
+	/* breadth first: fail links of shorter nodes are ready when needed */
+	{
+		regex_set_node *root = REGEX_SET_NODE(set, 0);
+		for (i = 0; NULL != root->edges && i < root->edges->len; i++) {
+			g_queue_push_tail(&queue, GUINT_TO_POINTER(g_array_index(root->edges, regex_set_edge, i).target));
+		}
+	}
+
+	while (!g_queue_is_empty(&queue)) {
+		guint node = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+		GArray *edges = REGEX_SET_NODE(set, node)->edges;
+
+		for (i = 0; NULL != edges && i < edges->len; i++) {
+			regex_set_edge *e = &g_array_index(edges, regex_set_edge, i);
+			guint f = REGEX_SET_NODE(set, node)->fail, next;
+			regex_set_node *target, *fn;
+
+			while (G_MAXUINT == (next = regex_set_child(set, f, e->c)) && 0 != f) {
+				f = REGEX_SET_NODE(set, f)->fail;
+			}
+
+			target = REGEX_SET_NODE(set, e->target);
+			target->fail = (G_MAXUINT == next) ? 0 : next;
+			fn = REGEX_SET_NODE(set, target->fail);
+			target->dict = (NULL != fn->ends) ? target->fail : fn->dict;
+
+			g_queue_push_tail(&queue, GUINT_TO_POINTER(e->target));
+		}
+	}
+}
+
+gint li_regex_set_match(liRegexSet *set, const gchar *string, liRegexMatch **match, GError **error) {
+	guint count = set->entries->len, words = count / 64 + 1, i;
+	guint64 candidates[words];
+	guint state = 0;
+	gsize pos;
+
+	LI_FORCE_ASSERT(set->prepared);
+
+	if (NULL != match) *match = NULL;
+	if (0 == count) return -1;
+
+	memcpy(candidates, set->always->data, words * sizeof(guint64));
+
+	/* one pass over the subject: mark entries whose literal was found */
+	for (pos = 0; pos < set->scan_limit && '\0' != string[pos]; pos++) {
+		guchar c = string[pos];
+		guint next, node;
+
+		while (G_MAXUINT == (next = regex_set_child(set, state, c)) && 0 != state) {
+			state = REGEX_SET_NODE(set, state)->fail;
+		}
+		if (G_MAXUINT != next) state = next;
+
+		node = (NULL != REGEX_SET_NODE(set, state)->ends) ? state : REGEX_SET_NODE(set, state)->dict;
+		for (; 0 != node; node = REGEX_SET_NODE(set, node)->dict) {
+			regex_set_node *n = REGEX_SET_NODE(set, node);
+
+			for (i = 0; i < n->ends->len; i++) {
+				guint ndx = g_array_index(n->ends, guint, i);
+
+				/* anchored literals only count at the start */
+				if (g_array_index(set->entries, regex_set_entry, ndx).anchored && pos + 1 != n->depth) continue;
+				candidates[ndx / 64] |= REGEX_SET_BIT(ndx);
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		regex_set_entry *entry;
+
+		if (0 == (candidates[i / 64] & REGEX_SET_BIT(i))) continue;
+
+		entry = &g_array_index(set->entries, regex_set_entry, i);
+		if (NULL == entry->regex) return i;
+		if (li_regex_match(entry->regex, string, match, (NULL != error && NULL == *error) ? error : NULL)) return i;
+	}
+
+	return -1;
+}
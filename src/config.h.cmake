@@ -17,6 +17,8 @@
 #cmakedefine HAVE_SYS_PRCTL_H
 #cmakedefine HAVE_SYS_RESOURCE_H
 #cmakedefine HAVE_SYS_SENDFILE_H
+#cmakedefine HAVE_LINUX_ERRQUEUE_H
+#cmakedefine HAVE_LINUX_SOCKIOS_H
 #cmakedefine HAVE_SYS_SELECT_H
 #cmakedefine HAVE_SYS_SYSLIMITS_H
 #cmakedefine HAVE_SYS_TYPES_H
@@ -28,6 +30,7 @@
 #cmakedefine HAVE_INET_ATON
 #cmakedefine HAVE_IPV6
 #cmakedefine HAVE_SOCKADDR_STORAGE
+#cmakedefine HAVE___THREAD
 #cmakedefine HAVE_EXECINFO_H
 
 /* XATTR */
@@ -106,6 +109,12 @@
 /* libunwind */
 #cmakedefine  HAVE_LIBUNWIND
 
+/* liburing */
+#cmakedefine  HAVE_LIBURING
+
+/* pcre2 */
+#cmakedefine  HAVE_PCRE2
+
 /* inotify */
 #cmakedefine  HAVE_INOTIFY_INIT
 #cmakedefine  HAVE_SYS_INOTIFY_H
@@ -144,6 +153,7 @@
 #cmakedefine  HAVE_SIGACTION
 #cmakedefine  HAVE_SIGNAL
 #cmakedefine  HAVE_SIGTIMEDWAIT
+#cmakedefine  HAVE_SPLICE
 #cmakedefine  HAVE_STRPTIME
 #cmakedefine  HAVE_SYSLOG
 #cmakedefine  HAVE_WRITEV
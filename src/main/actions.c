@@ -1,6 +1,8 @@
 
 #include <lighttpd/base.h>
 
+#include <time.h>
+
 typedef struct action_stack_element action_stack_element;
 
 struct action_stack_element {
@@ -10,6 +12,7 @@ struct action_stack_element {
 		guint pos;
 	} data;
 	gboolean finished, backlog_provided;
+	gboolean borrowed; /* entered by the interpreter: the parent on the stack holds the reference */
 };
 
 void li_action_release(liServer *srv, liAction *a) {
@@ -46,6 +49,14 @@ void li_action_release(liServer *srv, liAction *a) {
 				a->data.balancer.free(srv, a->data.balancer.param);
 			}
 			break;
+		case LI_ACTION_TSWITCH:
+			li_condition_switch_free(a->data.cswitch.sw);
+			for (i = a->data.cswitch.targets->len; i-- > 0; ) {
+				li_action_release(srv, g_ptr_array_index(a->data.cswitch.targets, i));
+			}
+			g_ptr_array_free(a->data.cswitch.targets, TRUE);
+			li_action_release(srv, a->data.cswitch.target_else);
+			break;
 		}
 		g_slice_free(liAction, a);
 	}
@@ -161,6 +172,139 @@ void li_action_append_inplace(liAction *list, liAction *element) {
 	}
 }
 
+/* replace a list with a single element by the element */
+static void action_unwrap_list(liServer *srv, liAction **pa) {
+	liAction *a = *pa, *e;
+
+	if (NULL == a || LI_ACTION_TLIST != a->type || 1 != a->data.list->len) return;
+
+	e = g_array_index(a->data.list, liAction*, 0);
+	li_action_acquire(e);
+	li_action_release(srv, a);
+	*pa = e;
+}
+
+/* shorter chains of conditions are checked one by one */
+#define ACTION_SWITCH_MIN 4
+
+static liAction* action_single(liAction *a) {
+	while (NULL != a && LI_ACTION_TLIST == a->type && 1 == a->data.list->len) {
+		a = g_array_index(a->data.list, liAction*, 0);
+	}
+	return a;
+}
+
+/* "if c1 { t1 } else if c2 { t2 } ... else { e }" with string conditions on the same lvalue and
+ * operator (==, =^ or =$): turn a into a switch over all of them (in place) */
+static void action_fold_switch(liServer *srv, liAction *a) {
+	liConditionSwitch *sw;
+	liAction *c, *next;
+	liAction old;
+	GPtrArray *targets;
+	guint count;
+
+	if (NULL == (sw = li_condition_switch_new(a->data.condition.cond))) return;
+
+	for (c = a; ; c = next) {
+		next = action_single(c->data.condition.target_else);
+		if (NULL == next || LI_ACTION_TCONDITION != next->type || !li_condition_switch_add(sw, next->data.condition.cond)) break;
+	}
+
+	count = li_condition_switch_count(sw);
+	if (count < ACTION_SWITCH_MIN) {
+		li_condition_switch_free(sw);
+		return;
+	}
+
+	targets = g_ptr_array_sized_new(count);
+	for (c = a; ; c = action_single(c->data.condition.target_else)) {
+		if (NULL != c->data.condition.target) li_action_acquire(c->data.condition.target);
+		g_ptr_array_add(targets, c->data.condition.target);
+		if (count == targets->len) break;
+	}
+
+	old = *a;
+	a->type = LI_ACTION_TSWITCH;
+	a->data.cswitch.sw = sw;
+	a->data.cswitch.targets = targets;
+	a->data.cswitch.target_else = c->data.condition.target_else;
+	if (NULL != a->data.cswitch.target_else) li_action_acquire(a->data.cswitch.target_else);
+
+	li_condition_release(srv, old.data.condition.cond);
+	li_action_release(srv, old.data.condition.target);
+	li_action_release(srv, old.data.condition.target_else);
+}
+
+static void action_compile(liServer *srv, liAction *a, GHashTable *done) {
+	guint i;
+
+	if (NULL == a || NULL != g_hash_table_lookup(done, a)) return;
+	g_hash_table_insert(done, a, a);
+
+	if (LI_ACTION_TCONDITION == a->type) action_fold_switch(srv, a);
+
+	switch (a->type) {
+	case LI_ACTION_TCONDITION:
+		action_compile(srv, a->data.condition.target, done);
+		action_compile(srv, a->data.condition.target_else, done);
+		action_unwrap_list(srv, &a->data.condition.target);
+		action_unwrap_list(srv, &a->data.condition.target_else);
+		break;
+	case LI_ACTION_TSWITCH:
+		for (i = 0; i < a->data.cswitch.targets->len; i++) {
+			action_compile(srv, g_ptr_array_index(a->data.cswitch.targets, i), done);
+			action_unwrap_list(srv, (liAction**) &g_ptr_array_index(a->data.cswitch.targets, i));
+		}
+		action_compile(srv, a->data.cswitch.target_else, done);
+		action_unwrap_list(srv, &a->data.cswitch.target_else);
+		break;
+	case LI_ACTION_TLIST: {
+			GArray *list = a->data.list, *flat;
+			gboolean changed = FALSE;
+
+			for (i = 0; i < list->len; i++) {
+				liAction *sub = g_array_index(list, liAction*, i);
+				action_compile(srv, sub, done);
+				if (LI_ACTION_TLIST == sub->type || LI_ACTION_TNOTHING == sub->type) changed = TRUE;
+			}
+			if (!changed) break;
+
+			/* sub lists are already flat: splice their elements in */
+			flat = g_array_sized_new(FALSE, TRUE, sizeof(liAction *), list->len);
+			for (i = 0; i < list->len; i++) {
+				liAction *sub = g_array_index(list, liAction*, i);
+				guint j;
+
+				if (LI_ACTION_TLIST == sub->type) {
+					for (j = 0; j < sub->data.list->len; j++) {
+						liAction *e = g_array_index(sub->data.list, liAction*, j);
+						li_action_acquire(e);
+						g_array_append_val(flat, e);
+					}
+				} else if (LI_ACTION_TNOTHING != sub->type) {
+					li_action_acquire(sub);
+					g_array_append_val(flat, sub);
+				}
+			}
+			for (i = list->len; i-- > 0; ) {
+				li_action_release(srv, g_array_index(list, liAction*, i));
+			}
+			g_array_free(list, TRUE);
+			a->data.list = flat;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void li_action_compile(liServer *srv, liAction *a) {
+	/* actions can be shared (config variables); visit every node once */
+	GHashTable *done = g_hash_table_new(NULL, NULL);
+	action_compile(srv, a, done);
+	g_hash_table_destroy(done);
+}
+
 static void action_stack_element_release(liServer *srv, liVRequest *vr, action_stack_element *ase) {
 	liAction *a;
 
@@ -185,19 +329,20 @@ static void action_stack_element_release(liServer *srv, liVRequest *vr, action_s
 				liActionRegexStackElement *arse = &g_array_index(rs, liActionRegexStackElement, rs->len - 1);
 				if (arse->string)
 					g_string_free(arse->string, TRUE);
-				g_match_info_free(arse->match_info);
+				li_regex_match_free(arse->match);
 				g_array_set_size(rs, rs->len - 1);
 			}
 		}
 		break;
 	case LI_ACTION_TLIST:
+	case LI_ACTION_TSWITCH:
 		break;
 	case LI_ACTION_TBALANCER:
 		a->data.balancer.finished(vr, a->data.balancer.param, ase->data.context);
 		break;
 	}
 
-	li_action_release(srv, ase->act);
+	if (!ase->borrowed) li_action_release(srv, ase->act);
 	ase->act = NULL;
 	ase->data.context = NULL;
 }
@@ -259,16 +404,46 @@ static action_stack_element *action_stack_top(liActionStack* as) {
 	return as->stack->len > 0 ? &g_array_index(as->stack, action_stack_element, as->stack->len - 1) : NULL;
 }
 
-/** handle sublist now, remember current position (stack) */
-void li_action_enter(liVRequest *vr, liAction *a) {
-	liActionStack *as = &vr->action_stack;
+static void action_stack_push(liActionStack *as, liAction *a, gboolean borrowed) {
 	action_stack_element *top_ase = action_stack_top(as);
 	action_stack_element ase = { a, { 0 }, FALSE,
-		(top_ase ? top_ase->backlog_provided || (top_ase->act->type == LI_ACTION_TBALANCER && top_ase->act->data.balancer.provide_backlog) : FALSE) };
-	li_action_acquire(a);
+		(top_ase ? top_ase->backlog_provided || (top_ase->act->type == LI_ACTION_TBALANCER && top_ase->act->data.balancer.provide_backlog) : FALSE),
+		borrowed };
 	g_array_append_val(as->stack, ase);
 }
 
+/** handle sublist now, remember current position (stack) */
+void li_action_enter(liVRequest *vr, liAction *a) {
+	li_action_acquire(a);
+	action_stack_push(&vr->action_stack, a, FALSE);
+}
+
+/* children of lists and conditions: the parent stays on the stack below them and keeps them alive,
+ * so no (atomic) refcounting is needed */
+static void action_enter_borrowed(liVRequest *vr, liAction *a) {
+	action_stack_push(&vr->action_stack, a, TRUE);
+}
+
+/* returns FALSE if a is not a setting */
+static gboolean action_apply_setting(liServer *srv, liVRequest *vr, liAction *a) {
+	switch (a->type) {
+	case LI_ACTION_TNOTHING:
+		return TRUE;
+	case LI_ACTION_TSETTING:
+		vr->options[a->data.setting.ndx] = a->data.setting.value;
+		return TRUE;
+	case LI_ACTION_TSETTINGPTR:
+		if (vr->optionptrs[a->data.settingptr.ndx] != a->data.settingptr.value) {
+			g_atomic_int_inc(&a->data.settingptr.value->refcount);
+			li_release_optionptr(srv, vr->optionptrs[a->data.settingptr.ndx]);
+			vr->optionptrs[a->data.settingptr.ndx] = a->data.settingptr.value;
+		}
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
 static void action_stack_pop(liServer *srv, liVRequest *vr, liActionStack *as) {
 	action_stack_element *ase;
 
@@ -277,7 +452,11 @@ static void action_stack_pop(liServer *srv, liVRequest *vr, liActionStack *as) {
 	ase = &g_array_index(as->stack, action_stack_element, as->stack->len - 1);
 
 	if (ase->act->type == LI_ACTION_TBALANCER && !as->backend_finished) {
-		/* release later if backend is finished (i.e. "disconnected") */
+		/* release later if backend is finished (i.e. "disconnected"); the parent is gone by then */
+		if (ase->borrowed) {
+			li_action_acquire(ase->act);
+			ase->borrowed = FALSE;
+		}
 		g_array_append_val(as->backend_stack, *ase);
 	} else {
 		action_stack_element_release(srv, vr, ase);
@@ -286,7 +465,7 @@ static void action_stack_pop(liServer *srv, liVRequest *vr, liActionStack *as) {
 	g_array_set_size(as->stack, as->stack->len - 1);
 }
 
-liHandlerResult li_action_execute(liVRequest *vr) {
+static liHandlerResult action_execute(liVRequest *vr) {
 	liAction *a;
 	liActionStack *as = &vr->action_stack;
 	action_stack_element *ase;
@@ -349,18 +528,9 @@ liHandlerResult li_action_execute(liVRequest *vr) {
 
 		switch (a->type) {
 		case LI_ACTION_TNOTHING:
-			action_stack_pop(srv, vr, as);
-			break;
 		case LI_ACTION_TSETTING:
-			vr->options[a->data.setting.ndx] = a->data.setting.value;
-			action_stack_pop(srv, vr, as);
-			break;
 		case LI_ACTION_TSETTINGPTR:
-			if (vr->optionptrs[a->data.settingptr.ndx] != a->data.settingptr.value) {
-				g_atomic_int_inc(&a->data.settingptr.value->refcount);
-				li_release_optionptr(srv, vr->optionptrs[a->data.settingptr.ndx]);
-				vr->optionptrs[a->data.settingptr.ndx] = a->data.settingptr.value;
-			}
+			action_apply_setting(srv, vr, a);
 			action_stack_pop(srv, vr, as);
 			break;
 		case LI_ACTION_TFUNCTION:
@@ -388,10 +558,10 @@ liHandlerResult li_action_execute(liVRequest *vr) {
 			case LI_HANDLER_GO_ON:
 				ase->finished = TRUE;
 				if (condres) {
-					if (a->data.condition.target) li_action_enter(vr, a->data.condition.target);
+					if (a->data.condition.target) action_enter_borrowed(vr, a->data.condition.target);
 				}
 				else if (a->data.condition.target_else) {
-					li_action_enter(vr, a->data.condition.target_else);
+					action_enter_borrowed(vr, a->data.condition.target_else);
 				}
 				break;
 			case LI_HANDLER_ERROR:
@@ -402,12 +572,38 @@ liHandlerResult li_action_execute(liVRequest *vr) {
 				return res;
 			}
 			break;
+		case LI_ACTION_TSWITCH: {
+				guint ndx;
+				liAction *target;
+
+				res = li_condition_switch_check(vr, a->data.cswitch.sw, &ndx);
+				switch (res) {
+				case LI_HANDLER_GO_ON:
+					ase->finished = TRUE;
+					target = (ndx < a->data.cswitch.targets->len) ? g_ptr_array_index(a->data.cswitch.targets, ndx) : a->data.cswitch.target_else;
+					if (target) action_enter_borrowed(vr, target);
+					break;
+				case LI_HANDLER_ERROR:
+					li_action_stack_reset(vr, as);
+					return res;
+				case LI_HANDLER_COMEBACK:
+				case LI_HANDLER_WAIT_FOR_EVENT:
+					return res;
+				}
+			}
+			break;
 		case LI_ACTION_TLIST:
+			/* settings don't need a stack element: apply them right away */
+			while (ase->data.pos < a->data.list->len
+			    && action_apply_setting(srv, vr, g_array_index(a->data.list, liAction*, ase->data.pos))) {
+				ase->data.pos++;
+				vr->wrk->stats.actions_executed++;
+			}
 			if (ase->data.pos >= a->data.list->len) {
 				action_stack_pop(srv, vr, as);
 			} else {
 				guint p = ase->data.pos++;
-				li_action_enter(vr, g_array_index(a->data.list, liAction*, p));
+				action_enter_borrowed(vr, g_array_index(a->data.list, liAction*, p));
 			}
 			break;
 		case LI_ACTION_TBALANCER:
@@ -443,6 +639,28 @@ liHandlerResult li_action_execute(liVRequest *vr) {
 	return LI_HANDLER_GO_ON;
 }
 
+static inline guint64 action_clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + (guint64) ts.tv_nsec;
+}
+
+liHandlerResult li_action_execute(liVRequest *vr) {
+	liWorker *wrk = vr->wrk;
+	guint64 start;
+	liHandlerResult res;
+
+	/* reading the clock costs about as much as a short action run: only sample some calls */
+	if (HEDLEY_LIKELY(++wrk->actions_timing < LI_ACTIONS_TIMING_SAMPLE)) return action_execute(vr);
+	wrk->actions_timing = 0;
+
+	start = action_clock_ns();
+	res = action_execute(vr);
+	wrk->stats.actions_ns += (action_clock_ns() - start) * LI_ACTIONS_TIMING_SAMPLE;
+
+	return res;
+}
+
 void li_vrequest_backend_finished(liVRequest *vr) {
 	if (!li_vrequest_is_handled(vr)) return;
 	vr->action_stack.backend_finished = TRUE;
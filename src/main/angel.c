@@ -112,6 +112,65 @@ void li_angel_listen(liServer *srv, GString *str, liAngelListenCB cb, gpointer d
 	}
 }
 
+typedef struct angel_listen_reuseport_cb_ctx angel_listen_reuseport_cb_ctx;
+struct angel_listen_reuseport_cb_ctx {
+	liServer *srv;
+	guint count;
+	liAngelListenReuseportCB cb;
+	gpointer data;
+};
+
+static void li_angel_listen_reuseport_cb(gpointer pctx, gboolean timeout, GString *error, GString *data, GArray *fds) {
+	angel_listen_reuseport_cb_ctx ctx = * (angel_listen_reuseport_cb_ctx*) pctx;
+	liServer *srv = ctx.srv;
+	UNUSED(data);
+
+	g_slice_free(angel_listen_reuseport_cb_ctx, pctx);
+
+	if (timeout) {
+		ERROR(srv, "listen failed: %s", "time out");
+	} else if (error->len > 0) {
+		ERROR(srv, "listen failed: %s", error->str);
+	} else if (NULL == fds || fds->len != ctx.count) {
+		ERROR(srv, "listen failed: expected %u filedescriptors, received %u", ctx.count, fds ? fds->len : 0);
+	} else {
+		ctx.cb(srv, fds, ctx.data);
+		g_array_set_size(fds, 0);
+		return;
+	}
+
+	ctx.cb(srv, NULL, ctx.data);
+}
+
+void li_angel_listen_reuseport(liServer *srv, GString *str, guint count, liAngelListenReuseportCB cb, gpointer data) {
+	if (srv->acon) {
+		liAngelCall *acall = li_angel_call_new(&srv->main_worker->loop, li_angel_listen_reuseport_cb, 20.0);
+		angel_listen_reuseport_cb_ctx *ctx = g_slice_new0(angel_listen_reuseport_cb_ctx);
+		GString *request = g_string_sized_new(str->len + 12);
+		GError *err = NULL;
+
+		ctx->srv = srv;
+		ctx->count = count;
+		ctx->cb = cb;
+		ctx->data = data;
+		acall->context = ctx;
+		g_string_printf(request, "%u %s", count, str->str);
+		if (!li_angel_send_call(srv->acon, CONST_STR_LEN("core"), CONST_STR_LEN("listen-reuseport"), acall, request, &err)) {
+			ERROR(srv, "couldn't send call: %s", err->message);
+			g_error_free(err);
+		}
+	} else {
+		GArray *fds = li_angel_fake_listen_reuseport(srv, str, count);
+		if (NULL == fds) {
+			ERROR(srv, "listen('%s') failed", str->str);
+			cb(srv, NULL, data);
+		} else {
+			cb(srv, fds, data);
+			g_array_free(fds, TRUE);
+		}
+	}
+}
+
 /* send log messages while startup to angel */
 void li_angel_log(liServer *srv, GString *str) {
 	li_angel_fake_log(srv, str);
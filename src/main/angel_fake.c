@@ -5,8 +5,7 @@
 
 #include <fcntl.h>
 
-/* listen to a socket */
-int li_angel_fake_listen(liServer *srv, GString *str) {
+static int fake_listen(liServer *srv, GString *str, gboolean reuseport) {
 	liSocketAddress addr = li_sockaddr_from_string(str, 80);
 	liSockAddr *saddr = addr.addr;
 	GString *tmpstr;
@@ -22,6 +21,10 @@ int li_angel_fake_listen(liServer *srv, GString *str) {
 	switch (saddr->plain.sa_family) {
 #ifdef HAVE_SYS_UN_H
 	case AF_UNIX:
+		if (reuseport) {
+			ERROR(srv, "SO_REUSEPORT not supported for unix socket '%s'", tmpstr->str);
+			goto error;
+		}
 		if (-1 == unlink(saddr->un.sun_path)) {
 			switch (errno) {
 			case ENOENT:
@@ -62,6 +65,19 @@ int li_angel_fake_listen(liServer *srv, GString *str) {
 			close(s);
 			goto error;
 		}
+		if (reuseport) {
+#ifdef SO_REUSEPORT
+			if (-1 == setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &v, sizeof(v))) {
+				ERROR(srv, "Couldn't setsockopt(SO_REUSEPORT): %s", g_strerror(errno));
+				close(s);
+				goto error;
+			}
+#else
+			ERROR(srv, "%s", "SO_REUSEPORT not supported on this platform");
+			close(s);
+			goto error;
+#endif
+		}
 #ifdef HAVE_IPV6
 		if (AF_INET6 == saddr->plain.sa_family && -1 == setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, &v, sizeof(v))) {
 			ERROR(srv, "Couldn't setsockopt(IPV6_V6ONLY): %s", g_strerror(errno));
@@ -107,6 +123,29 @@ error:
 	return -1;
 }
 
+/* listen to a socket */
+int li_angel_fake_listen(liServer *srv, GString *str) {
+	return fake_listen(srv, str, FALSE);
+}
+
+/* listen to a socket with count SO_REUSEPORT sockets */
+GArray* li_angel_fake_listen_reuseport(liServer *srv, GString *str, guint count) {
+	GArray *fds = g_array_sized_new(FALSE, FALSE, sizeof(int), count);
+	guint i;
+
+	for (i = 0; i < count; i++) {
+		int fd = fake_listen(srv, str, TRUE);
+		if (-1 == fd) {
+			for (i = 0; i < fds->len; i++) close(g_array_index(fds, int, i));
+			g_array_free(fds, TRUE);
+			return NULL;
+		}
+		g_array_append_val(fds, fd);
+	}
+
+	return fds;
+}
+
 /* print log messages during startup to stderr */
 gboolean li_angel_fake_log(liServer *srv, GString *str) {
 	const char *buf;
@@ -74,6 +74,71 @@ liHandlerResult li_chunkfile_open(liChunkFile *cf, GError **err) {
 	return LI_HANDLER_GO_ON;
 }
 
+/******************
+ *   chunkpipe    *
+ ******************/
+
+liChunkPipe *li_chunkpipe_new(void) {
+#ifdef USE_SPLICE
+	liChunkPipe *cp;
+	int fds[2];
+
+	if (-1 == pipe(fds)) return NULL;
+	li_fd_init(fds[0]);
+	li_fd_init(fds[1]);
+
+	cp = g_slice_new0(liChunkPipe);
+	cp->refcount = 1;
+	cp->fd_read = fds[0];
+	cp->fd_write = fds[1];
+	return cp;
+#else
+	return NULL;
+#endif
+}
+
+void li_chunkpipe_acquire(liChunkPipe *cp) {
+	LI_FORCE_ASSERT(g_atomic_int_get(&cp->refcount) > 0);
+	g_atomic_int_inc(&cp->refcount);
+}
+
+void li_chunkpipe_release(liChunkPipe *cp) {
+	if (!cp) return;
+	LI_FORCE_ASSERT(g_atomic_int_get(&cp->refcount) > 0);
+	if (g_atomic_int_dec_and_test(&cp->refcount)) {
+		close(cp->fd_read);
+		close(cp->fd_write);
+		g_slice_free(liChunkPipe, cp);
+	}
+}
+
+gboolean li_chunkpipe_discard(liChunkPipe *cp, goffset pos, GError **err) {
+	char buf[4*1024];
+
+	g_return_val_if_fail (err == NULL || *err == NULL, FALSE);
+
+	if (pos < cp->read_pos || pos > cp->write_pos) {
+		g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkpipe_discard: data at position %"LI_GOFFSET_FORMAT" already gone", pos);
+		return FALSE;
+	}
+
+	while (cp->read_pos < pos) {
+		ssize_t r = read(cp->fd_read, buf, MIN((goffset) sizeof(buf), pos - cp->read_pos));
+
+		if (-1 == r) {
+			if (EINTR == errno) continue;
+			g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkpipe_discard: read from pipe failed: %s", g_strerror(errno));
+			return FALSE;
+		} else if (0 == r) {
+			g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkpipe_discard: unexpected end of pipe");
+			return FALSE;
+		}
+		cp->read_pos += r;
+	}
+
+	return TRUE;
+}
+
 /******************
  * chunk iterator *
  ******************/
@@ -82,6 +147,28 @@ liHandlerResult li_chunkfile_open(liChunkFile *cf, GError **err) {
 #define MAX_MMAP_CHUNK (2*1024*1024)
 #define MMAP_CHUNK_ALIGN (4*1024)
 
+/* returns the loaded data of a FILE_CHUNK at file offset our_start (in c->mem or the mmap()-ed area),
+ * limits *length to the loaded range; NULL if our_start isn't loaded
+ */
+static char* chunk_file_cached(liChunk *c, off_t our_start, off_t *length) {
+	char *data;
+	off_t avail;
+
+	if (NULL != c->mem) {
+		data = (char*) c->mem->data;
+	} else if (MAP_FAILED != c->data.file.mmap.data) {
+		data = c->data.file.mmap.data;
+	} else {
+		return NULL;
+	}
+
+	avail = c->data.file.mmap.offset + (off_t) c->data.file.mmap.length - our_start;
+	if (our_start < c->data.file.mmap.offset || avail <= 0) return NULL;
+
+	if (*length > avail) *length = avail;
+	return data + (our_start - c->data.file.mmap.offset);
+}
+
 /* get the data from a chunk; easy in case of a STRING_CHUNK,
  * but needs to do io in case of FILE_CHUNK; the data is _not_ marked as "done"
  * may return HANDLER_GO_ON, HANDLER_ERROR
@@ -102,6 +189,9 @@ liHandlerResult li_chunkiter_read(liChunkIter iter, off_t start, off_t length, c
 
 	switch (c->type) {
 	case UNUSED_CHUNK: return LI_HANDLER_ERROR;
+	case PIPE_CHUNK:
+		g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkiter_read: can't read data from a pipe chunk");
+		return LI_HANDLER_ERROR;
 	case STRING_CHUNK:
 		*data_start = c->data.str->str + c->offset + start;
 		*data_len = length;
@@ -111,17 +201,29 @@ liHandlerResult li_chunkiter_read(liChunkIter iter, off_t start, off_t length, c
 		*data_len = length;
 		break;
 	case FILE_CHUNK:
+		our_start = start + c->offset + c->data.file.start;
+
+		/* data already loaded (li_chunkiter_read_mmap, li_chunkiter_read_async) */
+		if (NULL != (*data_start = chunk_file_cached(c, our_start, &length))) {
+			*data_len = length;
+			break;
+		}
+
 		if (LI_HANDLER_GO_ON != (res = li_chunkfile_open(c->data.file.file, err))) return res;
 
 		if (length > MAX_MMAP_CHUNK) length = MAX_MMAP_CHUNK;
 
+		if (MAP_FAILED != c->data.file.mmap.data) {
+			munmap(c->data.file.mmap.data, c->data.file.mmap.length);
+			c->data.file.mmap.data = MAP_FAILED;
+		}
 		if (!c->mem) {
 			c->mem = g_byte_array_sized_new(length);
 		} else {
 			g_byte_array_set_size(c->mem, length);
 		}
-
-		our_start = start + c->offset + c->data.file.start;
+		c->data.file.mmap.offset = our_start;
+		c->data.file.mmap.length = length;
 
 read_chunk:
 		if (-1 == (we_have = pread(c->data.file.file->fd, c->mem->data, length, our_start))) {
@@ -143,6 +245,7 @@ read_chunk:
 				return LI_HANDLER_ERROR;
 			}
 			length = we_have;
+			c->data.file.mmap.length = length;
 			g_byte_array_set_size(c->mem, length);
 		}
 		*data_start = (char*) c->mem->data;
@@ -176,6 +279,9 @@ liHandlerResult li_chunkiter_read_mmap(liChunkIter iter, off_t start, off_t leng
 
 	switch (c->type) {
 	case UNUSED_CHUNK: return LI_HANDLER_ERROR;
+	case PIPE_CHUNK:
+		g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkiter_read: can't read data from a pipe chunk");
+		return LI_HANDLER_ERROR;
 	case STRING_CHUNK:
 		*data_start = c->data.str->str + c->offset + start;
 		*data_len = length;
@@ -268,6 +374,187 @@ read_chunk:
 	return LI_HANDLER_GO_ON;
 }
 
+/* size of a read in li_chunkiter_read_async; the following block is announced with posix_fadvise(WILLNEED) */
+#define ASYNC_READ_CHUNK (256*1024)
+
+struct liChunkAsyncRead {
+	liChunk *chunk; /* NULL if the chunk was freed while reading */
+	liChunkFile *file;
+	liJobRef *wakeup;
+
+	off_t offset, readahead;
+	GByteArray *mem;
+	int error; /* errno of pread, -1 for unexpected end of file */
+	gboolean done;
+};
+
+static void chunk_async_read_free(liChunkAsyncRead *ar) {
+	li_chunkfile_release(ar->file);
+	if (NULL != ar->wakeup) li_job_ref_release(ar->wakeup);
+	if (NULL != ar->mem) g_byte_array_free(ar->mem, TRUE);
+	g_slice_free(liChunkAsyncRead, ar);
+}
+
+/* runs in the tasklet pool */
+static void chunk_async_read_run(gpointer data) {
+	liChunkAsyncRead *ar = data;
+	ssize_t r;
+
+	while (-1 == (r = pread(ar->file->fd, ar->mem->data, ar->mem->len, ar->offset))) {
+		if (EINTR != errno) {
+			ar->error = errno;
+			return;
+		}
+	}
+	if (0 == r) {
+		ar->error = -1;
+		return;
+	}
+	g_byte_array_set_size(ar->mem, r);
+
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+	if (ar->readahead > 0) {
+		posix_fadvise(ar->file->fd, ar->offset + r, ar->readahead, POSIX_FADV_WILLNEED);
+	}
+#endif
+}
+
+/* runs in the loop of the tasklet pool */
+static void chunk_async_read_finished(gpointer data) {
+	liChunkAsyncRead *ar = data;
+	liChunk *c = ar->chunk;
+
+	ar->done = TRUE;
+
+	if (NULL == c) {
+		chunk_async_read_free(ar);
+		return;
+	}
+
+	li_job_later_ref(ar->wakeup);
+
+	if (0 != ar->error) return; /* keep the error for the next li_chunkiter_read_async */
+
+	/* replace the loaded data */
+	c->data.file.async_read = NULL;
+	if (MAP_FAILED != c->data.file.mmap.data) {
+		munmap(c->data.file.mmap.data, c->data.file.mmap.length);
+		c->data.file.mmap.data = MAP_FAILED;
+	}
+	if (NULL != c->mem) g_byte_array_free(c->mem, TRUE);
+	c->mem = ar->mem;
+	ar->mem = NULL;
+	c->data.file.mmap.offset = ar->offset;
+	c->data.file.mmap.length = c->mem->len;
+
+	chunk_async_read_free(ar);
+}
+
+liHandlerResult li_chunkiter_read_async(liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, liTaskletPool *pool, liJobRef *wakeup, GError **err) {
+	liChunk *c = li_chunkiter_chunk(iter);
+	liChunkAsyncRead *ar;
+	off_t we_have, we_want, our_start;
+	liHandlerResult res;
+
+	g_return_val_if_fail (err == NULL || *err == NULL, LI_HANDLER_ERROR);
+
+	if (!c) return LI_HANDLER_ERROR;
+	if (FILE_CHUNK != c->type) return li_chunkiter_read(iter, start, length, data_start, data_len, err);
+	if (!data_start || !data_len) return LI_HANDLER_ERROR;
+
+	we_have = li_chunk_length(c) - start;
+	if (length > we_have) length = we_have;
+	if (length <= 0) return LI_HANDLER_ERROR;
+
+	if (NULL != (ar = c->data.file.async_read)) {
+		if (!ar->done) {
+			/* still reading; wake the current reader */
+			if (ar->wakeup != wakeup) {
+				li_job_ref_acquire(wakeup);
+				li_job_ref_release(ar->wakeup);
+				ar->wakeup = wakeup;
+			}
+			return LI_HANDLER_WAIT_FOR_EVENT;
+		}
+
+		c->data.file.async_read = NULL;
+		if (-1 == ar->error) {
+			g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkiter_read_async: pread returned 0 bytes for '%s' (fd = %i): unexpected end of file?",
+				GSTR_SAFE_STR(ar->file->name), ar->file->fd);
+		} else {
+			g_set_error(err, LI_CHUNK_ERROR, 0, "li_chunkiter_read_async: pread failed for '%s' (fd = %i): %s",
+				GSTR_SAFE_STR(ar->file->name), ar->file->fd,
+				g_strerror(ar->error));
+		}
+		chunk_async_read_free(ar);
+		return LI_HANDLER_ERROR;
+	}
+
+	our_start = start + c->offset + c->data.file.start;
+
+	if (NULL != (*data_start = chunk_file_cached(c, our_start, &length))) {
+		*data_len = length;
+		return LI_HANDLER_GO_ON;
+	}
+
+	if (LI_HANDLER_GO_ON != (res = li_chunkfile_open(c->data.file.file, err))) return res;
+
+	we_want = MAX(length, ASYNC_READ_CHUNK);
+	if (we_want > MAX_MMAP_CHUNK) we_want = MAX_MMAP_CHUNK;
+	if (we_want > we_have) we_want = we_have;
+
+	ar = g_slice_new0(liChunkAsyncRead);
+	ar->chunk = c;
+	li_chunkfile_acquire(c->data.file.file);
+	ar->file = c->data.file.file;
+	li_job_ref_acquire(wakeup);
+	ar->wakeup = wakeup;
+	ar->offset = our_start;
+	ar->readahead = MIN(we_have - we_want, ASYNC_READ_CHUNK);
+	ar->mem = g_byte_array_sized_new(we_want);
+	g_byte_array_set_size(ar->mem, we_want);
+
+	c->data.file.async_read = ar;
+	li_tasklet_push(pool, chunk_async_read_run, chunk_async_read_finished, ar);
+
+	return LI_HANDLER_WAIT_FOR_EVENT;
+}
+
+guint li_chunkiter_gather_iovec(liChunkIter *iter, struct iovec *iov, guint iov_max, goffset max_length, goffset *length) {
+	liChunk *c;
+	guint n = 0;
+	goffset we_have = 0;
+
+	while (n < iov_max && we_have < max_length && NULL != (c = li_chunkiter_chunk(*iter))) {
+		goffset len = li_chunk_length(c);
+
+		switch (c->type) {
+		case STRING_CHUNK:
+			iov[n].iov_base = c->data.str->str + c->offset;
+			break;
+		case MEM_CHUNK:
+			iov[n].iov_base = c->mem->data + c->offset;
+			break;
+		case BUFFER_CHUNK:
+			iov[n].iov_base = c->data.buffer.buffer->addr + c->data.buffer.offset + c->offset;
+			break;
+		default:
+			goto out;
+		}
+
+		if (len > max_length - we_have) len = max_length - we_have;
+		iov[n].iov_len = len;
+		we_have += len;
+		n++;
+
+		if (!li_chunkiter_next(iter)) break;
+	}
+
+out:
+	*length = we_have;
+	return n;
+}
+
 /******************
  *     chunk      *
  ******************/
@@ -303,10 +590,23 @@ static void chunk_free(liChunkQueue *cq, liChunk *c) {
 			munmap(c->data.file.mmap.data, c->data.file.mmap.length);
 			c->data.file.mmap.data = MAP_FAILED;
 		}
+		if (NULL != c->data.file.async_read) {
+			/* a running read frees itself when done */
+			if (c->data.file.async_read->done) {
+				chunk_async_read_free(c->data.file.async_read);
+			} else {
+				c->data.file.async_read->chunk = NULL;
+			}
+			c->data.file.async_read = NULL;
+		}
 		break;
 	case BUFFER_CHUNK:
 		li_buffer_release(c->data.buffer.buffer);
 		break;
+	case PIPE_CHUNK:
+		li_chunkpipe_release(c->data.pipe.pipe);
+		c->data.pipe.pipe = NULL;
+		break;
 	}
 	c->type = UNUSED_CHUNK;
 	if (c->mem) {
@@ -425,6 +725,7 @@ static void __chunk_free(gpointer _c, gpointer userdata) {
 	if (c->type == STRING_CHUNK) cqlimit_update(cq, - (goffset)c->data.str->len);
 	else if (c->type == MEM_CHUNK) cqlimit_update(cq, - (goffset)c->mem->len);
 	else if (c->type == BUFFER_CHUNK) cqlimit_update(cq, - (goffset)c->data.buffer.length);
+	else if (c->type == PIPE_CHUNK) cqlimit_update(cq, - c->data.pipe.length);
 	chunk_free(cq, c);
 }
 
@@ -583,6 +884,33 @@ void li_chunkqueue_append_chunkfile(liChunkQueue *cq, liChunkFile *cf, off_t sta
 	}
 }
 
+void li_chunkqueue_append_pipe(liChunkQueue *cq, liChunkPipe *cp, goffset length) {
+	liChunk *c;
+
+	if (length <= 0) return;
+
+	c = g_queue_peek_tail(&cq->queue);
+	if (NULL != c && PIPE_CHUNK == c->type && cp == c->data.pipe.pipe
+	    && c->data.pipe.start + c->data.pipe.length == cp->write_pos) {
+		c->data.pipe.length += length;
+	} else {
+		c = chunk_new();
+		li_chunkpipe_acquire(cp);
+
+		c->type = PIPE_CHUNK;
+		c->data.pipe.pipe = cp;
+		c->data.pipe.start = cp->write_pos;
+		c->data.pipe.length = length;
+
+		g_queue_push_tail_link(&cq->queue, &c->cq_link);
+	}
+	cp->write_pos += length;
+
+	cq->length += length;
+	cq->bytes_in += length;
+	cqlimit_update(cq, length);
+}
+
 static void __chunkqueue_append_file(liChunkQueue *cq, GString *filename, off_t start, off_t length, int fd, gboolean is_temp) {
 	liChunk *c = chunk_new();
 	c->type = FILE_CHUNK;
@@ -639,6 +967,7 @@ goffset li_chunkqueue_steal_len(liChunkQueue *out, liChunkQueue *in, goffset len
 			if (c->type == STRING_CHUNK) meminbytes -= c->data.str->len;
 			else if (c->type == MEM_CHUNK) meminbytes -= c->mem->len;
 			else if (c->type == BUFFER_CHUNK) meminbytes -= c->data.buffer.length;
+			else if (c->type == PIPE_CHUNK) meminbytes -= c->data.pipe.length;
 			chunk_free(in, c);
 			continue;
 		}
@@ -655,6 +984,9 @@ goffset li_chunkqueue_steal_len(liChunkQueue *out, liChunkQueue *in, goffset len
 			} else if (c->type == BUFFER_CHUNK) {
 				meminbytes -= c->data.buffer.length;
 				memoutbytes += c->data.buffer.length;
+			} else if (c->type == PIPE_CHUNK) {
+				meminbytes -= c->data.pipe.length;
+				memoutbytes += c->data.pipe.length;
 			}
 			length -= we_have;
 		} else { /* copy first part of a chunk */
@@ -692,6 +1024,15 @@ goffset li_chunkqueue_steal_len(liChunkQueue *out, liChunkQueue *in, goffset len
 				cnew->data.buffer.length = length;
 				memoutbytes += length;
 				break;
+			case PIPE_CHUNK:
+				/* the first part is consumed first, so the pipe data is still in order */
+				cnew->type = PIPE_CHUNK;
+				li_chunkpipe_acquire(c->data.pipe.pipe);
+				cnew->data.pipe.pipe = c->data.pipe.pipe;
+				cnew->data.pipe.start = c->data.pipe.start + c->offset;
+				cnew->data.pipe.length = length;
+				memoutbytes += length;
+				break;
 			}
 			c->offset += length;
 			bytes += length;
@@ -761,6 +1102,9 @@ goffset li_chunkqueue_steal_chunk(liChunkQueue *out, liChunkQueue *in) {
 		} else if (c->type == BUFFER_CHUNK) {
 			cqlimit_update(out, c->data.buffer.length);
 			cqlimit_update(in, - (goffset)c->data.buffer.length);
+		} else if (c->type == PIPE_CHUNK) {
+			cqlimit_update(out, c->data.pipe.length);
+			cqlimit_update(in, - c->data.pipe.length);
 		}
 	}
 	return length;
@@ -778,6 +1122,7 @@ goffset li_chunkqueue_skip(liChunkQueue *cq, goffset length) {
 			if (c->type == STRING_CHUNK) cqlimit_update(cq, - (goffset)c->data.str->len);
 			else if (c->type == MEM_CHUNK) cqlimit_update(cq, - (goffset)c->mem->len);
 			else if (c->type == BUFFER_CHUNK) cqlimit_update(cq, - (goffset)c->data.buffer.length);
+			else if (c->type == PIPE_CHUNK) cqlimit_update(cq, - c->data.pipe.length);
 			chunk_free(cq, c);
 			bytes += we_have;
 			length -= we_have;
@@ -31,13 +31,128 @@ static const liConditionValueType cond_value_hints[] = {
 };
 #endif
 
-/* uses tmpstr for temporary (and returned) strings */
-liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liConditionLValue *lvalue, liConditionValue *res, liConditionValueType prefer) {
-	liConInfo *coninfo = vr->coninfo;
+/* header values cached per vrequest */
+#define CONDITION_CACHE_HEADERS 8
+
+typedef struct condition_cache_header condition_cache_header;
+struct condition_cache_header {
+	liHttpHeaders *headers; /* NULL: unused */
+	guint version;
+	GString *key, *value;
+};
+
+void li_condition_cache_init(liConditionCache *cache) {
+	memset(cache, 0, sizeof(*cache));
+	cache->headers = g_array_sized_new(FALSE, TRUE, sizeof(condition_cache_header), CONDITION_CACHE_HEADERS);
+	cache->retired = g_ptr_array_new();
+}
+
+void li_condition_cache_reset(liConditionCache *cache) {
+	guint i;
+
+	/* files might have changed until the next request */
+	cache->stat_valid = FALSE;
+
+	/* forget the header values, but keep the buffers */
+	for (i = 0; i < cache->headers->len; i++) {
+		g_array_index(cache->headers, condition_cache_header, i).headers = NULL;
+	}
+
+	/* nothing references the snapshots anymore (the regex stack is empty); the current ones stay valid
+	 * as they are compared with the field before use */
+	for (i = 0; i < cache->retired->len; i++) {
+		g_string_free(g_ptr_array_index(cache->retired, i), TRUE);
+	}
+	g_ptr_array_set_size(cache->retired, 0);
+}
+
+void li_condition_cache_clear(liConditionCache *cache) {
+	guint i;
+
+	li_condition_cache_reset(cache);
+
+	if (NULL != cache->stat_path) g_string_free(cache->stat_path, TRUE);
+
+	for (i = 0; i < cache->headers->len; i++) {
+		condition_cache_header *ch = &g_array_index(cache->headers, condition_cache_header, i);
+		g_string_free(ch->key, TRUE);
+		g_string_free(ch->value, TRUE);
+	}
+	g_array_free(cache->headers, TRUE);
+
+	for (i = 0; i < G_N_ELEMENTS(cache->snapshots); i++) {
+		if (NULL != cache->snapshots[i]) g_string_free(cache->snapshots[i], TRUE);
+	}
+	g_ptr_array_free(cache->retired, TRUE);
+
+	memset(cache, 0, sizeof(*cache));
+}
+
+/* stat() physical.path once as long as it doesn't change */
+static liHandlerResult condition_cache_stat(liVRequest *vr, liConditionCache *cache) {
+	GString *path = vr->physical.path;
 	liHandlerResult r;
 	struct stat st;
 	int err;
 
+	if (cache->stat_valid && g_string_equal(cache->stat_path, path)) return LI_HANDLER_GO_ON;
+
+	r = li_stat_cache_get(vr, path, &st, &err, NULL);
+	if (r == LI_HANDLER_WAIT_FOR_EVENT) return r;
+
+	if (NULL == cache->stat_path) cache->stat_path = g_string_sized_new(path->len);
+	g_string_truncate(cache->stat_path, 0);
+	g_string_append_len(cache->stat_path, GSTR_LEN(path));
+
+	cache->stat_valid = TRUE;
+	/* not found (or another error) */
+	cache->stat_found = (r == LI_HANDLER_GO_ON);
+	cache->stat_isdir = cache->stat_found && S_ISDIR(st.st_mode);
+	cache->stat_isfile = cache->stat_found && S_ISREG(st.st_mode);
+	cache->stat_size = cache->stat_found ? (goffset) st.st_size : -1;
+
+	return LI_HANDLER_GO_ON;
+}
+
+/* li_http_header_get_all, as long as the header list doesn't change */
+static const gchar* condition_cache_header_get(liConditionCache *cache, liHttpHeaders *headers, GString *key) {
+	condition_cache_header *ch;
+	guint i;
+
+	for (i = 0; i < cache->headers->len; i++) {
+		ch = &g_array_index(cache->headers, condition_cache_header, i);
+		if (ch->headers == headers && ch->version == headers->version && g_string_equal(ch->key, key)) {
+			return ch->value->str;
+		}
+	}
+
+	if (cache->headers->len < CONDITION_CACHE_HEADERS) {
+		g_array_set_size(cache->headers, cache->headers->len + 1);
+		ch = &g_array_index(cache->headers, condition_cache_header, cache->headers->len - 1);
+		ch->key = g_string_sized_new(key->len);
+		ch->value = g_string_sized_new(31);
+	} else {
+		ch = &g_array_index(cache->headers, condition_cache_header, cache->headers_next);
+		cache->headers_next = (cache->headers_next + 1) % CONDITION_CACHE_HEADERS;
+	}
+
+	ch->headers = headers;
+	ch->version = headers->version;
+	g_string_truncate(ch->key, 0);
+	g_string_append_len(ch->key, GSTR_LEN(key));
+	li_http_header_get_all(ch->value, headers, GSTR_LEN(key));
+
+	return ch->value->str;
+}
+
+/* returned strings are valid until the request changes or the next call; header values come from
+ * vr->condition_cache (tmpstr isn't needed anymore) */
+liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liConditionLValue *lvalue, liConditionValue *res, liConditionValueType prefer) {
+	liConInfo *coninfo = vr->coninfo;
+	liConditionCache *cache = &vr->condition_cache;
+	liHandlerResult r;
+	UNUSED(tmpstr);
+
 	res->match_type = LI_COND_VALUE_HINT_ANY;
 	res->data.str = "";
 
@@ -137,17 +252,16 @@ liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liCondit
 			break;
 		}
 
-		r = li_stat_cache_get(vr, vr->physical.path, &st, &err, NULL);
+		r = condition_cache_stat(vr, cache);
 		if (r == LI_HANDLER_WAIT_FOR_EVENT) return r;
 
-		/* not found, return FALSE */
-		if (r != LI_HANDLER_GO_ON) break;
+		/* not found: FALSE */
 		if (lvalue->type == LI_COMP_PHYSICAL_ISFILE) {
-			res->data.bool = S_ISREG(st.st_mode);
+			res->data.bool = cache->stat_isfile;
 		} else if (lvalue->type == LI_COMP_PHYSICAL_ISDIR) {
-			res->data.bool = S_ISDIR(st.st_mode);
+			res->data.bool = cache->stat_isdir;
 		} else {
-			res->data.bool = TRUE;
+			res->data.bool = cache->stat_found;
 		}
 		break;
 	case LI_COMP_PHYSICAL_SIZE:
@@ -157,12 +271,11 @@ liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liCondit
 			break;
 		}
 
-		r = li_stat_cache_get(vr, vr->physical.path, &st, &err, NULL);
+		r = condition_cache_stat(vr, cache);
 		if (r == LI_HANDLER_WAIT_FOR_EVENT) return r;
 
-		if (r == LI_HANDLER_GO_ON) { /* not found -> size "-1" */
-			res->data.number = (gint64) st.st_size;
-		}
+		/* not found -> size "-1" */
+		res->data.number = cache->stat_size;
 		break;
 	case LI_COMP_PHYSICAL_DOCROOT:
 		res->match_type = LI_COND_VALUE_HINT_STRING;
@@ -179,14 +292,12 @@ liHandlerResult li_condition_get_value(GString *tmpstr, liVRequest *vr, liCondit
 		break;
 	case LI_COMP_REQUEST_HEADER:
 		res->match_type = LI_COND_VALUE_HINT_STRING;
-		li_http_header_get_all(tmpstr, vr->request.headers, GSTR_LEN(lvalue->key));
-		res->data.str = tmpstr->str;
+		res->data.str = condition_cache_header_get(cache, vr->request.headers, lvalue->key);
 		break;
 	case LI_COMP_RESPONSE_HEADER:
 		LI_VREQUEST_WAIT_FOR_RESPONSE_HEADERS(vr);
 		res->match_type = LI_COND_VALUE_HINT_STRING;
-		li_http_header_get_all(tmpstr, vr->response.headers, GSTR_LEN(lvalue->key));
-		res->data.str = tmpstr->str;
+		res->data.str = condition_cache_header_get(cache, vr->response.headers, lvalue->key);
 		break;
 	case LI_COMP_ENVIRONMENT:
 		res->match_type = LI_COND_VALUE_HINT_STRING;
@@ -307,10 +418,10 @@ static liCondition* cond_new_string(liCompOperator op, liConditionLValue *lvalue
 /* only MATCH and NOMATCH */
 static liCondition* cond_new_match(liServer *srv, liCompOperator op, liConditionLValue *lvalue, GString *str) {
 	liCondition *c;
-	GRegex *regex;
+	liRegex *regex;
 	GError *err = NULL;
 
-	regex = g_regex_new(str->str, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &err);
+	regex = li_regex_new(str->str, &err);
 
 	if (!regex || err) {
 		ERROR(srv, "failed to compile regex \"%s\": %s", str->str, err->message);
@@ -418,7 +529,7 @@ static void condition_free(liCondition *c) {
 		g_string_free(c->rvalue.string, TRUE);
 		break;
 	case LI_COND_VALUE_REGEXP:
-		g_regex_unref(c->rvalue.regex);
+		li_regex_release(c->rvalue.regex);
 		break;
 	case LI_COND_VALUE_SOCKET_IPV4:
 	case LI_COND_VALUE_SOCKET_IPV6:
@@ -613,14 +724,101 @@ static liHandlerResult li_condition_check_eval_bool(liVRequest *vr, liCondition
 	return LI_HANDLER_GO_ON;
 }
 
+/* lvalues which are plain request strings; NULL for all others */
+static GString* condition_string_lvalue(liVRequest *vr, liConditionLValue *lvalue) {
+	switch (lvalue->type) {
+	case LI_COMP_REQUEST_PATH: return vr->request.uri.path;
+	case LI_COMP_REQUEST_RAW_PATH: return vr->request.uri.raw_path;
+	case LI_COMP_REQUEST_HOST: return vr->request.uri.host;
+	case LI_COMP_REQUEST_QUERY_STRING: return vr->request.uri.query;
+	case LI_COMP_REQUEST_METHOD: return vr->request.http_method_str;
+	case LI_COMP_PHYSICAL_PATH: return vr->physical.path;
+	case LI_COMP_PHYSICAL_DOCROOT: return vr->physical.doc_root;
+	case LI_COMP_PHYSICAL_PATHINFO: return vr->physical.pathinfo;
+	default: return NULL;
+	}
+}
+
+/* ==, =^ and =$ (and negations) against a known string: compare with the known lengths */
+static gboolean condition_string_compare(liCompOperator op, GString *val, GString *str) {
+	switch (op) {
+	case LI_CONFIG_COND_EQ:
+	case LI_CONFIG_COND_NE:
+		/* like g_str_equal: val ends at the first \0 */
+		return (op == LI_CONFIG_COND_EQ) == (val->len >= str->len && '\0' == val->str[str->len] && 0 == memcmp(val->str, str->str, str->len));
+	case LI_CONFIG_COND_PREFIX:
+	case LI_CONFIG_COND_NOPREFIX:
+		return (op == LI_CONFIG_COND_PREFIX) == (val->len >= str->len && 0 == memcmp(val->str, str->str, str->len));
+	case LI_CONFIG_COND_SUFFIX:
+	case LI_CONFIG_COND_NOSUFFIX:
+		return (op == LI_CONFIG_COND_SUFFIX) == (val->len >= str->len && 0 == memcmp(val->str + val->len - str->len, str->str, str->len));
+	default:
+		return FALSE;
+	}
+}
+
+/* subject for a regex match; the match references it, so it has to stay valid while on the regex stack.
+ * fields get a per vrequest copy which is shared until the field changes; *copy (freed with the regex stack
+ * element) is set for all other values
+ */
+static const gchar* condition_regex_subject(liVRequest *vr, liConditionLValue *lvalue, const gchar *val, GString **copy) {
+	liConditionCache *cache = &vr->condition_cache;
+	GString *field = condition_string_lvalue(vr, lvalue), *snapshot;
+
+	*copy = NULL;
+
+	if (NULL == field) {
+		*copy = g_string_new(val);
+		return (*copy)->str;
+	}
+
+	snapshot = cache->snapshots[lvalue->type];
+	if (NULL != snapshot && g_string_equal(snapshot, field)) return snapshot->str;
+
+	/* the old copy might still be in use */
+	if (NULL != snapshot) g_ptr_array_add(cache->retired, snapshot);
+	snapshot = cache->snapshots[lvalue->type] = g_string_new_len(GSTR_LEN(field));
+
+	return snapshot->str;
+}
+
+/* a failing match (match limit, ...) counts as no match */
+static gboolean condition_regex_match(liVRequest *vr, liRegex *regex, const gchar *val, liRegexMatch **match) {
+	GError *err = NULL;
+	gboolean res = li_regex_match(regex, val, match, &err);
+
+	if (NULL != err) {
+		VR_ERROR(vr, "%s", err->message);
+		g_error_free(err);
+	}
+
+	return res;
+}
+
 /* LI_COND_VALUE_STRING and LI_COND_VALUE_REGEXP only */
 static liHandlerResult li_condition_check_eval_string(liVRequest *vr, liCondition *cond, gboolean *res) {
 	liActionRegexStackElement arse;
 	liConditionValue match_val;
 	liHandlerResult r;
 	const char *val = "";
+	GString *field;
 	*res = FALSE;
 
+	if (LI_COND_VALUE_STRING == cond->rvalue.type && NULL != (field = condition_string_lvalue(vr, cond->lvalue))) {
+		switch (cond->op) {
+		case LI_CONFIG_COND_EQ:
+		case LI_CONFIG_COND_NE:
+		case LI_CONFIG_COND_PREFIX:
+		case LI_CONFIG_COND_NOPREFIX:
+		case LI_CONFIG_COND_SUFFIX:
+		case LI_CONFIG_COND_NOSUFFIX:
+			*res = condition_string_compare(cond->op, field, cond->rvalue.string);
+			return LI_HANDLER_GO_ON;
+		default:
+			break;
+		}
+	}
+
 	r = li_condition_get_value(vr->wrk->tmp_str, vr, cond->lvalue, &match_val, LI_COND_VALUE_HINT_STRING);
 	if (r != LI_HANDLER_GO_ON) return r;
 
@@ -646,23 +844,19 @@ static liHandlerResult li_condition_check_eval_string(liVRequest *vr, liConditio
 		*res = !g_str_has_suffix(val, cond->rvalue.string->str);
 		break;
 	case LI_CONFIG_COND_MATCH:
-		arse.match_info = NULL;
-		arse.string = g_string_new(val); /* we have to copy the value, as match-info references it */
-		*res = g_regex_match(cond->rvalue.regex, arse.string->str, 0, &arse.match_info);
+		val = condition_regex_subject(vr, cond->lvalue, val, &arse.string);
+		*res = condition_regex_match(vr, cond->rvalue.regex, val, &arse.match);
 		if (*res) {
 			g_array_append_val(vr->action_stack.regex_stack, arse);
 		} else {
-			g_match_info_free(arse.match_info);
-			g_string_free(arse.string, TRUE);
+			if (NULL != arse.string) g_string_free(arse.string, TRUE);
 		}
 		break;
 	case LI_CONFIG_COND_NOMATCH:
-		arse.match_info = NULL;
-		arse.string = g_string_new(val); /* we have to copy the value, as match-info references it */
-		*res = !g_regex_match(cond->rvalue.regex, arse.string->str, 0, &arse.match_info);
+		val = condition_regex_subject(vr, cond->lvalue, val, &arse.string);
+		*res = !condition_regex_match(vr, cond->rvalue.regex, val, &arse.match);
 		if (*res) {
-			g_match_info_free(arse.match_info);
-			g_string_free(arse.string, TRUE);
+			if (NULL != arse.string) g_string_free(arse.string, TRUE);
 		} else {
 			g_array_append_val(vr->action_stack.regex_stack, arse);
 		}
@@ -825,3 +1019,154 @@ liHandlerResult li_condition_check(liVRequest *vr, liCondition *cond, gboolean *
 	VR_ERROR(vr, "Unsupported conditional type: %i", cond->rvalue.type);
 	return LI_HANDLER_ERROR;
 }
+
+struct liConditionSwitch {
+	liCompOperator op; /* EQ, PREFIX or SUFFIX */
+	liConditionLValue *lvalue;
+	guint count;
+
+	GHashTable *strings; /* EQ: string -> index+1 */
+
+	/* PREFIX/SUFFIX (suffixes are stored reversed): string -> index+1 of the first entry matching it.
+	 * the longest stored prefix of a value has the smallest index of all prefixes of the value */
+	liRadixTree *tree;
+	gsize max_len; /* longer prefixes don't need to be looked at */
+	guint empty_ndx; /* "" matches everything; G_MAXUINT if not present */
+};
+
+static gboolean condition_switch_fits(liConditionSwitch *sw, liCondition *cond) {
+	if (LI_COND_VALUE_STRING != cond->rvalue.type || cond->op != sw->op) return FALSE;
+	if (cond->lvalue == sw->lvalue) return TRUE;
+	if (cond->lvalue->type != sw->lvalue->type) return FALSE;
+	if (NULL == cond->lvalue->key || NULL == sw->lvalue->key) return cond->lvalue->key == sw->lvalue->key;
+	return g_string_equal(cond->lvalue->key, sw->lvalue->key);
+}
+
+liConditionSwitch* li_condition_switch_new(liCondition *first) {
+	liConditionSwitch *sw;
+
+	if (LI_COND_VALUE_STRING != first->rvalue.type) return NULL;
+
+	switch (first->op) {
+	case LI_CONFIG_COND_EQ:
+	case LI_CONFIG_COND_PREFIX:
+	case LI_CONFIG_COND_SUFFIX:
+		break;
+	default:
+		return NULL;
+	}
+
+	sw = g_slice_new0(liConditionSwitch);
+	sw->op = first->op;
+	li_condition_lvalue_acquire(first->lvalue);
+	sw->lvalue = first->lvalue;
+	sw->empty_ndx = G_MAXUINT;
+
+	if (LI_CONFIG_COND_EQ == sw->op) {
+		sw->strings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	} else {
+		sw->tree = li_radixtree_new();
+	}
+
+	li_condition_switch_add(sw, first);
+
+	return sw;
+}
+
+gboolean li_condition_switch_add(liConditionSwitch *sw, liCondition *cond) {
+	GString *str = cond->rvalue.string;
+	guint ndx;
+
+	if (!condition_switch_fits(sw, cond)) return FALSE;
+
+	ndx = sw->count++;
+
+	if (LI_CONFIG_COND_EQ == sw->op) {
+		/* the first entry for a string wins */
+		if (NULL == g_hash_table_lookup(sw->strings, str->str)) {
+			g_hash_table_insert(sw->strings, g_strndup(GSTR_LEN(str)), GUINT_TO_POINTER(ndx + 1));
+		}
+	} else if (0 == str->len) {
+		sw->empty_ndx = MIN(sw->empty_ndx, ndx);
+	} else {
+		gchar *key = g_strndup(GSTR_LEN(str));
+		gpointer prev;
+
+		if (LI_CONFIG_COND_SUFFIX == sw->op) g_strreverse(key);
+
+		/* entries added before have smaller indices: if a prefix of key is stored already, it wins */
+		if (NULL == li_radixtree_lookup_exact(sw->tree, key, str->len * 8)) {
+			prev = li_radixtree_lookup(sw->tree, key, str->len * 8);
+			li_radixtree_insert(sw->tree, key, str->len * 8, NULL != prev ? prev : GUINT_TO_POINTER(ndx + 1));
+		}
+		sw->max_len = MAX(sw->max_len, str->len);
+
+		g_free(key);
+	}
+
+	return TRUE;
+}
+
+guint li_condition_switch_count(liConditionSwitch *sw) {
+	return sw->count;
+}
+
+void li_condition_switch_free(liConditionSwitch *sw) {
+	if (NULL == sw) return;
+
+	if (NULL != sw->strings) g_hash_table_destroy(sw->strings);
+	if (NULL != sw->tree) li_radixtree_free(sw->tree, NULL, NULL);
+	li_condition_lvalue_release(sw->lvalue);
+
+	g_slice_free(liConditionSwitch, sw);
+}
+
+guint li_condition_switch_match(liConditionSwitch *sw, const gchar *val, gsize len) {
+	gpointer found;
+
+	switch (sw->op) {
+	case LI_CONFIG_COND_EQ:
+		found = g_hash_table_lookup(sw->strings, val);
+		return NULL != found ? GPOINTER_TO_UINT(found) - 1 : G_MAXUINT;
+	case LI_CONFIG_COND_PREFIX:
+		found = (len > 0 && sw->max_len > 0) ? li_radixtree_lookup(sw->tree, val, MIN(len, sw->max_len) * 8) : NULL;
+		break;
+	case LI_CONFIG_COND_SUFFIX:
+		if (len > 0 && sw->max_len > 0) {
+			gsize i, n = MIN(len, sw->max_len);
+			gchar rev[n];
+
+			for (i = 0; i < n; i++) rev[i] = val[len - 1 - i];
+			found = li_radixtree_lookup(sw->tree, rev, n * 8);
+		} else {
+			found = NULL;
+		}
+		break;
+	default:
+		return G_MAXUINT;
+	}
+
+	return MIN(NULL != found ? GPOINTER_TO_UINT(found) - 1 : G_MAXUINT, sw->empty_ndx);
+}
+
+liHandlerResult li_condition_switch_check(liVRequest *vr, liConditionSwitch *sw, guint *ndx) {
+	liConditionValue match_val;
+	liHandlerResult r;
+	const char *val;
+	GString *field;
+
+	*ndx = G_MAXUINT;
+
+	if (NULL != (field = condition_string_lvalue(vr, sw->lvalue))) {
+		*ndx = li_condition_switch_match(sw, field->str, field->len);
+		return LI_HANDLER_GO_ON;
+	}
+
+	r = li_condition_get_value(vr->wrk->tmp_str, vr, sw->lvalue, &match_val, LI_COND_VALUE_HINT_STRING);
+	if (r != LI_HANDLER_GO_ON) return r;
+
+	val = li_condition_value_to_string(vr->wrk->tmp_str, &match_val);
+	*ndx = li_condition_switch_match(sw, val, strlen(val));
+
+	return LI_HANDLER_GO_ON;
+}
@@ -131,15 +131,30 @@ static liThrottleState* simple_tcp_throttle_in(liConnection *con) {
 	return data->sock_stream->throttle_in;
 }
 
+static void simple_tcp_idle(liConnection *con) {
+	simple_tcp_connection *data = con->con_sock.data;
+	if (NULL == data) return;
+	li_stream_simple_socket_release_buffer(&data->simple_tcp_context);
+}
+
 static const liConnectionSocketCallbacks simple_tcp_cbs = {
 	simple_tcp_finished,
 	simple_tcp_throttle_out,
-	simple_tcp_throttle_in
+	simple_tcp_throttle_in,
+	simple_tcp_idle
 };
 
 static gboolean simple_tcp_new(liConnection *con, int fd) {
 	simple_tcp_connection *data = g_slice_new0(simple_tcp_connection);
 	data->sock_stream = li_iostream_new(con->wrk, fd, simple_tcp_io_cb, data);
+	data->sock_stream->use_uring = TRUE;
+	con->info.splice_out = TRUE;
+	if (con->srv->zerocopy_min_size > 0) {
+		data->sock_stream->zerocopy = li_network_zerocopy_new(con->srv->zerocopy_min_size);
+	}
+	if (con->srv->notsent_lowat > 0 && li_network_set_notsent_lowat(fd, con->srv->notsent_lowat)) {
+		data->sock_stream->notsent_lowat = con->srv->notsent_lowat;
+	}
 	data->simple_tcp_context = NULL;
 	data->con = con;
 	con->con_sock.data = data;
@@ -506,20 +521,25 @@ void li_connection_update_io_wait(liConnection *con) {
 }
 
 
-void li_connection_start(liConnection *con, liSocketAddress remote_addr, int s, liServerSocket *srv_sock) {
+void li_connection_start(liConnection *con, const liSockAddr *remote_addr, socklen_t remote_addr_len, int s, liServerSocket *srv_sock) {
 	LI_FORCE_ASSERT(NULL == con->con_sock.data);
 
 	con->srv_sock = srv_sock;
 	con->state = LI_CON_STATE_REQUEST_START;
 	con->mainvr->ts_started = con->ts_started = li_cur_ts(con->wrk);
 
-	con->info.remote_addr = remote_addr;
-	li_sockaddr_to_string(remote_addr, con->info.remote_addr_str, FALSE);
+	con->info.remote_addr.len = MIN(remote_addr_len, (socklen_t) sizeof(con->remote_addr_storage));
+	con->info.remote_addr.addr = &con->remote_addr_storage;
+	memcpy(&con->remote_addr_storage, remote_addr, con->info.remote_addr.len);
+	li_sockaddr_to_string(con->info.remote_addr, con->info.remote_addr_str, FALSE);
 
-	con->info.local_addr = li_sockaddr_dup(srv_sock->local_addr);
+	con->info.local_addr.len = MIN(srv_sock->local_addr.len, (socklen_t) sizeof(con->local_addr_storage));
+	con->info.local_addr.addr = &con->local_addr_storage;
+	memcpy(&con->local_addr_storage, srv_sock->local_addr.addr, con->info.local_addr.len);
 	li_sockaddr_to_string(con->info.local_addr, con->info.local_addr_str, FALSE);
 
 	con->info.aborted = FALSE;
+	con->info.splice_out = FALSE;
 
 	li_stream_init(&con->in, &con->wrk->loop, _connection_http_in_cb);
 	li_stream_init(&con->out, &con->wrk->loop, _connection_http_out_cb);
@@ -692,6 +712,7 @@ liConnection* li_connection_new(liWorker *wrk) {
 	con->info.remote_addr_str = g_string_sized_new(INET6_ADDRSTRLEN);
 	con->info.local_addr_str = g_string_sized_new(INET6_ADDRSTRLEN);
 	con->info.is_ssl = FALSE;
+	con->info.splice_out = FALSE;
 	con->info.keep_alive = TRUE;
 
 	con->info.req = NULL;
@@ -752,6 +773,7 @@ static void li_connection_reset2(liConnection *con) {
 	li_server_socket_release(con->srv_sock);
 	con->srv_sock = NULL;
 	con->info.is_ssl = FALSE;
+	con->info.splice_out = FALSE;
 	con->info.aborted = FALSE;
 	con->info.out_queue_length = 0;
 
@@ -763,9 +785,11 @@ static void li_connection_reset2(liConnection *con) {
 	li_http_request_parser_reset(&con->req_parser_ctx);
 
 	g_string_truncate(con->info.remote_addr_str, 0);
-	li_sockaddr_clear(&con->info.remote_addr);
+	con->info.remote_addr.addr = NULL;
+	con->info.remote_addr.len = 0;
 	g_string_truncate(con->info.local_addr_str, 0);
-	li_sockaddr_clear(&con->info.local_addr);
+	con->info.local_addr.addr = NULL;
+	con->info.local_addr.len = 0;
 
 	con->info.keep_alive = TRUE;
 	if (con->keep_alive_data.link) {
@@ -802,6 +826,11 @@ static void li_connection_reset_keep_alive(liConnection *con) {
 
 	/* only start keep alive watcher if there isn't more input data already */
 	if (con->con_sock.raw_in->out->length == 0) {
+		/* don't keep an idle read buffer for each waiting connection */
+		if (NULL != con->con_sock.callbacks && NULL != con->con_sock.callbacks->idle) {
+			con->con_sock.callbacks->idle(con);
+		}
+
 		li_event_stop(&con->keep_alive_data.watcher);
 		{
 			con->keep_alive_data.max_idle = CORE_OPTION(LI_CORE_OPTION_MAX_KEEP_ALIVE_IDLE).number;
@@ -877,9 +906,9 @@ void li_connection_free(liConnection *con) {
 	con->srv_sock = NULL;
 
 	g_string_free(con->info.remote_addr_str, TRUE);
-	li_sockaddr_clear(&con->info.remote_addr);
+	con->info.remote_addr.addr = NULL;
 	g_string_free(con->info.local_addr_str, TRUE);
-	li_sockaddr_clear(&con->info.local_addr);
+	con->info.local_addr.addr = NULL;
 
 	li_vrequest_free(con->mainvr);
 	li_http_request_parser_clear(&con->req_parser_ctx);
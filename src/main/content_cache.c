@@ -0,0 +1,131 @@
+#include <lighttpd/base.h>
+#include <sys/stat.h>
+
+static gsize content_cache_entry_mem(liContentCacheEntry *cce) {
+	return sizeof(liContentCacheEntry) + sizeof(liBuffer) + cce->buf->alloc_size + cce->path->len + 1;
+}
+
+static void content_cache_remove(liContentCache *cc, liContentCacheEntry *cce) {
+	g_hash_table_remove(cc->entries, cce->path);
+	g_queue_unlink(&cc->lru, &cce->lru_link);
+	cc->mem_used -= content_cache_entry_mem(cce);
+
+	/* requests still sending the content hold their own references */
+	li_buffer_release(cce->buf);
+	g_string_free(cce->path, TRUE);
+	g_slice_free(liContentCacheEntry, cce);
+}
+
+liContentCache* li_content_cache_new(gsize mem_max, goffset max_file_size) {
+	liContentCache *cc;
+
+	if (0 == mem_max || max_file_size <= 0) return NULL;
+
+	cc = g_slice_new0(liContentCache);
+	cc->entries = g_hash_table_new((GHashFunc) g_string_hash, (GEqualFunc) g_string_equal);
+	cc->mem_max = mem_max;
+	cc->max_file_size = max_file_size;
+
+	return cc;
+}
+
+void li_content_cache_free(liContentCache *cc) {
+	if (!cc)
+		return;
+
+	while (NULL != cc->lru.head) {
+		content_cache_remove(cc, cc->lru.head->data);
+	}
+
+	g_hash_table_destroy(cc->entries);
+	g_slice_free(liContentCache, cc);
+}
+
+gboolean li_content_cache_usable(liContentCache *cc, const struct stat *st) {
+	return NULL != cc && S_ISREG(st->st_mode) && st->st_size > 0 && st->st_size <= cc->max_file_size;
+}
+
+liBuffer* li_content_cache_lookup(liContentCache *cc, GString *path, const struct stat *st) {
+	liContentCacheEntry *cce = g_hash_table_lookup(cc->entries, path);
+
+	if (NULL == cce) {
+		cc->misses++;
+		return NULL;
+	}
+
+	if (cce->ino != st->st_ino || cce->dev != st->st_dev || cce->size != st->st_size
+		|| cce->mtime != st->st_mtime || cce->ctime != st->st_ctime) {
+		/* file changed */
+		content_cache_remove(cc, cce);
+		cc->misses++;
+		return NULL;
+	}
+
+	/* move to front */
+	g_queue_unlink(&cc->lru, &cce->lru_link);
+	g_queue_push_head_link(&cc->lru, &cce->lru_link);
+
+	cc->hits++;
+	cc->bytes_served += cce->size;
+	li_buffer_acquire(cce->buf);
+	return cce->buf;
+}
+
+liBuffer* li_content_cache_insert(liContentCache *cc, GString *path, const struct stat *st, int fd) {
+	liContentCacheEntry *cce;
+	liBuffer *buf;
+	gsize mem;
+
+	if (!li_content_cache_usable(cc, st)) return NULL;
+
+	buf = li_buffer_new_slice(st->st_size);
+	while (buf->used < (gsize) st->st_size) {
+		ssize_t r = pread(fd, buf->addr + buf->used, st->st_size - buf->used, buf->used);
+		if (r < 0) {
+			if (EINTR == errno) continue;
+			li_buffer_release(buf);
+			return NULL;
+		}
+		if (0 == r) {
+			/* file got truncated */
+			li_buffer_release(buf);
+			return NULL;
+		}
+		buf->used += r;
+	}
+
+	cce = g_slice_new0(liContentCacheEntry);
+	cce->path = g_string_new_len(GSTR_LEN(path));
+	cce->dev = st->st_dev;
+	cce->ino = st->st_ino;
+	cce->size = st->st_size;
+	cce->mtime = st->st_mtime;
+	cce->ctime = st->st_ctime;
+	cce->buf = buf;
+	cce->lru_link.data = cce;
+
+	mem = content_cache_entry_mem(cce);
+	if (mem > cc->mem_max) {
+		g_string_free(cce->path, TRUE);
+		g_slice_free(liContentCacheEntry, cce);
+		return buf; /* still use the buffer for this response */
+	}
+
+	{
+		liContentCacheEntry *old = g_hash_table_lookup(cc->entries, path);
+		if (NULL != old) content_cache_remove(cc, old);
+	}
+
+	while (cc->mem_used + mem > cc->mem_max) {
+		content_cache_remove(cc, cc->lru.tail->data);
+		cc->evictions++;
+	}
+
+	g_hash_table_insert(cc->entries, cce->path, cce);
+	g_queue_push_head_link(&cc->lru, &cce->lru_link);
+	cc->mem_used += mem;
+
+	cc->bytes_served += cce->size;
+	li_buffer_acquire(buf);
+	return buf;
+}
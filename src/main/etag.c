@@ -128,58 +128,90 @@ void li_etag_mutate(GString *mut, GString *etag) {
 	g_string_append_len(mut, CONST_STR_LEN("\""));
 }
 
+void li_etag_format(GString *out, guint flags, struct stat *st) {
+	g_string_truncate(out, 0);
+
+	if (flags & LI_ETAG_USE_INODE) {
+		li_string_append_int(out, st->st_ino);
+	}
+
+	if (flags & LI_ETAG_USE_SIZE) {
+		if (out->len != 0) g_string_append_len(out, CONST_STR_LEN("-"));
+		li_string_append_int(out, st->st_size);
+	}
+
+	if (flags & LI_ETAG_USE_MTIME) {
+		if (out->len != 0) g_string_append_len(out, CONST_STR_LEN("-"));
+		li_string_append_int(out, st->st_mtime);
+	}
+
+	li_etag_mutate(out, out);
+}
+
+gboolean li_etag_format_last_modified(GString *out, time_t mtime) {
+	struct tm tm;
+
+	if (!gmtime_r(&mtime, &tm)) return FALSE;
+
+	g_string_set_size(out, 256);
+	g_string_set_size(out, strftime(out->str, out->len-1,
+		"%a, %d %b %Y %H:%M:%S GMT", &tm));
+	return TRUE;
+}
+
+static void etag_set_etag(liVRequest *vr, GString *etag, liTristate *c_able) {
+	if (NULL == etag) {
+		li_http_header_remove(vr->response.headers, CONST_STR_LEN("etag"));
+		return;
+	}
+
+	li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("ETag"), GSTR_LEN(etag));
+
+	if (*c_able != LI_TRIFALSE) {
+		switch (li_http_response_handle_cachable_etag(vr, etag)) {
+		case LI_TRIFALSE: *c_able = LI_TRIFALSE; break;
+		case LI_TRIMAYBE: break;
+		case LI_TRITRUE : *c_able = LI_TRITRUE; break;
+		}
+	}
+}
+
+static void etag_set_last_modified(liVRequest *vr, GString *last_modified, liTristate *c_able) {
+	li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Last-Modified"), GSTR_LEN(last_modified));
+
+	if (*c_able != LI_TRIFALSE) {
+		switch (li_http_response_handle_cachable_modified(vr, last_modified)) {
+		case LI_TRIFALSE: *c_able = LI_TRIFALSE; break;
+		case LI_TRIMAYBE: break;
+		case LI_TRITRUE : *c_able = LI_TRITRUE; break;
+		}
+	}
+}
+
 void li_etag_set_header(liVRequest *vr, struct stat *st, gboolean *cachable) {
 	guint flags = CORE_OPTION(LI_CORE_OPTION_ETAG_FLAGS).number;
 	GString *tmp_str = vr->wrk->tmp_str;
-	struct tm tm;
 	liTristate c_able = cachable ? LI_TRIMAYBE : LI_TRIFALSE;
 
 	if (0 == flags) {
-		li_http_header_remove(vr->response.headers, CONST_STR_LEN("etag"));
+		etag_set_etag(vr, NULL, &c_able);
 	} else {
-		g_string_truncate(tmp_str, 0);
-	
-		if (flags & LI_ETAG_USE_INODE) {
-			li_string_append_int(tmp_str, st->st_ino);
-		}
-		
-		if (flags & LI_ETAG_USE_SIZE) {
-			if (tmp_str->len != 0) g_string_append_len(tmp_str, CONST_STR_LEN("-"));
-			li_string_append_int(tmp_str, st->st_size);
-		}
-		
-		if (flags & LI_ETAG_USE_MTIME) {
-			if (tmp_str->len != 0) g_string_append_len(tmp_str, CONST_STR_LEN("-"));
-			li_string_append_int(tmp_str, st->st_mtime);
-		}
-	
-		li_etag_mutate(tmp_str, tmp_str);
-	
-		li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("ETag"), GSTR_LEN(tmp_str));
+		li_etag_format(tmp_str, flags, st);
+		etag_set_etag(vr, tmp_str, &c_able);
+	}
 
-		if (c_able != LI_TRIFALSE) {
-			switch (li_http_response_handle_cachable_etag(vr, tmp_str)) {
-			case LI_TRIFALSE: c_able = LI_TRIFALSE; break;
-			case LI_TRIMAYBE: break;
-			case LI_TRITRUE : c_able = LI_TRITRUE; break;
-			}
-		}
+	if (li_etag_format_last_modified(tmp_str, st->st_mtime)) {
+		etag_set_last_modified(vr, tmp_str, &c_able);
 	}
 
-	if (gmtime_r(&st->st_mtime, &tm)) {
-		g_string_set_size(tmp_str, 256);
-		g_string_set_size(tmp_str, strftime(tmp_str->str, tmp_str->len-1,
-			"%a, %d %b %Y %H:%M:%S GMT", &tm));
-		li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Last-Modified"), GSTR_LEN(tmp_str));
+	if (cachable) *cachable = (c_able == LI_TRITRUE);
+}
 
-		if (c_able != LI_TRIFALSE) {
-			switch (li_http_response_handle_cachable_modified(vr, tmp_str)) {
-			case LI_TRIFALSE: c_able = LI_TRIFALSE; break;
-			case LI_TRIMAYBE: break;
-			case LI_TRITRUE : c_able = LI_TRITRUE; break;
-			}
-		}
-	}
+void li_etag_set_header_values(liVRequest *vr, GString *etag, GString *last_modified, gboolean *cachable) {
+	liTristate c_able = cachable ? LI_TRIMAYBE : LI_TRIFALSE;
+
+	etag_set_etag(vr, etag, &c_able);
+	if (NULL != last_modified) etag_set_last_modified(vr, last_modified, &c_able);
 
 	if (cachable) *cachable = (c_able == LI_TRITRUE);
 }
@@ -136,6 +136,14 @@ liFilter* li_filter_new(liVRequest* vr, liFilterHandlerCB handle_data, liFilterF
 	return f;
 }
 
+liHandlerResult li_filter_chunkiter_read(liFilter *f, liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err) {
+	if (NULL == f->vr) {
+		return li_chunkiter_read(iter, start, length, data_start, data_len, err);
+	}
+
+	return li_stream_chunkiter_read(&f->stream, f->vr->wrk->tasklets, iter, start, length, data_start, data_len, err);
+}
+
 static void li_filter_stop(liFilter *filter) {
 	liVRequest *vr = filter->vr;
 
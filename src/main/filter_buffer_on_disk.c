@@ -123,6 +123,8 @@ static void bod_handle_data(bod_state *state) {
 		switch (c->type) {
 		case UNUSED_CHUNK:
 			/* shouldn't happen anyway, but stealing it is ok here too */
+		case PIPE_CHUNK:
+			/* can't be read, pass it on */
 		case FILE_CHUNK:
 			if (state->split_on_file_chunks) {
 				bod_close(state);
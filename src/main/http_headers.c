@@ -46,11 +46,151 @@ cleanup:
 	g_string_truncate(h->data, j);
 }
 
-static liHttpHeader* _http_header_new(const gchar *key, size_t keylen, const gchar *val, size_t valuelen) {
-	liHttpHeader *h = g_slice_new0(liHttpHeader);
+liHttpHeaderId li_http_header_id(const gchar *key, size_t keylen) {
+#define CHECK(name, id) if (0 == g_ascii_strncasecmp(key, name, keylen)) return id
+	switch (keylen) {
+	case 2:
+		CHECK("te", LI_HTTP_HEADER_TE);
+		break;
+	case 3:
+		CHECK("age", LI_HTTP_HEADER_AGE);
+		CHECK("via", LI_HTTP_HEADER_VIA);
+		break;
+	case 4:
+		CHECK("date", LI_HTTP_HEADER_DATE);
+		CHECK("etag", LI_HTTP_HEADER_ETAG);
+		CHECK("host", LI_HTTP_HEADER_HOST);
+		CHECK("vary", LI_HTTP_HEADER_VARY);
+		break;
+	case 5:
+		CHECK("allow", LI_HTTP_HEADER_ALLOW);
+		CHECK("range", LI_HTTP_HEADER_RANGE);
+		break;
+	case 6:
+		CHECK("accept", LI_HTTP_HEADER_ACCEPT);
+		CHECK("cookie", LI_HTTP_HEADER_COOKIE);
+		CHECK("expect", LI_HTTP_HEADER_EXPECT);
+		CHECK("pragma", LI_HTTP_HEADER_PRAGMA);
+		CHECK("server", LI_HTTP_HEADER_SERVER);
+		break;
+	case 7:
+		CHECK("expires", LI_HTTP_HEADER_EXPIRES);
+		CHECK("referer", LI_HTTP_HEADER_REFERER);
+		CHECK("trailer", LI_HTTP_HEADER_TRAILER);
+		CHECK("upgrade", LI_HTTP_HEADER_UPGRADE);
+		break;
+	case 8:
+		CHECK("if-match", LI_HTTP_HEADER_IF_MATCH);
+		CHECK("if-range", LI_HTTP_HEADER_IF_RANGE);
+		CHECK("location", LI_HTTP_HEADER_LOCATION);
+		break;
+	case 10:
+		CHECK("connection", LI_HTTP_HEADER_CONNECTION);
+		CHECK("keep-alive", LI_HTTP_HEADER_KEEP_ALIVE);
+		CHECK("set-cookie", LI_HTTP_HEADER_SET_COOKIE);
+		CHECK("user-agent", LI_HTTP_HEADER_USER_AGENT);
+		CHECK("x-sendfile", LI_HTTP_HEADER_X_SENDFILE);
+		break;
+	case 12:
+		CHECK("content-type", LI_HTTP_HEADER_CONTENT_TYPE);
+		break;
+	case 13:
+		CHECK("accept-ranges", LI_HTTP_HEADER_ACCEPT_RANGES);
+		CHECK("authorization", LI_HTTP_HEADER_AUTHORIZATION);
+		CHECK("cache-control", LI_HTTP_HEADER_CACHE_CONTROL);
+		CHECK("content-range", LI_HTTP_HEADER_CONTENT_RANGE);
+		CHECK("if-none-match", LI_HTTP_HEADER_IF_NONE_MATCH);
+		CHECK("last-modified", LI_HTTP_HEADER_LAST_MODIFIED);
+		break;
+	case 14:
+		CHECK("accept-charset", LI_HTTP_HEADER_ACCEPT_CHARSET);
+		CHECK("content-length", LI_HTTP_HEADER_CONTENT_LENGTH);
+		break;
+	case 15:
+		CHECK("accept-encoding", LI_HTTP_HEADER_ACCEPT_ENCODING);
+		CHECK("accept-language", LI_HTTP_HEADER_ACCEPT_LANGUAGE);
+		CHECK("x-forwarded-for", LI_HTTP_HEADER_X_FORWARDED_FOR);
+		break;
+	case 16:
+		CHECK("content-encoding", LI_HTTP_HEADER_CONTENT_ENCODING);
+		CHECK("content-language", LI_HTTP_HEADER_CONTENT_LANGUAGE);
+		CHECK("content-location", LI_HTTP_HEADER_CONTENT_LOCATION);
+		CHECK("www-authenticate", LI_HTTP_HEADER_WWW_AUTHENTICATE);
+		break;
+	case 17:
+		CHECK("if-modified-since", LI_HTTP_HEADER_IF_MODIFIED_SINCE);
+		CHECK("transfer-encoding", LI_HTTP_HEADER_TRANSFER_ENCODING);
+		CHECK("x-forwarded-proto", LI_HTTP_HEADER_X_FORWARDED_PROTO);
+		break;
+	case 19:
+		CHECK("if-unmodified-since", LI_HTTP_HEADER_IF_UNMODIFIED_SINCE);
+		CHECK("proxy-authorization", LI_HTTP_HEADER_PROXY_AUTHORIZATION);
+		break;
+	}
+#undef CHECK
+	return LI_HTTP_HEADER_OTHER;
+}
+
+/* index maintenance for well-known headers; l must still be linked in headers->entries */
+static void _http_header_index_unlink(liHttpHeaders *headers, GList *l) {
+	liHttpHeaderId id = ((liHttpHeader*) l->data)->id;
+	GList *i;
+
+	if (LI_HTTP_HEADER_OTHER == id) return;
+
+	if (headers->first[id] == l) {
+		for (i = g_list_next(l); i && ((liHttpHeader*) i->data)->id != id; i = g_list_next(i)) ;
+		headers->first[id] = i; /* NULL if l was the only entry */
+	}
+	if (headers->last[id] == l) {
+		for (i = g_list_previous(l); i && ((liHttpHeader*) i->data)->id != id; i = g_list_previous(i)) ;
+		headers->last[id] = i;
+	}
+}
+
+/* header, string and list link in one arena allocation */
+typedef struct http_header_arena http_header_arena;
+struct http_header_arena {
+	liHttpHeader h;
+	GString data;
+	GList link;
+};
+
+/* arena strings can't be realloc()ed by GString: make room for len bytes (+ terminating 0) before g_string_set_size */
+static void _http_header_reserve(liHttpHeaders *headers, liHttpHeader *h, gsize len) {
+	gchar *str;
+
+	if (NULL == headers->arena || len < h->data->allocated_len) return;
+
+	len = MAX(len + 1, 2 * h->data->allocated_len);
+	str = li_arena_alloc(headers->arena, len);
+	memcpy(str, h->data->str, h->data->len + 1);
+	h->data->str = str;
+	h->data->allocated_len = len;
+}
+
+/* returns the list link for the new header */
+static GList* _http_header_new(liHttpHeaders *headers, const gchar *key, size_t keylen, const gchar *val, size_t valuelen) {
+	liHttpHeader *h;
+	GList *link;
 	gchar *s;
-	h->data = g_string_sized_new(keylen + valuelen + 2);
-	g_string_set_size(h->data, keylen + valuelen + 2);
+
+	if (NULL != headers->arena) {
+		http_header_arena *ha = li_arena_alloc0(headers->arena, sizeof(http_header_arena));
+		h = &ha->h;
+		link = &ha->link;
+		h->data = &ha->data;
+		h->data->allocated_len = keylen + valuelen + 3;
+		h->data->str = li_arena_alloc(headers->arena, h->data->allocated_len);
+		h->data->len = keylen + valuelen + 2;
+		h->data->str[h->data->len] = '\0';
+	} else {
+		h = g_slice_new0(liHttpHeader);
+		link = g_list_alloc();
+		h->data = g_string_sized_new(keylen + valuelen + 2);
+		g_string_set_size(h->data, keylen + valuelen + 2);
+	}
+	link->data = h;
 	h->keylen = keylen;
 	s = h->data->str;
 	memcpy(s, key, keylen);
@@ -58,8 +198,9 @@ static liHttpHeader* _http_header_new(const gchar *key, size_t keylen, const gch
 	memcpy(s, ": ", 2);
 	s += 2;
 	memcpy(s, val, valuelen);
+	h->id = li_http_header_id(key, keylen);
 	_http_header_sanitize(h);
-	return h;
+	return link;
 }
 
 static void _header_queue_free(gpointer data, gpointer userdata) {
@@ -73,52 +214,86 @@ liHttpHeaders* li_http_headers_new(void) {
 	return headers;
 }
 
+liHttpHeaders* li_http_headers_new_with_arena(gsize block_size) {
+	liHttpHeaders* headers = li_http_headers_new();
+	headers->arena = li_arena_new(block_size);
+	return headers;
+}
+
 void li_http_headers_reset(liHttpHeaders* headers) {
-	g_queue_foreach(&headers->entries, _header_queue_free, NULL);
-	g_queue_clear(&headers->entries);
+	if (NULL != headers->arena) {
+		g_queue_init(&headers->entries);
+		li_arena_reset(headers->arena);
+	} else {
+		g_queue_foreach(&headers->entries, _header_queue_free, NULL);
+		g_queue_clear(&headers->entries);
+	}
+	memset(headers->first, 0, sizeof(headers->first));
+	memset(headers->last, 0, sizeof(headers->last));
+	headers->version++;
 }
 
 void li_http_headers_free(liHttpHeaders* headers) {
 	if (!headers) return;
-	g_queue_foreach(&headers->entries, _header_queue_free, NULL);
-	g_queue_clear(&headers->entries);
+	if (NULL != headers->arena) {
+		li_arena_free(headers->arena);
+	} else {
+		g_queue_foreach(&headers->entries, _header_queue_free, NULL);
+		g_queue_clear(&headers->entries);
+	}
 	g_slice_free(liHttpHeaders, headers);
 }
 
 /** just insert normal header, allow duplicates */
 void li_http_header_insert(liHttpHeaders *headers, const gchar *key, size_t keylen, const gchar *val, size_t valuelen) {
-	liHttpHeader *h = _http_header_new(key, keylen, val, valuelen);
-	g_queue_push_tail(&headers->entries, h);
+	GList *link = _http_header_new(headers, key, keylen, val, valuelen);
+	liHttpHeader *h = link->data;
+	g_queue_push_tail_link(&headers->entries, link);
+	headers->version++;
+
+	if (LI_HTTP_HEADER_OTHER != h->id) {
+		if (NULL == headers->first[h->id]) headers->first[h->id] = headers->entries.tail;
+		headers->last[h->id] = headers->entries.tail;
+	}
 }
 
 GList* li_http_header_find_first(liHttpHeaders *headers, const gchar *key, size_t keylen) {
+	liHttpHeaderId id = li_http_header_id(key, keylen);
 	liHttpHeader *h;
 	GList *l;
 
+	if (LI_HTTP_HEADER_OTHER != id) return headers->first[id];
+
 	for (l = g_queue_peek_head_link(&headers->entries); l; l = g_list_next(l)) {
 		h = (liHttpHeader*) l->data;
-		if (h->keylen == keylen && 0 == g_ascii_strncasecmp(key, h->data->str, keylen)) return l;
+		if (LI_HTTP_HEADER_OTHER == h->id && h->keylen == keylen && 0 == g_ascii_strncasecmp(key, h->data->str, keylen)) return l;
 	}
 	return NULL;
 }
 
 GList* li_http_header_find_next(GList *l, const gchar *key, size_t keylen) {
+	liHttpHeaderId id = li_http_header_id(key, keylen);
 	liHttpHeader *h;
 
 	for (l = g_list_next(l); l; l = g_list_next(l)) {
 		h = (liHttpHeader*) l->data;
+		if (h->id != id) continue;
+		if (LI_HTTP_HEADER_OTHER != id) return l;
 		if (h->keylen == keylen && 0 == g_ascii_strncasecmp(key, h->data->str, keylen)) return l;
 	}
 	return NULL;
 }
 
 GList* li_http_header_find_last(liHttpHeaders *headers, const gchar *key, size_t keylen) {
+	liHttpHeaderId id = li_http_header_id(key, keylen);
 	liHttpHeader *h;
 	GList *l;
 
+	if (LI_HTTP_HEADER_OTHER != id) return headers->last[id];
+
 	for (l = g_queue_peek_tail_link(&headers->entries); l; l = g_list_previous(l)) {
 		h = (liHttpHeader*) l->data;
-		if (h->keylen == keylen && 0 == g_ascii_strncasecmp(key, h->data->str, keylen)) return l;
+		if (LI_HTTP_HEADER_OTHER == h->id && h->keylen == keylen && 0 == g_ascii_strncasecmp(key, h->data->str, keylen)) return l;
 	}
 	return NULL;
 }
@@ -136,10 +311,12 @@ void li_http_header_append(liHttpHeaders *headers, const gchar *key, size_t keyl
 		gchar *s;
 		h = (liHttpHeader*) l->data;
 		oldlen = h->data->len;
+		_http_header_reserve(headers, h, oldlen + 2 + valuelen);
 		g_string_set_size(h->data, oldlen + 2 + valuelen);
 		s = h->data->str + oldlen;
 		memcpy(s, ", ", 2);
 		memcpy(s+2, val, valuelen);
+		headers->version++;
 	}
 }
 
@@ -153,15 +330,24 @@ void li_http_header_overwrite(liHttpHeaders *headers, const gchar *key, size_t k
 		li_http_header_insert(headers, key, keylen, val, valuelen);
 	} else {
 		h = (liHttpHeader*) l->data;
+		_http_header_reserve(headers, h, keylen + 2 + valuelen);
 		g_string_set_size(h->data, keylen + 2 + valuelen);
 		/* only overwrite value */
 		memcpy(h->data->str + keylen + 2, val, valuelen);
+		headers->version++;
 	}
 }
 
 void li_http_header_remove_link(liHttpHeaders *headers, GList *l) {
-	_http_header_free(l->data);
-	g_queue_delete_link(&headers->entries, l);
+	_http_header_index_unlink(headers, l);
+	headers->version++;
+	if (NULL != headers->arena) {
+		/* memory is released with the arena */
+		g_queue_unlink(&headers->entries, l);
+	} else {
+		_http_header_free(l->data);
+		g_queue_delete_link(&headers->entries, l);
+	}
 }
 
 gboolean li_http_header_remove(liHttpHeaders *headers, const gchar *key, size_t keylen) {
@@ -128,6 +128,8 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
+	li_action_compile(srv, srv->mainaction);
+
 	/* if config should only be tested, exit here  */
 	if (test_config)
 		return 0;
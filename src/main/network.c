@@ -2,6 +2,11 @@
 #include <lighttpd/base.h>
 #include <lighttpd/plugin_core.h>
 
+#ifdef HAVE_LINUX_SOCKIOS_H
+# include <sys/ioctl.h>
+# include <linux/sockios.h>
+#endif
+
 GQuark li_network_error_quark(void) {
 	return g_quark_from_string("g-network-error-quark");
 }
@@ -40,7 +45,56 @@ ssize_t li_net_read(int fd, void *buf, ssize_t nbyte) {
 	return r;
 }
 
-liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, GError **err) {
+gboolean li_network_set_notsent_lowat(int fd, goffset lowat) {
+#ifdef TCP_NOTSENT_LOWAT
+	int val = (int) MIN(lowat, G_MAXINT);
+
+	return 0 == setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &val, sizeof(val));
+#else
+	UNUSED(fd); UNUSED(lowat);
+
+	return FALSE;
+#endif
+}
+
+goffset li_network_unsent_bytes(int fd) {
+#ifdef SIOCOUTQNSD
+	int val;
+
+	if (-1 == ioctl(fd, SIOCOUTQNSD, &val)) return -1;
+	return val;
+#else
+	UNUSED(fd);
+
+	return -1;
+#endif
+}
+
+#ifdef TCP_CORK
+/* memory chunks are sent with one writev(), and memory chunks followed by a single file (or pipe)
+ * chunk with MSG_MORE (see li_network_backend_writev); only cork for other combinations
+ */
+static gboolean network_needs_cork(liChunkQueue *cq) {
+	GList *l;
+
+	if (cq->queue.length <= 1) return FALSE;
+
+	for (l = cq->queue.head; NULL != l; l = l->next) {
+		liChunk *c = l->data;
+		if (FILE_CHUNK == c->type || PIPE_CHUNK == c->type) return NULL != l->next;
+	}
+
+	return FALSE;
+}
+#endif
+
+liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, liNetworkZeroCopy *zc, GError **err) {
+	if (NULL != zc) return li_network_write_zerocopy(fd, cq, &write_max, zc, err);
+
+	return li_network_write_chunks(fd, cq, &write_max, err);
+}
+
+liNetworkStatus li_network_write_chunks(int fd, liChunkQueue *cq, goffset *write_max, GError **err) {
 	liNetworkStatus res;
 #ifdef TCP_CORK
 	int corked = 0;
@@ -48,9 +102,9 @@ liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, GE
 
 #ifdef TCP_CORK
 	/* Linux: put a cork into the socket as we want to combine the write() calls
-	 * but only if we really have multiple chunks
+	 * but only if we really have multiple chunks that need multiple syscalls
 	 */
-	if (cq->queue.length > 1) {
+	if (network_needs_cork(cq)) {
 		corked = 1;
 		setsockopt(fd, IPPROTO_TCP, TCP_CORK, &corked, sizeof(corked));
 	}
@@ -58,9 +112,9 @@ liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, GE
 
 	/* TODO: add setup-option to select the backend */
 #ifdef USE_SENDFILE
-	res = li_network_write_sendfile(fd, cq, &write_max, err);
+	res = li_network_write_sendfile(fd, cq, write_max, err);
 #else
-	res = li_network_write_writev(fd, cq, &write_max, err);
+	res = li_network_write_writev(fd, cq, write_max, err);
 #endif
 
 #ifdef TCP_CORK
@@ -73,9 +127,56 @@ liNetworkStatus li_network_write(int fd, liChunkQueue *cq, goffset write_max, GE
 	return res;
 }
 
-liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBuffer **buffer, GError **err) {
-	const ssize_t blocksize = 16*1024; /* 16k */
-	ssize_t r;
+/* read sizes follow the buffer pool size classes */
+#define NETWORK_READ_SIZE_MIN (4*1024)
+#define NETWORK_READ_SIZE_DEFAULT (16*1024)
+#define NETWORK_READ_SIZE_MAX (64*1024)
+
+/* returns the buffer to read into next: the last buffer in cq if it has space left, *buffer or a new one */
+static liBuffer* network_read_buffer(liChunkQueue *cq, liBuffer **buffer, liBufferPool *pool, gsize size, gboolean *cq_buf_append) {
+	liBuffer *buf = li_chunkqueue_get_last_buffer(cq, 1024);
+
+	*cq_buf_append = (buf != NULL);
+
+	if (NULL != buffer) {
+		if (buf != NULL) {
+			/* use last buffer as *buffer; they should be the same anyway */
+			if (HEDLEY_UNLIKELY(buf != *buffer)) {
+				li_buffer_acquire(buf);
+				li_buffer_release(*buffer);
+				*buffer = buf;
+			}
+		} else {
+			buf = *buffer;
+			if (buf != NULL) {
+				/* if *buffer is the only reference, we can reset the buffer */
+				if (g_atomic_int_get(&buf->refcount) == 1) {
+					buf->used = 0;
+				}
+
+				if (buf->alloc_size - buf->used < 1024) {
+					/* release *buffer */
+					li_buffer_release(buf);
+					*buffer = buf = NULL;
+				}
+			}
+			if (buf == NULL) {
+				*buffer = buf = li_buffer_pool_get(pool, size);
+			}
+		}
+		LI_FORCE_ASSERT(*buffer == buf);
+	} else {
+		if (buf == NULL) {
+			buf = li_buffer_pool_get(pool, size);
+		}
+	}
+
+	return buf;
+}
+
+liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBuffer **buffer, liBufferPool *pool, liNetworkReadState *state, GError **err) {
+	gsize size = (NULL != state && 0 != state->read_size) ? state->read_size : NETWORK_READ_SIZE_DEFAULT;
+	ssize_t r, want;
 	off_t len = 0;
 
 	if (cq->limit && cq->limit->limit > 0) {
@@ -89,47 +190,33 @@ liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBu
 	}
 
 	do {
-		liBuffer *buf = NULL;
+		liBuffer *buf, *extra = NULL;
 		gboolean cq_buf_append;
+		struct iovec iov[2];
+		int iovcnt = 1;
 
-		buf = li_chunkqueue_get_last_buffer(cq, 1024);
-		cq_buf_append = (buf != NULL);
+		buf = network_read_buffer(cq, buffer, pool, size, &cq_buf_append);
 
-		if (NULL != buffer) {
-			if (buf != NULL) {
-				/* use last buffer as *buffer; they should be the same anyway */
-				if (HEDLEY_UNLIKELY(buf != *buffer)) {
-					li_buffer_acquire(buf);
-					li_buffer_release(*buffer);
-					*buffer = buf;
-				}
-			} else {
-				buf = *buffer;
-				if (buf != NULL) {
-					/* if *buffer is the only reference, we can reset the buffer */
-					if (g_atomic_int_get(&buf->refcount) == 1) {
-						buf->used = 0;
-					}
-
-					if (buf->alloc_size - buf->used < 1024) {
-						/* release *buffer */
-						li_buffer_release(buf);
-						*buffer = buf = NULL;
-					}
-				}
-				if (buf == NULL) {
-					*buffer = buf = li_buffer_new(blocksize);
-				}
-			}
-			LI_FORCE_ASSERT(*buffer == buf);
-		} else {
-			if (buf == NULL) {
-				buf = li_buffer_new(blocksize);
-			}
+		iov[0].iov_base = buf->addr + buf->used;
+		iov[0].iov_len = MIN((goffset) (buf->alloc_size - buf->used), read_max - len);
+		want = iov[0].iov_len;
+
+		if ((gsize) want < size && want < read_max - len) {
+			/* only a small rest left in the buffer: read into a second buffer with the same syscall */
+			extra = li_buffer_pool_get(pool, size);
+			iov[1].iov_base = extra->addr;
+			iov[1].iov_len = MIN((goffset) extra->alloc_size, read_max - len - want);
+			want += iov[1].iov_len;
+			iovcnt = 2;
 		}
 
-		if (-1 == (r = li_net_read(fd, buf->addr + buf->used, buf->alloc_size - buf->used))) {
+		if (NULL != state) state->syscalls++;
+
+		while (-1 == (r = readv(fd, iov, iovcnt)) && EINTR == errno) ;
+
+		if (-1 == r) {
 			if (buffer == NULL && !cq_buf_append) li_buffer_release(buf);
+			li_buffer_release(extra);
 			switch (errno) {
 			case EAGAIN:
 #if EWOULDBLOCK != EAGAIN
@@ -145,19 +232,39 @@ liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBu
 			}
 		} else if (0 == r) {
 			if (buffer == NULL && !cq_buf_append) li_buffer_release(buf);
+			li_buffer_release(extra);
 			return LI_NETWORK_STATUS_CONNECTION_CLOSE;
 		}
-		if (cq_buf_append) {
-			li_chunkqueue_update_last_buffer_size(cq, r);
-		} else {
-			gsize offset;
 
-			if (buffer != NULL) li_buffer_acquire(buf);
+		{
+			ssize_t first = MIN(r, (ssize_t) iov[0].iov_len);
+
+			if (cq_buf_append) {
+				li_chunkqueue_update_last_buffer_size(cq, first);
+			} else {
+				gsize offset;
 
-			offset = buf->used;
-			buf->used += r;
-			li_chunkqueue_append_buffer2(cq, buf, offset, r);
+				if (buffer != NULL) li_buffer_acquire(buf);
+
+				offset = buf->used;
+				buf->used += first;
+				li_chunkqueue_append_buffer2(cq, buf, offset, first);
+			}
+
+			if (r > first) {
+				/* the rest went into the second buffer, which becomes the new *buffer */
+				extra->used = r - first;
+				if (NULL != buffer) {
+					li_buffer_acquire(extra);
+					li_buffer_release(*buffer);
+					*buffer = buf = extra;
+				}
+				li_chunkqueue_append_buffer2(cq, extra, 0, extra->used);
+			} else {
+				li_buffer_release(extra);
+			}
 		}
+
 		if (NULL != buffer) {
 			if (buf->alloc_size - buf->used < 1024) {
 				/* release *buffer */
@@ -166,7 +273,21 @@ liNetworkStatus li_network_read(int fd, liChunkQueue *cq, goffset read_max, liBu
 			}
 		}
 		len += r;
-	} while (r == blocksize && len < read_max);
+	} while (r == want && len < read_max);
+
+	if (NULL != state) {
+		/* adapt the buffer size to the data available per read event */
+		if (len > (off_t) size && size < NETWORK_READ_SIZE_MAX) {
+			state->read_size = size * 4;
+		} else if (len <= (off_t) size / 8 && size > NETWORK_READ_SIZE_MIN) {
+			state->read_size = size / 4;
+		} else {
+			state->read_size = size;
+		}
+	}
+
+	/* a short read drained the socket: wait for the next event instead of trying again just to get EAGAIN */
+	if (r < want) return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
 
 	return LI_NETWORK_STATUS_SUCCESS;
 }
@@ -231,6 +231,9 @@ liNetworkStatus li_network_write_sendfile(int fd, liChunkQueue *cq, goffset *wri
 		case FILE_CHUNK:
 			LI_NETWORK_FALLBACK(network_backend_sendfile, write_max);
 			break;
+		case PIPE_CHUNK:
+			LI_NETWORK_FALLBACK(li_network_backend_splice, write_max);
+			break;
 		default:
 			return LI_NETWORK_STATUS_FATAL_ERROR;
 		}
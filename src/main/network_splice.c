@@ -0,0 +1,135 @@
+
+#include <lighttpd/base.h>
+
+#ifdef USE_SPLICE
+
+/* first chunk must be a PIPE_CHUNK ! */
+liNetworkStatus li_network_backend_splice(int fd, liChunkQueue *cq, goffset *write_max, GError **err) {
+	gboolean did_write_something = FALSE;
+	liChunk *c;
+	liChunkPipe *cp;
+	goffset toSend, pos;
+	ssize_t r;
+
+	do {
+		if (0 == cq->length) return LI_NETWORK_STATUS_FATAL_ERROR;
+
+		c = li_chunkqueue_first_chunk(cq);
+		if (PIPE_CHUNK != c->type) {
+			return did_write_something ? LI_NETWORK_STATUS_SUCCESS : LI_NETWORK_STATUS_FATAL_ERROR;
+		}
+
+		cp = c->data.pipe.pipe;
+		pos = c->data.pipe.start + c->offset;
+
+		/* drop data of chunks that were skipped */
+		if (cp->read_pos != pos && !li_chunkpipe_discard(cp, pos, err)) {
+			return LI_NETWORK_STATUS_FATAL_ERROR;
+		}
+
+		toSend = li_chunk_length(c);
+		if (toSend > *write_max) toSend = *write_max;
+
+		while (-1 == (r = splice(cp->fd_read, NULL, fd, NULL, toSend, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | (toSend < cq->length ? SPLICE_F_MORE : 0)))) {
+			switch (errno) {
+			case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+			case EWOULDBLOCK:
+#endif
+				/* the data is in the pipe, so the socket is full */
+				return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+			case ECONNRESET:
+			case EPIPE:
+			case ETIMEDOUT:
+				return LI_NETWORK_STATUS_CONNECTION_CLOSE;
+			case EINTR:
+				break; /* try again */
+			default:
+				g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_backend_splice: splice to fd=%d failed: %s", fd, g_strerror(errno));
+				return LI_NETWORK_STATUS_FATAL_ERROR;
+			}
+		}
+		if (0 == r) return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+
+		cp->read_pos += r;
+		li_chunkqueue_skip(cq, r);
+		*write_max -= r;
+		did_write_something = TRUE;
+
+		if (0 == cq->length) return LI_NETWORK_STATUS_SUCCESS;
+		if (r != toSend) return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+	} while (*write_max > 0);
+
+	return LI_NETWORK_STATUS_SUCCESS;
+}
+
+liNetworkStatus li_network_read_splice(int fd, liChunkQueue *cq, goffset read_max, liChunkPipe *cp, liBuffer **buffer, liBufferPool *pool, liNetworkReadState *state, GError **err) {
+	ssize_t r;
+	goffset len = 0;
+
+	if (cq->limit && cq->limit->limit > 0) {
+		if (read_max > cq->limit->limit - cq->limit->current) {
+			read_max = cq->limit->limit - cq->limit->current;
+			if (read_max <= 0) {
+				g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_read_splice: fd should be disabled as chunkqueue is already full, aborting connection.");
+				return LI_NETWORK_STATUS_FATAL_ERROR;
+			}
+		}
+	}
+
+	while (len < read_max) {
+		goffset want = read_max - len;
+
+		if (NULL != state) state->syscalls++;
+
+		if (-1 == (r = splice(fd, NULL, cp->fd_write, NULL, want, SPLICE_F_MOVE | SPLICE_F_NONBLOCK))) {
+			switch (errno) {
+			case EINTR:
+				continue;
+			case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+			case EWOULDBLOCK:
+#endif
+				if (len > 0) return LI_NETWORK_STATUS_SUCCESS;
+				/* either the socket or the pipe is empty; read() tells which */
+				if (cp->write_pos > cp->read_pos) break;
+				return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+			case EINVAL: /* fd doesn't support splice() */
+				break;
+			case ECONNRESET:
+			case ETIMEDOUT:
+				return LI_NETWORK_STATUS_CONNECTION_CLOSE;
+			default:
+				g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_read_splice: splice from fd=%d failed: %s", fd, g_strerror(errno));
+				return LI_NETWORK_STATUS_FATAL_ERROR;
+			}
+
+			return li_network_read(fd, cq, read_max - len, buffer, pool, state, err);
+		} else if (0 == r) {
+			return LI_NETWORK_STATUS_CONNECTION_CLOSE;
+		}
+
+		li_chunkqueue_append_pipe(cq, cp, r);
+		len += r;
+		if (r < want) break; /* socket drained or pipe full */
+	}
+
+	return LI_NETWORK_STATUS_SUCCESS;
+}
+
+#else
+
+liNetworkStatus li_network_backend_splice(int fd, liChunkQueue *cq, goffset *write_max, GError **err) {
+	UNUSED(fd); UNUSED(cq); UNUSED(write_max);
+
+	g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_backend_splice: splice() not supported");
+	return LI_NETWORK_STATUS_FATAL_ERROR;
+}
+
+liNetworkStatus li_network_read_splice(int fd, liChunkQueue *cq, goffset read_max, liChunkPipe *cp, liBuffer **buffer, liBufferPool *pool, liNetworkReadState *state, GError **err) {
+	UNUSED(cp);
+
+	return li_network_read(fd, cq, read_max, buffer, pool, state, err);
+}
+
+#endif
@@ -1,6 +1,7 @@
 
 #include <lighttpd/base.h>
 
+#include <sys/socket.h>
 #include <sys/uio.h>
 
 #ifndef UIO_MAXIOV
@@ -24,95 +25,127 @@
 # endif
 #endif
 
+static ssize_t network_writev(int fd, struct iovec *iov, int iovcnt, gboolean more) {
+#ifdef MSG_MORE
+	if (more) {
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		return sendmsg(fd, &msg, MSG_MORE);
+	}
+#else
+	UNUSED(more);
+#endif
+	return writev(fd, iov, iovcnt);
+}
+
+/* iovec scratch space for li_network_backend_writev, one per (worker) thread; allocated on first use */
+static GPrivate *network_iov_key = NULL;
+#ifdef HAVE___THREAD
+/* cached g_private_get(network_iov_key) */
+static __thread struct iovec *network_iov_thread = NULL;
+#endif
+
+static struct iovec* network_iov_scratch(void) {
+	struct iovec *iov;
+
+#ifdef HAVE___THREAD
+	if (HEDLEY_LIKELY(NULL != (iov = network_iov_thread))) return iov;
+#endif
+
+	if (HEDLEY_UNLIKELY(NULL == g_atomic_pointer_get(&network_iov_key))) {
+		static GStaticMutex init_mutex = G_STATIC_MUTEX_INIT;
+		g_static_mutex_lock(&init_mutex);
+		if (NULL == network_iov_key) {
+			GPrivate *key = g_private_new(g_free);
+			g_atomic_pointer_set(&network_iov_key, key);
+		}
+		g_static_mutex_unlock(&init_mutex);
+	}
+
+	if (NULL == (iov = g_private_get(network_iov_key))) {
+		iov = g_new(struct iovec, UIO_MAXIOV);
+		g_private_set(network_iov_key, iov);
+	}
+
+#ifdef HAVE___THREAD
+	network_iov_thread = iov;
+#endif
+
+	return iov;
+}
+
 /* first chunk must be a STRING_CHUNK ! */
+/* if a file (or pipe) chunk follows the memory chunks, they are sent with MSG_MORE, so the kernel waits
+ * for the file data (sendfile) instead of sending a small packet with only the response headers
+ */
 liNetworkStatus li_network_backend_writev(int fd, liChunkQueue *cq, goffset *write_max, GError **err) {
-	off_t we_have;
+	goffset we_have;
 	ssize_t r;
-	gboolean did_write_something = FALSE;
+	gboolean did_write_something = FALSE, more;
 	liChunkIter ci;
 	liChunk *c;
-	liNetworkStatus res = LI_NETWORK_STATUS_FATAL_ERROR;
+	guint iovcnt;
+	struct iovec *iov;
 
-	GArray *chunks = g_array_sized_new(FALSE, TRUE, sizeof(struct iovec), UIO_MAXIOV);
+	if (0 == cq->length) return LI_NETWORK_STATUS_FATAL_ERROR;
 
-	if (0 == cq->length) goto cleanup; /* FATAL ERROR */
+	iov = network_iov_scratch();
 
 	do {
 		ci = li_chunkqueue_iter(cq);
 
-		if (STRING_CHUNK != (c = li_chunkiter_chunk(ci))->type && MEM_CHUNK != c->type && BUFFER_CHUNK != c->type) {
-			res = did_write_something ? LI_NETWORK_STATUS_SUCCESS : LI_NETWORK_STATUS_FATAL_ERROR;
-			goto cleanup;
+		if (0 == (iovcnt = li_chunkiter_gather_iovec(&ci, iov, UIO_MAXIOV, *write_max, &we_have))) {
+			return did_write_something ? LI_NETWORK_STATUS_SUCCESS : LI_NETWORK_STATUS_FATAL_ERROR;
 		}
 
-		we_have = 0;
-		do {
-			guint i = chunks->len;
-			off_t len = li_chunk_length(c);
-			struct iovec *v;
-			g_array_set_size(chunks, i + 1);
-			v = &g_array_index(chunks, struct iovec, i);
-			if (c->type == STRING_CHUNK) {
-				v->iov_base = c->data.str->str + c->offset;
-			} else if (c->type == MEM_CHUNK) {
-				v->iov_base = c->mem->data + c->offset;
-			} else { /* if (c->type == BUFFER_CHUNK) */
-				v->iov_base = c->data.buffer.buffer->addr + c->data.buffer.offset + c->offset;
-			}
-			if (len > *write_max - we_have) len = *write_max - we_have;
-			v->iov_len = len;
-			we_have += len;
-		} while (we_have < *write_max &&
-		         li_chunkiter_next(&ci) &&
-		         (STRING_CHUNK == (c = li_chunkiter_chunk(ci))->type || MEM_CHUNK == c->type || BUFFER_CHUNK == c->type) &&
-		         chunks->len < UIO_MAXIOV);
-
-		while (-1 == (r = writev(fd, &g_array_index(chunks, struct iovec, 0), chunks->len))) {
+		/* stopped at a file or pipe chunk (and not at write_max / UIO_MAXIOV)? */
+		more = we_have < *write_max && iovcnt < UIO_MAXIOV
+			&& NULL != (c = li_chunkiter_chunk(ci)) && (FILE_CHUNK == c->type || PIPE_CHUNK == c->type);
+
+		while (-1 == (r = network_writev(fd, iov, iovcnt, more))) {
 			switch (errno) {
 			case EAGAIN:
 #if EWOULDBLOCK != EAGAIN
 			case EWOULDBLOCK:
 #endif
-				res = LI_NETWORK_STATUS_WAIT_FOR_EVENT;
-				goto cleanup;
+				return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
 			case ECONNRESET:
 			case EPIPE:
 			case ETIMEDOUT:
-				res = LI_NETWORK_STATUS_CONNECTION_CLOSE;
-				goto cleanup;
+				return LI_NETWORK_STATUS_CONNECTION_CLOSE;
 			case EINTR:
 				break; /* try again */
+			case ENOTSOCK:
+				if (more) {
+					more = FALSE; /* try again with writev() */
+					break;
+				}
+				/* fall through */
 			default:
 				g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_backend_writev: oops, write to fd=%d failed: %s", fd, g_strerror(errno));
-				goto cleanup;
+				return LI_NETWORK_STATUS_FATAL_ERROR;
 			}
 		}
 		if (0 == r) {
-			res = LI_NETWORK_STATUS_WAIT_FOR_EVENT;
-			goto cleanup;
+			return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
 		}
 		li_chunkqueue_skip(cq, r);
 		*write_max -= r;
 
 		if (r != we_have) {
-			res = LI_NETWORK_STATUS_WAIT_FOR_EVENT;
-			goto cleanup;
+			return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
 		}
 
 		if (0 == cq->length) {
-			res = LI_NETWORK_STATUS_SUCCESS;
-			goto cleanup;
+			return LI_NETWORK_STATUS_SUCCESS;
 		}
 
 		did_write_something = TRUE;
-		g_array_set_size(chunks, 0);
 	} while (*write_max > 0);
 
-	res = LI_NETWORK_STATUS_SUCCESS;
-
-cleanup:
-	g_array_free(chunks, TRUE);
-	return res;
+	return LI_NETWORK_STATUS_SUCCESS;
 }
 
 liNetworkStatus li_network_write_writev(int fd, liChunkQueue *cq, goffset *write_max, GError **err) {
@@ -127,6 +160,9 @@ liNetworkStatus li_network_write_writev(int fd, liChunkQueue *cq, goffset *write
 		case FILE_CHUNK:
 			LI_NETWORK_FALLBACK(li_network_backend_write, write_max);
 			break;
+		case PIPE_CHUNK:
+			LI_NETWORK_FALLBACK(li_network_backend_splice, write_max);
+			break;
 		default:
 			return LI_NETWORK_STATUS_FATAL_ERROR;
 		}
@@ -0,0 +1,272 @@
+
+#include <lighttpd/base.h>
+
+#include <sys/socket.h>
+
+#ifdef HAVE_LINUX_ERRQUEUE_H
+# include <netinet/in.h>
+# include <linux/errqueue.h>
+# if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#  define USE_ZEROCOPY
+# endif
+#endif
+
+/* MSG_ZEROCOPY (linux 4.14): the kernel sends directly from the pages of the buffers; they have to stay
+ * unmodified until the completion notification arrives on the socket error queue. every successful
+ * sendmsg(MSG_ZEROCOPY) on a socket gets the next 32-bit id, completions report ranges of ids
+ * (in order for TCP).
+ */
+
+typedef struct zerocopy_ref zerocopy_ref;
+struct zerocopy_ref {
+	guint32 id;
+	liBuffer *buf;
+};
+
+struct liNetworkZeroCopy {
+	goffset min_size;
+	guint32 next_id;
+	GQueue pending; /* zerocopy_ref, ordered by id */
+
+	guint sockopt_done:1; /* tried to set SO_ZEROCOPY */
+	guint disabled:1;
+};
+
+/* at most that many buffers per sendmsg() */
+#define ZEROCOPY_IOV_MAX 64
+
+liNetworkZeroCopy* li_network_zerocopy_new(goffset min_size) {
+	liNetworkZeroCopy *zc = g_slice_new0(liNetworkZeroCopy);
+
+	zc->min_size = MAX(min_size, 1);
+	g_queue_init(&zc->pending);
+
+#ifndef USE_ZEROCOPY
+	zc->disabled = TRUE;
+#endif
+
+	return zc;
+}
+
+static void zerocopy_release_all(liNetworkZeroCopy *zc) {
+	zerocopy_ref *ref;
+
+	while (NULL != (ref = g_queue_pop_head(&zc->pending))) {
+		li_buffer_release(ref->buf);
+		g_slice_free(zerocopy_ref, ref);
+	}
+}
+
+void li_network_zerocopy_free(liNetworkZeroCopy *zc) {
+	if (NULL == zc) return;
+
+	zerocopy_release_all(zc);
+	g_slice_free(liNetworkZeroCopy, zc);
+}
+
+gboolean li_network_zerocopy_pending(liNetworkZeroCopy *zc) {
+	return NULL != zc && !g_queue_is_empty(&zc->pending);
+}
+
+#ifdef USE_ZEROCOPY
+
+/* release buffers of all sends with id <= hi */
+static void zerocopy_complete(liNetworkZeroCopy *zc, guint32 hi) {
+	zerocopy_ref *ref;
+
+	while (NULL != (ref = g_queue_peek_head(&zc->pending)) && (gint32) (hi - ref->id) >= 0) {
+		g_queue_pop_head(&zc->pending);
+		li_buffer_release(ref->buf);
+		g_slice_free(zerocopy_ref, ref);
+	}
+}
+
+void li_network_zerocopy_reap(int fd, liNetworkZeroCopy *zc) {
+	char control[128];
+	struct msghdr msg;
+	struct cmsghdr *cm;
+
+	while (!g_queue_is_empty(&zc->pending)) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (-1 == recvmsg(fd, &msg, MSG_ERRQUEUE)) {
+			if (EINTR == errno) continue;
+			return; /* EAGAIN: no (more) notifications */
+		}
+
+		for (cm = CMSG_FIRSTHDR(&msg); NULL != cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			struct sock_extended_err *serr;
+
+			if (!(SOL_IP == cm->cmsg_level && IP_RECVERR == cm->cmsg_type)
+			    && !(SOL_IPV6 == cm->cmsg_level && IPV6_RECVERR == cm->cmsg_type)) continue;
+
+			serr = (struct sock_extended_err*) CMSG_DATA(cm);
+			if (SO_EE_ORIGIN_ZEROCOPY != serr->ee_origin || 0 != serr->ee_errno) continue;
+
+			/* the kernel had to copy the data anyway (loopback, no scatter-gather support on the device):
+			 * zero copy only costs more, stop using it on this socket */
+			if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) zc->disabled = TRUE;
+
+			zerocopy_complete(zc, serr->ee_data);
+		}
+	}
+}
+
+/* bytes before the first run of buffer chunks with at least zc->min_size bytes, -1 if there is none */
+static goffset zerocopy_find(liChunkQueue *cq, liNetworkZeroCopy *zc) {
+	liChunkIter ci = li_chunkqueue_iter(cq);
+	liChunk *c;
+	goffset offset = 0, run_start = 0, run_length = 0;
+
+	for ( ; NULL != (c = li_chunkiter_chunk(ci)); li_chunkiter_next(&ci)) {
+		goffset len = li_chunk_length(c);
+
+		if (BUFFER_CHUNK == c->type) {
+			if (0 == run_length) run_start = offset;
+			run_length += len;
+			if (run_length >= zc->min_size) return run_start;
+		} else {
+			run_length = 0;
+		}
+		offset += len;
+	}
+
+	return -1;
+}
+
+/* send the buffer chunks at the head of cq with MSG_ZEROCOPY */
+static liNetworkStatus zerocopy_send(int fd, liChunkQueue *cq, goffset *write_max, liNetworkZeroCopy *zc, GError **err) {
+	struct iovec iov[ZEROCOPY_IOV_MAX];
+	liBuffer *bufs[ZEROCOPY_IOV_MAX];
+	struct msghdr msg;
+	liChunkIter ci = li_chunkqueue_iter(cq);
+	liChunk *c;
+	guint n = 0, i;
+	goffset we_have = 0;
+	ssize_t r;
+
+	while (n < ZEROCOPY_IOV_MAX && we_have < *write_max && NULL != (c = li_chunkiter_chunk(ci)) && BUFFER_CHUNK == c->type) {
+		goffset len = li_chunk_length(c);
+
+		if (len > *write_max - we_have) len = *write_max - we_have;
+		iov[n].iov_base = c->data.buffer.buffer->addr + c->data.buffer.offset + c->offset;
+		iov[n].iov_len = len;
+		bufs[n] = c->data.buffer.buffer;
+		we_have += len;
+		n++;
+
+		if (!li_chunkiter_next(&ci)) break;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = n;
+
+	while (-1 == (r = sendmsg(fd, &msg, MSG_ZEROCOPY))) {
+		switch (errno) {
+		case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+		case EWOULDBLOCK:
+#endif
+			return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+		case ECONNRESET:
+		case EPIPE:
+		case ETIMEDOUT:
+			return LI_NETWORK_STATUS_CONNECTION_CLOSE;
+		case EINTR:
+			break; /* try again */
+		case ENOBUFS:
+			/* too many pages pinned (optmem limit): copy this time */
+			return li_network_backend_writev(fd, cq, write_max, err);
+		default:
+			g_set_error(err, LI_NETWORK_ERROR, 0, "li_network_write: sendmsg(MSG_ZEROCOPY) to fd=%d failed: %s", fd, g_strerror(errno));
+			return LI_NETWORK_STATUS_FATAL_ERROR;
+		}
+	}
+	if (0 == r) return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+
+	/* keep the buffers the kernel references */
+	for (i = 0, we_have = 0; i < n && we_have < r; we_have += iov[i].iov_len, i++) {
+		zerocopy_ref *ref = g_slice_new(zerocopy_ref);
+		ref->id = zc->next_id;
+		ref->buf = bufs[i];
+		li_buffer_acquire(ref->buf);
+		g_queue_push_tail(&zc->pending, ref);
+	}
+	zc->next_id++;
+
+	li_chunkqueue_skip(cq, r);
+	*write_max -= r;
+
+	return (r < we_have) ? LI_NETWORK_STATUS_WAIT_FOR_EVENT : LI_NETWORK_STATUS_SUCCESS;
+}
+
+liNetworkStatus li_network_write_zerocopy(int fd, liChunkQueue *cq, goffset *write_max, liNetworkZeroCopy *zc, GError **err) {
+	liNetworkStatus res;
+	goffset prefix;
+
+	if (!zc->sockopt_done) {
+		int val = 1;
+		if (-1 == setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val))) zc->disabled = TRUE;
+		zc->sockopt_done = TRUE;
+	}
+
+	li_network_zerocopy_reap(fd, zc);
+
+	while (!zc->disabled && cq->length > 0 && *write_max > 0 && -1 != (prefix = zerocopy_find(cq, zc))) {
+		if (prefix > 0) {
+			goffset limit = MIN(prefix, *write_max), before = limit;
+
+			res = li_network_write_chunks(fd, cq, &limit, err);
+			*write_max -= before - limit;
+			if (LI_NETWORK_STATUS_SUCCESS != res || 0 != limit) return res;
+			if (prefix > before) return LI_NETWORK_STATUS_SUCCESS; /* write_max reached */
+		}
+
+		res = zerocopy_send(fd, cq, write_max, zc, err);
+		if (LI_NETWORK_STATUS_SUCCESS != res) return res;
+	}
+
+	if (0 == cq->length || *write_max <= 0) return LI_NETWORK_STATUS_SUCCESS;
+
+	return li_network_write_chunks(fd, cq, write_max, err);
+}
+
+void li_network_zerocopy_close(int fd, liNetworkZeroCopy *zc) {
+	if (NULL == zc) return;
+
+	if (-1 != fd && !g_queue_is_empty(&zc->pending)) {
+		li_network_zerocopy_reap(fd, zc);
+
+		if (!g_queue_is_empty(&zc->pending)) {
+			/* the kernel still sends from our buffers; reset the connection, which drops the unsent
+			 * data, as the buffers get reused (for other responses) once we released them */
+			struct linger lin = { 1, 0 };
+			setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+		}
+	}
+
+	li_network_zerocopy_free(zc);
+}
+
+#else
+
+void li_network_zerocopy_reap(int fd, liNetworkZeroCopy *zc) {
+	UNUSED(fd); UNUSED(zc);
+}
+
+liNetworkStatus li_network_write_zerocopy(int fd, liChunkQueue *cq, goffset *write_max, liNetworkZeroCopy *zc, GError **err) {
+	UNUSED(zc);
+
+	return li_network_write_chunks(fd, cq, write_max, err);
+}
+
+void li_network_zerocopy_close(int fd, liNetworkZeroCopy *zc) {
+	UNUSED(fd);
+
+	li_network_zerocopy_free(zc);
+}
+
+#endif
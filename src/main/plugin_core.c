@@ -154,7 +154,7 @@ static void core_docroot_nth_cb(GString *pattern_result, guint to, guint from, g
 
 static liHandlerResult core_handle_docroot(liVRequest *vr, gpointer param, gpointer *context) {
 	guint i;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 	GArray *arr = param;
 	docroot_split dsplit = { vr->request.uri.host, NULL, 0 };
 
@@ -162,7 +162,7 @@ static liHandlerResult core_handle_docroot(liVRequest *vr, gpointer param, gpoin
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	/* resume from last stat check */
@@ -180,7 +180,7 @@ static liHandlerResult core_handle_docroot(liVRequest *vr, gpointer param, gpoin
 
 
 		g_string_truncate(vr->physical.doc_root, 0);
-		li_pattern_eval(vr, vr->physical.doc_root, g_array_index(arr, liPattern*, i), core_docroot_nth_cb, &dsplit, li_pattern_regex_cb, match_info);
+		li_pattern_eval(vr, vr->physical.doc_root, g_array_index(arr, liPattern*, i), core_docroot_nth_cb, &dsplit, li_pattern_regex_cb, match);
 
 		/* if there's only one entry and we're not debug logging, don't stat */
 		if (i == arr->len - 1 && !CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) break;
@@ -284,12 +284,12 @@ static liHandlerResult core_handle_alias(liVRequest *vr, gpointer _param, gpoint
 	GArray *param = _param;
 	guint i;
 	docroot_split dsplit = { vr->request.uri.host, NULL, 0 };
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 	UNUSED(context);
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	for (i = 0; i < param->len; i++) {
@@ -307,7 +307,7 @@ static liHandlerResult core_handle_alias(liVRequest *vr, gpointer _param, gpoint
 			if (isdir && vr->request.uri.path->str[preflen] != '\0' && vr->request.uri.path->str[preflen] != '/') continue;
 
 			g_string_truncate(vr->physical.doc_root, 0);
-			li_pattern_eval(vr, vr->physical.doc_root, ac.path, core_docroot_nth_cb, &dsplit, li_pattern_regex_cb, match_info);
+			li_pattern_eval(vr, vr->physical.doc_root, ac.path, core_docroot_nth_cb, &dsplit, li_pattern_regex_cb, match);
 
 			/* prefix matched */
 			if (CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) {
@@ -541,11 +541,41 @@ static liAction* core_index(liServer *srv, liWorker *wrk, liPlugin* p, liValue *
 }
 
 
+/* body from the content cache (buf) or the file */
+static void core_static_append(liChunkQueue *cq, liChunkFile *cf, liBuffer *buf, goffset start, goffset length) {
+	if (NULL != buf) {
+		li_buffer_acquire(buf);
+		li_chunkqueue_append_buffer2(cq, buf, start, length);
+	} else {
+		li_chunkqueue_append_chunkfile(cq, cf, start, length);
+	}
+}
+
+/* read small files into memory, so the body goes out in the same writev() as the response headers */
+static liBuffer* core_static_read(int fd, goffset size) {
+	liBuffer *buf = li_buffer_new(size);
+
+	while (buf->used < (gsize) size) {
+		ssize_t r = pread(fd, buf->addr + buf->used, size - buf->used, buf->used);
+		if (r < 0 && EINTR == errno) continue;
+		if (r <= 0) {
+			/* error or file got truncated: send from the file (fails later anyway) */
+			li_buffer_release(buf);
+			return NULL;
+		}
+		buf->used += r;
+	}
+
+	return buf;
+}
+
 static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpointer *context) {
-	int fd = -1;
+	liChunkFile *cf = NULL;
+	liBuffer *buf = NULL;
+	liContentCache *cc = vr->wrk->content_cache;
 	struct stat st;
 	int err;
-	liHandlerResult res;
+	liHandlerResult res = LI_HANDLER_GO_ON;
 	GPtrArray *exclude_arr = CORE_OPTIONPTR(LI_CORE_OPTION_STATIC_FILE_EXCLUDE_EXTENSIONS).list;
 	static const gchar boundary[] = "fkj49sn38dcn3";
 	gboolean no_fail = GPOINTER_TO_INT(param);
@@ -597,9 +627,29 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 		}
 	}
 
-	res = li_stat_cache_get(vr, vr->physical.path, &st, &err, &fd);
-	if (res == LI_HANDLER_WAIT_FOR_EVENT)
-		return res;
+	if (NULL != cc) {
+		/* small files may be in the content cache: no fd needed */
+		res = li_stat_cache_get(vr, vr->physical.path, &st, &err, NULL);
+		if (res == LI_HANDLER_WAIT_FOR_EVENT)
+			return res;
+
+		if (res == LI_HANDLER_GO_ON && li_content_cache_usable(cc, &st)) {
+			buf = li_content_cache_lookup(cc, vr->physical.path, &st);
+		}
+	}
+
+	if (NULL == buf && (NULL == cc || res != LI_HANDLER_ERROR)) {
+		res = li_stat_cache_get_chunkfile(vr, vr->physical.path, &st, &err, &cf);
+		if (res == LI_HANDLER_WAIT_FOR_EVENT)
+			return res;
+
+		if (res == LI_HANDLER_GO_ON && NULL != cf && li_content_cache_usable(cc, &st)) {
+			if (NULL != (buf = li_content_cache_insert(cc, vr->physical.path, &st, cf->fd))) {
+				li_chunkfile_release(cf);
+				cf = NULL;
+			}
+		}
+	}
 
 	if (CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) {
 		VR_DEBUG(vr, "try serving static file: '%s'", vr->physical.path->str);
@@ -608,9 +658,6 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 	if (res == LI_HANDLER_ERROR) {
 		/* open or fstat failed */
 
-		if (fd != -1)
-			close(fd);
-
 		if (no_fail) return LI_HANDLER_GO_ON;
 
 		if (!li_vrequest_handle_direct(vr)) {
@@ -634,16 +681,14 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 			return LI_HANDLER_GO_ON;
 		}
 	} else if (S_ISDIR(st.st_mode)) {
-		if (fd != -1)
-			close(fd);
+		li_chunkfile_release(cf);
 		return LI_HANDLER_GO_ON;
 	} else if (!S_ISREG(st.st_mode)) {
 		if (CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) {
 			VR_DEBUG(vr, "not a regular file: '%s'", vr->physical.path->str);
 		}
 
-		if (fd != -1)
-			close(fd);
+		li_chunkfile_release(cf);
 
 		if (no_fail) return LI_HANDLER_GO_ON;
 
@@ -655,28 +700,38 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 	} else {
 		const GString *mime_str;
 		gboolean cachable;
+		GString *etag, *last_modified;
 		gboolean ranged_response = FALSE;
 		liHttpHeader *hh_range;
-		liChunkFile *cf;
 		static const GString default_mime_str = { CONST_STR_LEN("application/octet-stream"), 0 };
 
 		if (!li_vrequest_handle_direct(vr)) {
-			close(fd);
+			li_chunkfile_release(cf);
+			li_buffer_release(buf);
 			return LI_HANDLER_ERROR;
 		}
 
-		li_etag_set_header(vr, &st, &cachable);
+		if (!CORE_OPTION(LI_CORE_OPTION_STATIC_HEADER_CACHE).boolean
+			|| !li_stat_cache_get_headers(vr, vr->physical.path, &st, &etag, &last_modified)) {
+			li_etag_set_header(vr, &st, &cachable);
+		} else {
+			li_etag_set_header_values(vr, etag, last_modified, &cachable);
+		}
 		if (cachable) {
 			vr->response.http_status = 304;
-			close(fd);
+			li_chunkfile_release(cf);
+			li_buffer_release(buf);
 			return LI_HANDLER_GO_ON;
 		}
 
-		cf = li_chunkfile_new(NULL, fd, FALSE);
-
 		mime_str = li_mimetype_get(vr, vr->physical.path);
 		if (!mime_str) mime_str = &default_mime_str;
 
+		if (NULL == buf && NULL != cf && LI_HTTP_METHOD_HEAD != vr->request.http_method
+			&& st.st_size > 0 && st.st_size <= CORE_OPTION(LI_CORE_OPTION_STATIC_INLINE_MAX_SIZE).number) {
+			buf = core_static_read(cf->fd, st.st_size);
+		}
+
 		if (CORE_OPTION(LI_CORE_OPTION_STATIC_RANGE_REQUESTS).boolean) {
 			li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Accept-Ranges"), CONST_STR_LEN("bytes"));
 
@@ -699,10 +754,10 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 							GString *subheader = g_string_sized_new(1023);
 							g_string_append_printf(subheader, "\r\n--%s\r\nContent-Type: %s\r\nContent-Range: %s\r\n\r\n", boundary, mime_str->str, vr->wrk->tmp_str->str);
 							li_chunkqueue_append_string(vr->direct_out, subheader);
-							li_chunkqueue_append_chunkfile(vr->direct_out, cf, rs.range_start, rs.range_length);
+							core_static_append(vr->direct_out, cf, buf, rs.range_start, rs.range_length);
 						} else {
 							li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Content-Range"), GSTR_LEN(vr->wrk->tmp_str));
-							li_chunkqueue_append_chunkfile(vr->direct_out, cf, rs.range_start, rs.range_length);
+							core_static_append(vr->direct_out, cf, buf, rs.range_start, rs.range_length);
 						}
 						break;
 					case LI_PARSE_HTTP_RANGE_DONE:
@@ -742,10 +797,11 @@ static liHandlerResult core_handle_static(liVRequest *vr, gpointer param, gpoint
 		if (!ranged_response) {
 			vr->response.http_status = 200;
 			li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Content-Type"), GSTR_LEN(mime_str));
-			li_chunkqueue_append_chunkfile(vr->direct_out, cf, 0, st.st_size);
+			core_static_append(vr->direct_out, cf, buf, 0, st.st_size);
 		}
 
 		li_chunkfile_release(cf);
+		li_buffer_release(buf);
 	}
 
 	return LI_HANDLER_GO_ON;
@@ -877,18 +933,18 @@ static void core_log_write_free(liServer *srv, gpointer param) {
 
 static liHandlerResult core_handle_log_write(liVRequest *vr, gpointer param, gpointer *context) {
 	liPattern *pattern = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	UNUSED(context);
 
 	/* eval pattern, ignore $n */
 	g_string_truncate(vr->wrk->tmp_str, 0);
-	li_pattern_eval(vr, vr->wrk->tmp_str, pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, vr->wrk->tmp_str, pattern, NULL, NULL, li_pattern_regex_cb, match);
 
 	VR_INFO(vr, "%s", vr->wrk->tmp_str->str);
 
@@ -935,7 +991,7 @@ static void core_respond_free(liServer *srv, gpointer param) {
 
 static liHandlerResult core_handle_respond(liVRequest *vr, gpointer param, gpointer *context) {
 	respond_param *rp = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	UNUSED(context);
 
@@ -944,7 +1000,7 @@ static liHandlerResult core_handle_respond(liVRequest *vr, gpointer param, gpoin
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	vr->response.http_status = rp->status_code;
@@ -954,7 +1010,7 @@ static liHandlerResult core_handle_respond(liVRequest *vr, gpointer param, gpoin
 
 	if (rp->pattern) {
 		g_string_truncate(vr->wrk->tmp_str, 0);
-		li_pattern_eval(vr, vr->wrk->tmp_str, rp->pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+		li_pattern_eval(vr, vr->wrk->tmp_str, rp->pattern, NULL, NULL, li_pattern_regex_cb, match);
 		li_chunkqueue_append_mem(vr->direct_out, GSTR_LEN(vr->wrk->tmp_str));
 	}
 
@@ -1023,17 +1079,17 @@ static void core_env_set_add_free(liServer *srv, gpointer param) {
 
 static liHandlerResult core_handle_env_set(liVRequest *vr, gpointer param, gpointer *context) {
 	env_set_add_ctx *ctx = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	UNUSED(context);
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(vr->wrk->tmp_str, 0);
-	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match);
 	li_environment_set(&vr->env, GSTR_LEN(ctx->key), GSTR_LEN(vr->wrk->tmp_str));
 
 	return LI_HANDLER_GO_ON;
@@ -1068,17 +1124,17 @@ static liAction* core_env_set(liServer *srv, liWorker *wrk, liPlugin* p, liValue
 
 static liHandlerResult core_handle_env_add(liVRequest *vr, gpointer param, gpointer *context) {
 	env_set_add_ctx *ctx = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	UNUSED(context);
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(vr->wrk->tmp_str, 0);
-	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match);
 	li_environment_insert(&vr->env, GSTR_LEN(ctx->key), GSTR_LEN(vr->wrk->tmp_str));
 
 	return LI_HANDLER_GO_ON;
@@ -1185,6 +1241,73 @@ fail:
 	return FALSE;
 }
 
+static gboolean core_listen_reuse_port(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_STRING == li_value_type(val)) {
+		li_value_wrap_in_list(val);
+	} else if (LI_VALUE_LIST != li_value_type(val)) {
+		goto fail;
+	}
+
+	LI_VALUE_FOREACH(ip, val);
+		if (LI_VALUE_STRING != li_value_type(ip)) goto fail;
+	LI_VALUE_END_FOREACH()
+
+	/* sockets are requested in prepare, when the worker count is known */
+	LI_VALUE_FOREACH(ip, val);
+		g_ptr_array_add(srv->reuseport_listen, li_value_extract_string(ip));
+	LI_VALUE_END_FOREACH()
+
+	return TRUE;
+
+fail:
+	ERROR(srv, "%s", "listen.reuse_port expects a string or list of strings as parameter");
+	return FALSE;
+}
+
+typedef struct core_reuseport_ctx core_reuseport_ctx;
+struct core_reuseport_ctx {
+	liServerStateWait sw;
+	GString *address;
+};
+
+static void core_listen_reuse_port_cb(liServer *srv, GArray *fds, gpointer data) {
+	core_reuseport_ctx *ctx = data;
+
+	if (NULL != fds) {
+		guint i;
+
+		if (ctx->sw.active) {
+			/* workers are not running yet (waiting for us to reach "suspended"), safe to attach the sockets */
+			for (i = 0; i < fds->len; i++) {
+				liWorker *wrk = g_array_index(srv->workers, liWorker*, i);
+				li_server_listen_worker(srv, wrk, g_array_index(fds, int, i));
+			}
+			DEBUG(srv, "listening on '%s' with %u SO_REUSEPORT sockets", ctx->address->str, fds->len);
+		} else {
+			for (i = 0; i < fds->len; i++) close(g_array_index(fds, int, i));
+		}
+	}
+
+	li_server_state_ready(srv, &ctx->sw);
+	g_slice_free(core_reuseport_ctx, ctx);
+}
+
+static void plugin_core_prepare(liServer *srv, liPlugin *p) {
+	guint i;
+	UNUSED(p);
+
+	for (i = 0; i < srv->reuseport_listen->len; i++) {
+		core_reuseport_ctx *ctx = g_slice_new0(core_reuseport_ctx);
+		ctx->address = g_ptr_array_index(srv->reuseport_listen, i);
+
+		li_server_state_wait(srv, &ctx->sw);
+		li_angel_listen_reuseport(srv, ctx->address, srv->worker_count, core_listen_reuse_port_cb, ctx);
+	}
+}
 
 static gboolean core_workers(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
 	gint workers;
@@ -1298,6 +1421,99 @@ static gboolean core_io_timeout(liServer *srv, liPlugin* p, liValue *val, gpoint
 	return TRUE;
 }
 
+static gboolean core_io_uring(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_BOOLEAN == li_value_type(val)) {
+		srv->io_uring_entries = val->data.boolean ? LI_URING_DEFAULT_ENTRIES : 0;
+		return TRUE;
+	}
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0 || val->data.number > 32768) {
+		ERROR(srv, "%s", "io.uring expects a boolean or a number of entries (0 - 32768) as parameter");
+		return FALSE;
+	}
+
+	srv->io_uring_entries = (guint)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_io_zerocopy(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0) {
+		ERROR(srv, "%s", "io.zerocopy expects a positive number (minimum size in bytes, 0 to disable) as parameter");
+		return FALSE;
+	}
+
+	srv->zerocopy_min_size = val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_io_notsent_lowat(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0 || val->data.number > G_MAXINT) {
+		ERROR(srv, "%s", "io.notsent_lowat expects a positive number (size in bytes, 0 to disable) as parameter");
+		return FALSE;
+	}
+
+	srv->notsent_lowat = val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_io_buffer_pool(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0) {
+		ERROR(srv, "%s", "io.buffer_pool expects a positive number (size in bytes, 0 to disable) as parameter");
+		return FALSE;
+	}
+
+	srv->buffer_pool_max_free = val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_regex_engine(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	liRegexEngine engine;
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_STRING != li_value_type(val)) {
+		ERROR(srv, "%s", "regex.engine expects a string as parameter: \"pcre2\" or \"glib\"");
+		return FALSE;
+	}
+
+	if (g_str_equal(val->data.string->str, "pcre2")) {
+		engine = LI_REGEX_ENGINE_PCRE2;
+	} else if (g_str_equal(val->data.string->str, "glib")) {
+		engine = LI_REGEX_ENGINE_GLIB;
+	} else {
+		ERROR(srv, "unknown regex engine \"%s\", expected \"pcre2\" or \"glib\"", val->data.string->str);
+		return FALSE;
+	}
+
+	if (!li_regex_engine_set(engine)) {
+		ERROR(srv, "%s", "regex.engine \"pcre2\" is not available (built without pcre2)");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 static gboolean core_stat_cache_ttl(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
 	UNUSED(p); UNUSED(userdata);
 
@@ -1313,6 +1529,101 @@ static gboolean core_stat_cache_ttl(liServer *srv, liPlugin* p, liValue *val, gp
 	return TRUE;
 }
 
+static gboolean core_stat_cache_inotify_ttl(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0) {
+		ERROR(srv, "%s", "stat_cache.inotify_ttl expects a positive number as parameter");
+		return FALSE;
+	}
+
+	srv->stat_cache_inotify_ttl = (gdouble)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_stat_cache_shared(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_BOOLEAN == li_value_type(val)) {
+		srv->stat_cache_shared_entries = val->data.boolean ? 4096 : 0;
+		return TRUE;
+	}
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0 || val->data.number > (1 << 24)) {
+		ERROR(srv, "%s", "stat_cache.shared expects a boolean or a number of entries (0 - 16777216) as parameter");
+		return FALSE;
+	}
+
+	srv->stat_cache_shared_entries = (guint)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_stat_cache_fd_cache(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0 || val->data.number > 65536) {
+		ERROR(srv, "%s", "stat_cache.fd_cache expects a number of files (0 - 65536) as parameter");
+		return FALSE;
+	}
+
+	srv->stat_cache_fd_entries = (guint)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_stat_cache_header_cache(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 1 || val->data.number > 1048576) {
+		ERROR(srv, "%s", "stat_cache.header_cache expects a number of files (1 - 1048576) as parameter");
+		return FALSE;
+	}
+
+	srv->stat_cache_header_entries = (guint)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_content_cache_memory(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number < 0) {
+		ERROR(srv, "%s", "content_cache.memory expects a positive number as parameter");
+		return FALSE;
+	}
+
+	srv->content_cache_memory = (guint64)val->data.number;
+
+	return TRUE;
+}
+
+static gboolean core_content_cache_max_file_size(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
+	UNUSED(p); UNUSED(userdata);
+
+	val = li_value_get_single_argument(val);
+
+	if (LI_VALUE_NUMBER != li_value_type(val) || val->data.number <= 0) {
+		ERROR(srv, "%s", "content_cache.max_file_size expects a positive number as parameter");
+		return FALSE;
+	}
+
+	srv->content_cache_max_file_size = (goffset)val->data.number;
+
+	return TRUE;
+}
+
 static gboolean core_tasklet_pool_threads(liServer *srv, liPlugin* p, liValue *val, gpointer userdata) {
 	UNUSED(p); UNUSED(userdata);
 
@@ -1595,17 +1906,17 @@ static void core_header_free(liServer *srv, gpointer param) {
 
 static liHandlerResult core_handle_header(liVRequest *vr, gpointer param, gpointer *context) {
 	header_ctx *ctx = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	UNUSED(context);
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(vr->wrk->tmp_str, 0);
-	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->value, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, vr->wrk->tmp_str, ctx->value, NULL, NULL, li_pattern_regex_cb, match);
 
 	ctx->cb(ctx->use_req_header ? vr->request.headers : vr->response.headers, GSTR_LEN(ctx->key), GSTR_LEN(vr->wrk->tmp_str));
 
@@ -1796,17 +2107,17 @@ static void core_map_free(liServer *srv, gpointer param) {
 static liHandlerResult core_handle_map(liVRequest *vr, gpointer param, gpointer *context) {
 	liValue *v;
 	core_map_data *md = param;
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 	UNUSED(context);
 
 	g_string_truncate(vr->wrk->tmp_str, 0);
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
-	li_pattern_eval(vr, vr->wrk->tmp_str, md->pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, vr->wrk->tmp_str, md->pattern, NULL, NULL, li_pattern_regex_cb, match);
 	v = g_hash_table_lookup(md->hash, vr->wrk->tmp_str);
 	if (NULL != v) {
 		li_action_enter(vr, v->data.val_action.action);
@@ -2069,6 +2380,8 @@ static const liPluginOption options[] = {
 	{ "debug.log_request_handling", LI_VALUE_BOOLEAN, FALSE, NULL },
 
 	{ "static.range_requests", LI_VALUE_BOOLEAN, TRUE, NULL },
+	{ "static.header_cache", LI_VALUE_BOOLEAN, FALSE, NULL },
+	{ "static.inline_max_size", LI_VALUE_NUMBER, 0, NULL },
 
 	{ "keepalive.timeout", LI_VALUE_NUMBER, 5, NULL },
 	{ "keepalive.requests", LI_VALUE_NUMBER, 0, NULL },
@@ -2081,6 +2394,8 @@ static const liPluginOption options[] = {
 
 	{ "strict.post_content_length", LI_VALUE_BOOLEAN, TRUE, NULL },
 
+	{ "backend.splice", LI_VALUE_BOOLEAN, FALSE, NULL },
+
 	{ NULL, 0, 0, NULL }
 };
 
@@ -2138,11 +2453,23 @@ static const liPluginAction actions[] = {
 
 static const liPluginSetup setups[] = {
 	{ "listen", core_listen, NULL },
+	{ "listen.reuse_port", core_listen_reuse_port, NULL },
 	{ "workers", core_workers, NULL },
 	{ "workers.cpu_affinity", core_workers_cpu_affinity, NULL },
 	{ "module_load", core_module_load, NULL },
 	{ "io.timeout", core_io_timeout, NULL },
+	{ "io.uring", core_io_uring, NULL },
+	{ "io.zerocopy", core_io_zerocopy, NULL },
+	{ "io.notsent_lowat", core_io_notsent_lowat, NULL },
+	{ "io.buffer_pool", core_io_buffer_pool, NULL },
+	{ "regex.engine", core_regex_engine, NULL },
 	{ "stat_cache.ttl", core_stat_cache_ttl, NULL },
+	{ "stat_cache.inotify_ttl", core_stat_cache_inotify_ttl, NULL },
+	{ "stat_cache.shared", core_stat_cache_shared, NULL },
+	{ "stat_cache.fd_cache", core_stat_cache_fd_cache, NULL },
+	{ "stat_cache.header_cache", core_stat_cache_header_cache, NULL },
+	{ "content_cache.memory", core_content_cache_memory, NULL },
+	{ "content_cache.max_file_size", core_content_cache_max_file_size, NULL },
 	{ "tasklet_pool.threads", core_tasklet_pool_threads, NULL },
 	{ "log", core_setup_log, NULL },
 	{ "log.timestamp", core_setup_log_timestamp, NULL },
@@ -2246,5 +2573,6 @@ void li_plugin_core_init(liServer *srv, liPlugin *p, gpointer userdata) {
 	p->setups = setups;
 	p->angelcbs = angelcbs;
 
+	p->handle_prepare = plugin_core_prepare;
 	p->handle_prepare_worker = plugin_core_prepare_worker;
 }
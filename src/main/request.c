@@ -17,7 +17,7 @@ void li_request_init(liRequest *req) {
 	req->uri.query = g_string_sized_new(0);
 	req->uri.host = g_string_sized_new(0);
 
-	req->headers = li_http_headers_new();
+	req->headers = li_http_headers_new_with_arena(LI_HTTP_HEADERS_ARENA_BLOCK_SIZE);
 
 	req->content_length = -1;
 }
@@ -5,7 +5,7 @@
 #include <lighttpd/lighttpd-glue.h>
 
 void li_response_init(liResponse *resp) {
-	resp->headers = li_http_headers_new();
+	resp->headers = li_http_headers_new_with_arena(LI_HTTP_HEADERS_ARENA_BLOCK_SIZE);
 	resp->http_status = 0;
 	resp->transfer_encoding = LI_HTTP_TRANSFER_ENCODING_IDENTITY;
 }
@@ -39,8 +39,6 @@ void li_response_send_headers(liVRequest *vr, liChunkQueue *raw_out, liChunkQueu
 	have_real_body = (NULL != response_body) && ((response_body->length > 0) || !response_body->is_closed);
 	response_complete = (NULL != response_body) && response_body->is_closed;
 
-	head = g_string_sized_new(8*1024-1);
-
 	if (!have_real_body && vr->response.http_status >= 400 && vr->response.http_status < 600) {
 		tmp_cq = li_chunkqueue_new(); /* create a temporary cq for the response body */
 		response_body = tmp_cq;
@@ -78,6 +76,19 @@ void li_response_send_headers(liVRequest *vr, liChunkQueue *raw_out, liChunkQueu
 		if (!upgraded) raw_out->is_closed = TRUE;
 	}
 
+	{
+		/* allocate the exact size instead of a fixed 8k buffer: status line, connection, date
+		 * and server headers (without tag) fit in 128 bytes */
+		gsize size = 128 + CORE_OPTIONPTR(LI_CORE_OPTION_SERVER_TAG).string->len;
+		GList *iter;
+
+		for (iter = g_queue_peek_head_link(&vr->response.headers->entries); iter; iter = g_list_next(iter)) {
+			size += ((liHttpHeader*) iter->data)->data->len + 2;
+		}
+
+		head = g_string_sized_new(size);
+	}
+
 	/* Status line */
 	if (vr->request.http_version == LI_HTTP_VERSION_1_1) {
 		g_string_append_len(head, CONST_STR_LEN("HTTP/1.1 "));
@@ -16,13 +16,13 @@ static void li_server_stop(liServer *srv);
 static void state_ready_cb(liEventBase *watcher, int events);
 static void li_server_1sec_timer(liEventBase *watcher, int events);
 
-static liServerSocket* server_socket_new(liServer *srv, int fd) {
+static liServerSocket* server_socket_new(liWorker *wrk, int fd) {
 	liServerSocket *sock = g_slice_new0(liServerSocket);
 
 	sock->local_addr = li_sockaddr_local_from_socket(fd);
 	sock->refcount = 1;
 	li_fd_no_block(fd);
-	li_event_io_init(&srv->main_worker->loop, "server socket", &sock->watcher, li_server_listen_cb, fd, LI_EV_READ);
+	li_event_io_init(&wrk->loop, "server socket", &sock->watcher, li_server_listen_cb, fd, LI_EV_READ);
 	return sock;
 }
 
@@ -85,6 +85,7 @@ liServer* li_server_new(const gchar *module_dir, gboolean module_resident) {
 	srv->worker_count = 0;
 
 	srv->sockets = g_ptr_array_new();
+	srv->reuseport_listen = g_ptr_array_new();
 
 	srv->modules = li_modules_new(srv, module_dir, module_resident);
 
@@ -143,7 +144,10 @@ liServer* li_server_new(const gchar *module_dir, gboolean module_resident) {
 
 	srv->io_timeout = 300; /* default I/O timeout */
 	srv->keep_alive_queue_timeout = 5;
+	srv->buffer_pool_max_free = 4 * 1024 * 1024; /* default max memory in free buffers per worker */
 	srv->stat_cache_ttl = 10.0; /* default stat cache ttl */
+	srv->stat_cache_header_entries = 4096; /* default max entries in the static.header_cache per worker */
+	srv->content_cache_max_file_size = 16 * 1024; /* default max size of files in content cache */
 	srv->tasklet_pool_threads = 4; /* default per-worker tasklet_pool threads */
 
 	return srv;
@@ -204,6 +208,9 @@ void li_server_free(liServer* srv) {
 		g_array_free(srv->workers, TRUE);
 	}
 
+	li_stat_cache_shared_free(srv->stat_cache_shared);
+	srv->stat_cache_shared = NULL;
+
 	{
 		guint i; for (i = 0; i < srv->sockets->len; i++) {
 			liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
@@ -214,6 +221,13 @@ void li_server_free(liServer* srv) {
 		g_ptr_array_free(srv->sockets, TRUE);
 	}
 
+	{
+		guint i; for (i = 0; i < srv->reuseport_listen->len; i++) {
+			g_string_free(g_ptr_array_index(srv->reuseport_listen, i), TRUE);
+		}
+		g_ptr_array_free(srv->reuseport_listen, TRUE);
+	}
+
 	g_hash_table_remove_all(srv->fetch_backends);
 
 	/* release modules */
@@ -313,6 +327,7 @@ static void li_server_1sec_timer(liEventBase *watcher, int events) {
 
 			for (i = 0; i < srv->sockets->len; i++) {
 				liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
+				if (NULL != sock->wrk) continue; /* workers handle their own sockets */
 				li_event_start(&sock->watcher);
 			}
 			srv->connection_limit_hit = FALSE;
@@ -329,6 +344,12 @@ static gboolean li_server_worker_init(liServer *srv) {
 	li_plugins_init_lua(&srv->main_worker->LL, srv, srv->main_worker);
 
 	if (srv->worker_count < 1) srv->worker_count = 1;
+
+	/* the workers pick up the shared table when they create their stat cache */
+	if (srv->stat_cache_ttl > 0 && srv->stat_cache_shared_entries > 0) {
+		srv->stat_cache_shared = li_stat_cache_shared_new(srv->stat_cache_shared_entries, srv->stat_cache_ttl);
+	}
+
 	g_array_set_size(srv->workers, srv->worker_count);
 	g_array_index(srv->workers, liWorker*, 0) = srv->main_worker;
 
@@ -374,6 +395,7 @@ static void server_connection_limit_hit(liServer *srv) {
 
 	for (i = 0; i < srv->sockets->len; i++) {
 		liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
+		if (NULL != sock->wrk) continue; /* workers handle their own sockets */
 		li_event_stop(&sock->watcher);
 	}
 
@@ -384,70 +406,100 @@ static void server_connection_limit_hit(liServer *srv) {
 static void li_server_listen_cb(liEventBase *watcher, int events) {
 	liServerSocket *sock = LI_CONTAINER_OF(li_event_io_from(watcher), liServerSocket, watcher);
 	liServer *srv = sock->srv;
-	int s;
-	liSocketAddress remote_addr;
-	liSockAddr sa;
+	liWorker *ctx = (NULL != sock->wrk) ? sock->wrk : srv->main_worker;
+	liWorkerNewCon cons[LI_ACCEPT_BATCH], batch[LI_ACCEPT_BATCH];
+	guint cons_wrk[LI_ACCEPT_BATCH];
+	guint srv_cur_load, srv_max_load, max_accept, n, i, w, count;
+	guint *loads;
+	li_tstamp ts_accepted;
+	int s, accept_errno;
 	socklen_t l;
 	int fd = li_event_io_fd(li_event_io_from(watcher));
 	UNUSED(events);
 
-	for ( ;; ) {
-		liWorker *wrk;
-		guint i, min_load, srv_cur_load, srv_max_load;
-
-		srv_cur_load = g_atomic_int_get(&srv->connection_load);
-		srv_max_load = g_atomic_int_get(&srv->max_connections);
-		if (srv_cur_load >= srv_max_load) {
+	srv_cur_load = g_atomic_int_get(&srv->connection_load);
+	srv_max_load = g_atomic_int_get(&srv->max_connections);
+	if (srv_cur_load >= srv_max_load) {
+		if (NULL != sock->wrk) {
+			li_worker_listen_limit_hit(sock->wrk);
+		} else {
 			server_connection_limit_hit(srv);
-			return;
 		}
+		return;
+	}
+	max_accept = MIN(LI_ACCEPT_BATCH, srv_max_load - srv_cur_load);
+
+	/* accept a batch; if the backlog has more, the watcher triggers again in the next loop iteration */
+	for (n = 0; n < max_accept; n++) {
+		liWorkerNewCon *nc = &cons[n];
 
-		l = sizeof(sa);
+		l = sizeof(nc->remote_addr);
 
 #ifdef HAVE_ACCEPT4
-		if (-1 == (s = accept4(fd, &sa.plain, &l, SOCK_NONBLOCK))) {
+		if (-1 == (s = accept4(fd, &nc->remote_addr.plain, &l, SOCK_NONBLOCK))) {
 			if (ENOSYS != errno) break;
 
 			/* fallback */
-			if (-1 == (s = accept(fd, &sa.plain, &l))) break;
+			if (-1 == (s = accept(fd, &nc->remote_addr.plain, &l))) break;
 			li_fd_no_block(s); /* we don't fork, don't care about FD_CLOEXEC */
 		}
 #else
-		if (-1 == (s = accept(fd, &sa.plain, &l))) break;
+		if (-1 == (s = accept(fd, &nc->remote_addr.plain, &l))) break;
 		li_fd_no_block(s); /* we don't fork, don't care about FD_CLOEXEC */
 #endif
 
-		wrk = srv->main_worker;
-		min_load = g_atomic_int_get(&wrk->connection_load);
-
-		if (l <= sizeof(sa)) {
-			remote_addr.addr = g_slice_alloc(l);
-			remote_addr.len = l;
-			memcpy(remote_addr.addr, &sa, l);
-		} else {
-			remote_addr = li_sockaddr_remote_from_socket(s);
-		}
-
-		for (i = 1; i < srv->worker_count; i++) {
-			liWorker *wt = g_array_index(srv->workers, liWorker*, i);
-			guint load = g_atomic_int_get(&wt->connection_load);
-			if (load < min_load) {
-				wrk = wt;
-				min_load = load;
-			}
-		}
-
-		g_atomic_int_inc((gint*) &wrk->connection_load);
-		g_atomic_int_inc((gint*) &srv->connection_load);
+		nc->remote_addr_len = MIN(l, (socklen_t) sizeof(nc->remote_addr));
+		nc->s = s;
+		nc->srv_sock = sock;
 		li_server_socket_acquire(sock);
-		li_worker_new_con(srv->main_worker, wrk, remote_addr, s, sock);
 	}
 
 #ifdef _WIN32
 	errno = WSAGetLastError();
 #endif
+	accept_errno = (n < max_accept) ? errno : 0;
+
+	if (n > 0) {
+		ts_accepted = li_event_monotonic_time();
+		g_atomic_int_add((gint*) &srv->connection_load, n);
+
+		if (NULL != sock->wrk) {
+			/* SO_REUSEPORT: the kernel already balanced the connections to this worker */
+			g_atomic_int_add((gint*) &sock->wrk->connection_load, n);
+			li_worker_new_cons(ctx, sock->wrk, cons, n, ts_accepted);
+		} else {
+			/* balance on a snapshot of the worker loads */
+			loads = g_newa(guint, srv->worker_count);
+			for (w = 0; w < srv->worker_count; w++) {
+				loads[w] = g_atomic_int_get(&g_array_index(srv->workers, liWorker*, w)->connection_load);
+			}
+
+			for (i = 0; i < n; i++) {
+				guint min_w = 0;
+				for (w = 1; w < srv->worker_count; w++) {
+					if (loads[w] < loads[min_w]) min_w = w;
+				}
+				loads[min_w]++;
+				cons_wrk[i] = min_w;
+			}
+
+			/* one handoff per worker */
+			for (w = 0; w < srv->worker_count; w++) {
+				liWorker *wrk = g_array_index(srv->workers, liWorker*, w);
+
+				for (i = 0, count = 0; i < n; i++) {
+					if (cons_wrk[i] == w) batch[count++] = cons[i];
+				}
+				if (0 == count) continue;
+
+				g_atomic_int_add((gint*) &wrk->connection_load, count);
+				li_worker_new_cons(ctx, wrk, batch, count, ts_accepted);
+			}
+		}
+	}
 
-	switch (errno) {
+	switch (accept_errno) {
+	case 0: /* batch full */
 	case EAGAIN:
 #if EWOULDBLOCK != EAGAIN
 	case EWOULDBLOCK:
@@ -463,14 +515,14 @@ static void li_server_listen_cb(liEventBase *watcher, int events) {
 		/* TODO: disable accept callbacks? */
 		break;
 	default:
-		ERROR(srv, "accept failed on fd=%d with error: %s", fd, g_strerror(errno));
+		ERROR(srv, "accept failed on fd=%d with error: %s", fd, g_strerror(accept_errno));
 		break;
 	}
 }
 
 /* main worker only */
 liServerSocket* li_server_listen(liServer *srv, int fd) {
-	liServerSocket *sock = server_socket_new(srv, fd);
+	liServerSocket *sock = server_socket_new(srv->main_worker, fd);
 
 	sock->srv = srv;
 	g_ptr_array_add(srv->sockets, sock);
@@ -480,13 +532,35 @@ liServerSocket* li_server_listen(liServer *srv, int fd) {
 	return sock;
 }
 
+/* main worker only, before the worker threads are started */
+liServerSocket* li_server_listen_worker(liServer *srv, liWorker *wrk, int fd) {
+	liServerSocket *sock;
+
+	LI_FORCE_ASSERT(LI_SERVER_LOADING == srv->state);
+
+	sock = server_socket_new(wrk, fd);
+	sock->srv = srv;
+	sock->wrk = wrk;
+	g_ptr_array_add(srv->sockets, sock);
+	g_ptr_array_add(wrk->listen_sockets, sock);
+
+	return sock;
+}
+
 static void li_server_start_listen(liServer *srv) {
 	guint i;
 
 	for (i = 0; i < srv->sockets->len; i++) {
 		liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
+		if (NULL != sock->wrk) continue;
 		li_event_start(&sock->watcher);
 	}
+
+	for (i = 0; i < srv->worker_count; i++) {
+		liWorker *wrk;
+		wrk = g_array_index(srv->workers, liWorker*, i);
+		li_worker_listen(srv->main_worker, wrk, TRUE);
+	}
 }
 
 static void li_server_stop_listen(liServer *srv) {
@@ -494,6 +568,7 @@ static void li_server_stop_listen(liServer *srv) {
 
 	for (i = 0; i < srv->sockets->len; i++) {
 		liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
+		if (NULL != sock->wrk) continue;
 		li_event_stop(&sock->watcher);
 	}
 	srv->connection_limit_hit = FALSE; /* reset flag */
@@ -502,6 +577,7 @@ static void li_server_stop_listen(liServer *srv) {
 	for (i = 0; i < srv->worker_count; i++) {
 		liWorker *wrk;
 		wrk = g_array_index(srv->workers, liWorker*, i);
+		li_worker_listen(srv->main_worker, wrk, FALSE);
 		li_worker_suspend(srv->main_worker, wrk);
 	}
 }
@@ -511,6 +587,7 @@ static void li_server_stop(liServer *srv) {
 
 	for (i = 0; i < srv->sockets->len; i++) {
 		liServerSocket *sock = g_ptr_array_index(srv->sockets, i);
+		if (NULL != sock->wrk) continue; /* stopped by li_worker_stop */
 		li_event_stop(&sock->watcher);
 	}
 	srv->connection_limit_hit = FALSE; /* reset flag */
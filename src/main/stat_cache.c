@@ -4,12 +4,50 @@
 
 #include <lighttpd/plugin_core.h>
 
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT)
+# define USE_INOTIFY
+# include <sys/inotify.h>
+#endif
+
+struct liStatCacheWatch {
+	int wd;
+	GQueue entries;                   /* liStatCacheEntry* (linked with sce->watch_link) */
+};
+
+/* open fd cache entry */
+typedef struct stat_cache_file stat_cache_file;
+struct stat_cache_file {
+	GString *path;
+	liChunkFile *cf;                  /* the cache holds one reference */
+	struct stat st;                   /* fstat() after open() */
+	liWaitQueueElem queue_elem;
+};
+
+/* precomputed header values for static files */
+typedef struct stat_cache_headers stat_cache_headers;
+struct stat_cache_headers {
+	GString *path;
+	struct stat st;                   /* only identity fields are compared */
+	guint etag_flags;
+	GString *etag;                    /* NULL if etag_flags == 0 */
+	GString *last_modified;           /* NULL if mtime couldn't be formatted */
+	liWaitQueueElem queue_elem;
+};
+
 static void stat_cache_delete_cb(liWaitQueue *wq, gpointer daa);
+static void stat_cache_headers_delete_cb(liWaitQueue *wq, gpointer data);
+static void stat_cache_headers_remove(liStatCache *sc, stat_cache_headers *sch);
+static void stat_cache_file_delete_cb(liWaitQueue *wq, gpointer data);
+static void stat_cache_file_remove(liStatCache *sc, stat_cache_file *scf);
+static void stat_cache_file_drop(liStatCache *sc, GString *path);
+#ifdef USE_INOTIFY
+static void stat_cache_inotify_cb(liEventBase *watcher, int events);
+#endif
 
 static void stat_cache_entry_release(liStatCacheEntry *sce);
 static void stat_cache_entry_acquire(liStatCacheEntry *sce);
 
-liStatCache* li_stat_cache_new(liWorker *wrk, gdouble ttl) {
+liStatCache* li_stat_cache_new(liWorker *wrk, gdouble ttl, gdouble inotify_ttl) {
 	liStatCache *sc;
 
 	if (ttl < 0) {
@@ -27,10 +65,69 @@ liStatCache* li_stat_cache_new(liWorker *wrk, gdouble ttl) {
 
 	li_waitqueue_init(&sc->delete_queue, &wrk->loop, "stat cache delete queue", stat_cache_delete_cb, ttl, sc);
 
+	sc->inotify_fd = -1;
+#ifdef USE_INOTIFY
+	if (inotify_ttl > 0) {
+		sc->inotify_fd = inotify_init();
+		if (-1 == sc->inotify_fd) {
+			ERROR(wrk->srv, "inotify_init failed, using stat cache without inotify: %s", g_strerror(errno));
+		}
+	}
+
+	if (-1 != sc->inotify_fd) {
+		li_fd_init(sc->inotify_fd);
+		sc->watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+		li_event_io_init(&wrk->loop, "stat cache inotify", &sc->inotify_watcher, stat_cache_inotify_cb, sc->inotify_fd, LI_EV_READ);
+		li_event_set_keep_loop_alive(&sc->inotify_watcher, FALSE);
+		li_event_start(&sc->inotify_watcher);
+	}
+#else
+	if (inotify_ttl > 0) {
+		ERROR(wrk->srv, "%s", "inotify not supported, using stat cache without inotify");
+	}
+#endif
+	/* only used with a watch, so the queue stays empty without inotify */
+	li_waitqueue_init(&sc->watch_queue, &wrk->loop, "stat cache watch queue", stat_cache_delete_cb, inotify_ttl > 0 ? inotify_ttl : ttl, sc);
+
+	sc->shared = wrk->srv->stat_cache_shared;
+
+	if (wrk->srv->stat_cache_fd_entries > 0) {
+		sc->files = g_hash_table_new((GHashFunc)g_string_hash, (GEqualFunc)g_string_equal);
+		sc->files_max = wrk->srv->stat_cache_fd_entries;
+	}
+	/* fds are kept at most for one TTL, so changes (that weren't noticed) can't be served forever */
+	li_waitqueue_init(&sc->file_queue, &wrk->loop, "stat cache fd queue", stat_cache_file_delete_cb, ttl, sc);
+
+	sc->headers = g_hash_table_new((GHashFunc)g_string_hash, (GEqualFunc)g_string_equal);
+	sc->headers_max = wrk->srv->stat_cache_header_entries;
+	li_waitqueue_init(&sc->headers_queue, &wrk->loop, "stat cache headers queue", stat_cache_headers_delete_cb, ttl, sc);
+
 	return sc;
 }
 
+static void stat_cache_unwatch(liStatCache *sc, liStatCacheEntry *sce) {
+	liStatCacheWatch *watch = sce->watch;
+
+	if (NULL == watch) return;
+
+	g_queue_unlink(&watch->entries, &sce->watch_link);
+	sce->watch = NULL;
+	g_free(sce->watch_name);
+	sce->watch_name = NULL;
+
+	if (0 == watch->entries.length) {
+#ifdef USE_INOTIFY
+		/* may fail if the kernel already dropped the watch (IN_IGNORED) */
+		inotify_rm_watch(sc->inotify_fd, watch->wd);
+#endif
+		g_hash_table_remove(sc->watches, GINT_TO_POINTER(watch->wd));
+		g_slice_free(liStatCacheWatch, watch);
+	}
+}
+
 static void stat_cache_remove_from_cache(liStatCache *sc, liStatCacheEntry *sce) {
+	stat_cache_unwatch(sc, sce);
+
 	if (sce->cached) {
 		if (sce->type == STAT_CACHE_ENTRY_SINGLE) {
 			g_hash_table_remove(sc->entries, sce->data.path);
@@ -52,16 +149,60 @@ void li_stat_cache_free(liStatCache *sc) {
 
 	li_waitqueue_stop(&sc->delete_queue);
 
+	li_waitqueue_stop(&sc->watch_queue);
+
 	while (NULL != (wqe = li_waitqueue_pop_force(&sc->delete_queue))) {
 		liStatCacheEntry *sce = wqe->data;
 		stat_cache_remove_from_cache(sc, sce);
 	}
 
+	while (NULL != (wqe = li_waitqueue_pop_force(&sc->watch_queue))) {
+		liStatCacheEntry *sce = wqe->data;
+		stat_cache_remove_from_cache(sc, sce);
+	}
+
+	li_waitqueue_stop(&sc->file_queue);
+
+	while (NULL != (wqe = li_waitqueue_pop_force(&sc->file_queue))) {
+		stat_cache_file_remove(sc, wqe->data);
+	}
+
+	if (NULL != sc->files) {
+		g_hash_table_destroy(sc->files);
+	}
+
+	li_waitqueue_stop(&sc->headers_queue);
+
+	while (NULL != (wqe = li_waitqueue_pop_force(&sc->headers_queue))) {
+		stat_cache_headers_remove(sc, wqe->data);
+	}
+
+	g_hash_table_destroy(sc->headers);
+
+	if (-1 != sc->inotify_fd) {
+		li_event_clear(&sc->inotify_watcher);
+		close(sc->inotify_fd);
+		sc->inotify_fd = -1;
+		g_hash_table_destroy(sc->watches);
+	}
+
 	g_hash_table_destroy(sc->entries);
 	g_hash_table_destroy(sc->dirlists);
 	g_slice_free(liStatCache, sc);
 }
 
+void li_stat_cache_stop(liStatCache *sc) {
+	if (!sc)
+		return;
+
+	li_waitqueue_stop(&sc->delete_queue);
+	li_waitqueue_stop(&sc->watch_queue);
+	li_waitqueue_stop(&sc->file_queue);
+	li_waitqueue_stop(&sc->headers_queue);
+	if (-1 != sc->inotify_fd)
+		li_event_stop(&sc->inotify_watcher);
+}
+
 static void stat_cache_delete_cb(liWaitQueue *wq, gpointer data) {
 	liStatCache *sc = data;
 	liWaitQueueElem *wqe;
@@ -76,6 +217,176 @@ static void stat_cache_delete_cb(liWaitQueue *wq, gpointer data) {
 	li_waitqueue_update(wq);
 }
 
+/* open fd cache */
+
+/* element must already be removed from the file_queue */
+static void stat_cache_file_remove(liStatCache *sc, stat_cache_file *scf) {
+	g_hash_table_remove(sc->files, scf->path);
+	li_chunkfile_release(scf->cf);
+	g_string_free(scf->path, TRUE);
+	g_slice_free(stat_cache_file, scf);
+}
+
+static void stat_cache_file_drop(liStatCache *sc, GString *path) {
+	stat_cache_file *scf;
+
+	if (NULL == sc->files || NULL == (scf = g_hash_table_lookup(sc->files, path))) return;
+
+	li_waitqueue_remove(&sc->file_queue, &scf->queue_elem);
+	stat_cache_file_remove(sc, scf);
+}
+
+static void stat_cache_file_delete_cb(liWaitQueue *wq, gpointer data) {
+	liStatCache *sc = data;
+	liWaitQueueElem *wqe;
+
+	while ((wqe = li_waitqueue_pop(wq)) != NULL) {
+		stat_cache_file_remove(sc, wqe->data);
+	}
+
+	li_waitqueue_update(wq);
+}
+
+#ifdef USE_INOTIFY
+/* an inotify event says path has changed: forget it in the shared table and the fd cache too */
+static void stat_cache_forget_path(liStatCache *sc, liStatCacheEntry *sce) {
+	if (STAT_CACHE_ENTRY_SINGLE != sce->type) return;
+
+	if (NULL != sc->shared) {
+		li_stat_cache_shared_remove(sc->shared, sce->data.path);
+	}
+	stat_cache_file_drop(sc, sce->data.path);
+}
+
+/* removes an entry from the cache before its TTL is over */
+static void stat_cache_invalidate(liStatCache *sc, liStatCacheEntry *sce) {
+	li_waitqueue_remove(NULL != sce->watch ? &sc->watch_queue : &sc->delete_queue, &sce->queue_elem);
+	sc->invalidations++;
+	stat_cache_forget_path(sc, sce);
+	stat_cache_remove_from_cache(sc, sce);
+}
+
+/* invalidates all entries of the watch matching name (all entries if name == NULL);
+ * the watch is freed if no entries are left */
+static void stat_cache_watch_invalidate(liStatCache *sc, liStatCacheWatch *watch, const gchar *name) {
+	GList *link, *next;
+
+	for (link = watch->entries.head; NULL != link; link = next) {
+		liStatCacheEntry *sce = link->data;
+		gboolean last = (1 == watch->entries.length);
+		next = link->next;
+
+		if (NULL == name || NULL == sce->watch_name || 0 == strcmp(name, sce->watch_name)) {
+			stat_cache_invalidate(sc, sce);
+			if (last) break; /* watch was freed */
+		}
+	}
+}
+
+static void stat_cache_inotify_cb(liEventBase *watcher, int events) {
+	liStatCache *sc = LI_CONTAINER_OF(li_event_io_from(watcher), liStatCache, inotify_watcher);
+	union {
+		struct inotify_event ev;
+		char buf[4096];
+	} u;
+	ssize_t r, offset;
+	UNUSED(events);
+
+	for (;;) {
+		r = read(sc->inotify_fd, u.buf, sizeof(u.buf));
+		if (r < 0) {
+			switch (errno) {
+			case EINTR:
+				continue;
+			case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+			case EWOULDBLOCK:
+#endif
+				return;
+			default:
+				ERROR(LI_CONTAINER_OF(li_event_get_loop_(watcher), liWorker, loop)->srv, "reading inotify events failed: %s", g_strerror(errno));
+				return;
+			}
+		}
+		if (0 == r) return;
+
+		for (offset = 0; offset < r; ) {
+			struct inotify_event *ev = (struct inotify_event*) (u.buf + offset);
+			offset += sizeof(struct inotify_event) + ev->len;
+
+			if (ev->mask & IN_Q_OVERFLOW) {
+				/* lost events: drop all watched entries */
+				liWaitQueueElem *wqe;
+				while (NULL != (wqe = li_waitqueue_pop_force(&sc->watch_queue))) {
+					liStatCacheEntry *sce = wqe->data;
+					sc->invalidations++;
+					stat_cache_forget_path(sc, sce);
+					stat_cache_remove_from_cache(sc, sce);
+				}
+				li_waitqueue_update(&sc->watch_queue);
+				continue;
+			}
+
+			{
+				liStatCacheWatch *watch = g_hash_table_lookup(sc->watches, GINT_TO_POINTER(ev->wd));
+				if (NULL == watch) continue;
+
+				/* events without name are for the directory itself (or IN_IGNORED) */
+				stat_cache_watch_invalidate(sc, watch, ev->len > 0 ? ev->name : NULL);
+			}
+		}
+	}
+}
+
+/* watch the (parent) directory of a new entry with inotify and move it to the watch_queue;
+ * must happen before the tasklet stat()s it, otherwise a change in between wouldn't be noticed */
+static void stat_cache_watch(liStatCache *sc, liStatCacheEntry *sce) {
+	liStatCacheWatch *watch;
+	GString *path = sce->data.path;
+	gchar *dir, *name = NULL;
+	gsize len = path->len;
+	int wd;
+
+	/* ignore trailing slashes */
+	while (len > 1 && G_DIR_SEPARATOR == path->str[len-1]) len--;
+
+	if (STAT_CACHE_ENTRY_SINGLE == sce->type) {
+		gsize sep = len;
+		while (sep > 0 && G_DIR_SEPARATOR != path->str[sep-1]) sep--;
+		if (0 == sep || sep == len) return; /* relative path or "/" */
+
+		name = g_strndup(path->str + sep, len - sep);
+		dir = g_strndup(path->str, sep > 1 ? sep - 1 : 1);
+	} else {
+		dir = g_strndup(path->str, len);
+	}
+
+	wd = inotify_add_watch(sc->inotify_fd, dir,
+		IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+	g_free(dir);
+
+	if (-1 == wd) {
+		/* keep the short TTL */
+		g_free(name);
+		return;
+	}
+
+	if (NULL == (watch = g_hash_table_lookup(sc->watches, GINT_TO_POINTER(wd)))) {
+		watch = g_slice_new0(liStatCacheWatch);
+		watch->wd = wd;
+		g_hash_table_insert(sc->watches, GINT_TO_POINTER(wd), watch);
+	}
+
+	sce->watch = watch;
+	sce->watch_name = name;
+	sce->watch_link.data = sce;
+	g_queue_push_tail_link(&watch->entries, &sce->watch_link);
+
+	li_waitqueue_remove(&sc->delete_queue, &sce->queue_elem);
+	li_waitqueue_push(&sc->watch_queue, &sce->queue_elem);
+}
+#endif
+
 static void stat_cache_finished(gpointer data) {
 	liStatCacheEntry *sce = data;
 	guint i;
@@ -85,6 +396,11 @@ static void stat_cache_finished(gpointer data) {
 		if (NULL != sce->sc) sce->sc->errors++;
 	}
 
+	if (NULL != sce->sc && sce->cached && NULL != sce->sc->shared && STAT_CACHE_ENTRY_SINGLE == sce->type) {
+		liWorker *wrk = LI_CONTAINER_OF(li_event_get_loop(&sce->sc->delete_queue.timer), liWorker, loop);
+		li_stat_cache_shared_insert(sce->sc->shared, sce->data.path, li_cur_ts(wrk), &sce->data.st, sce->data.err, sce->data.failed);
+	}
+
 	/* queue pending vrequests */
 	for (i = 0; i < sce->vrequests->len; i++) {
 		vr = g_ptr_array_index(sce->vrequests, i);
@@ -260,6 +576,9 @@ liHandlerResult li_stat_cache_get_dirlist(liVRequest *vr, GString *path, liStatC
 		/* uses initial reference of sce */
 		li_waitqueue_push(&sc->delete_queue, &sce->queue_elem);
 		g_hash_table_insert(sc->dirlists, sce->data.path, sce);
+#ifdef USE_INOTIFY
+		if (-1 != sc->inotify_fd) stat_cache_watch(sc, sce);
+#endif
 
 		sce->refcount++;
 		li_tasklet_push(vr->wrk->tasklets, stat_cache_run, stat_cache_finished, sce);
@@ -278,6 +597,16 @@ static liHandlerResult stat_cache_get(liVRequest *vr, GString *path, struct stat
 	if (!vr || !(sc = vr->wrk->stat_cache) || !CORE_OPTION(LI_CORE_OPTION_ASYNC_STAT).boolean)
 		async = FALSE;
 
+	if (async && NULL == fd && NULL != sc->shared) {
+		gboolean failed;
+
+		if (li_stat_cache_shared_lookup(sc->shared, path, li_cur_ts(vr->wrk), st, err, &failed)) {
+			sc->shared_hits++;
+			return failed ? LI_HANDLER_ERROR : LI_HANDLER_GO_ON;
+		}
+		sc->shared_misses++;
+	}
+
 	if (async) {
 		sce = g_hash_table_lookup(sc->entries, path);
 
@@ -305,6 +634,9 @@ static liHandlerResult stat_cache_get(liVRequest *vr, GString *path, struct stat
 			/* uses initial reference of sce */
 			li_waitqueue_push(&sc->delete_queue, &sce->queue_elem);
 			g_hash_table_insert(sc->entries, sce->data.path, sce);
+#ifdef USE_INOTIFY
+			if (-1 != sc->inotify_fd) stat_cache_watch(sc, sce);
+#endif
 
 			sce->refcount++;
 			li_tasklet_push(vr->wrk->tasklets, stat_cache_run, stat_cache_finished, sce);
@@ -333,8 +665,14 @@ static liHandlerResult stat_cache_get(liVRequest *vr, GString *path, struct stat
 		/* stat */
 		if (-1 == stat(path->str, st)) {
 			*err = errno;
+			if (async && NULL != sc->shared) {
+				li_stat_cache_shared_insert(sc->shared, path, li_cur_ts(vr->wrk), st, *err, TRUE);
+			}
 			return LI_HANDLER_ERROR;
 		}
+		if (async && NULL != sc->shared) {
+			li_stat_cache_shared_insert(sc->shared, path, li_cur_ts(vr->wrk), st, 0, FALSE);
+		}
 	}
 
 	return LI_HANDLER_GO_ON;
@@ -348,3 +686,297 @@ liHandlerResult li_stat_cache_get(liVRequest *vr, GString *path, struct stat *st
 liHandlerResult li_stat_cache_get_sync(liVRequest *vr, GString *path, struct stat *st, int *err, int *fd) {
 	return stat_cache_get(vr, path, st, err, fd, FALSE);
 }
+
+static gboolean stat_cache_same_file(const struct stat *a, const struct stat *b) {
+	return a->st_ino == b->st_ino && a->st_dev == b->st_dev && a->st_size == b->st_size
+		&& a->st_mtime == b->st_mtime && a->st_ctime == b->st_ctime;
+}
+
+liHandlerResult li_stat_cache_get_chunkfile(liVRequest *vr, GString *path, struct stat *st, int *err, liChunkFile **cf) {
+	liStatCache *sc;
+	stat_cache_file *scf;
+	liHandlerResult res;
+	int fd = -1;
+
+	*cf = NULL;
+
+	if (!vr || !(sc = vr->wrk->stat_cache) || NULL == sc->files || !CORE_OPTION(LI_CORE_OPTION_ASYNC_STAT).boolean) {
+		/* no fd cache: open() + fstat() */
+		res = stat_cache_get(vr, path, st, err, &fd, TRUE);
+		if (LI_HANDLER_GO_ON == res) *cf = li_chunkfile_new(NULL, fd, FALSE);
+		return res;
+	}
+
+	/* (cached) stat() to validate the cached fd */
+	res = stat_cache_get(vr, path, st, err, NULL, TRUE);
+	if (LI_HANDLER_GO_ON != res) {
+		if (LI_HANDLER_ERROR == res) stat_cache_file_drop(sc, path);
+		return res;
+	}
+
+	if (!S_ISREG(st->st_mode)) return LI_HANDLER_GO_ON;
+
+	scf = g_hash_table_lookup(sc->files, path);
+	if (NULL != scf) {
+		if (stat_cache_same_file(&scf->st, st)) {
+			sc->file_hits++;
+			li_chunkfile_acquire(scf->cf);
+			*cf = scf->cf;
+			return LI_HANDLER_GO_ON;
+		}
+
+		/* file changed */
+		li_waitqueue_remove(&sc->file_queue, &scf->queue_elem);
+		stat_cache_file_remove(sc, scf);
+	}
+
+	sc->file_misses++;
+
+	while (-1 == (fd = open(path->str, O_RDONLY))) {
+		if (errno == EINTR)
+			continue;
+
+		*err = errno;
+		return LI_HANDLER_ERROR;
+	}
+	li_fd_close_on_exec(fd);
+	if (-1 == fstat(fd, st)) {
+		*err = errno;
+		close(fd);
+		return LI_HANDLER_ERROR;
+	}
+
+	*cf = li_chunkfile_new(NULL, fd, FALSE);
+
+	if (!S_ISREG(st->st_mode)) return LI_HANDLER_GO_ON; /* changed since stat(), don't cache */
+
+	if (g_hash_table_size(sc->files) >= sc->files_max) {
+		/* full: close the oldest fd */
+		liWaitQueueElem *wqe = li_waitqueue_pop_force(&sc->file_queue);
+		if (NULL != wqe) stat_cache_file_remove(sc, wqe->data);
+	}
+
+	scf = g_slice_new0(stat_cache_file);
+	scf->path = g_string_new_len(GSTR_LEN(path));
+	scf->cf = *cf;
+	li_chunkfile_acquire(scf->cf);
+	scf->st = *st;
+	scf->queue_elem.data = scf;
+	g_hash_table_insert(sc->files, scf->path, scf);
+	li_waitqueue_push(&sc->file_queue, &scf->queue_elem);
+
+	return LI_HANDLER_GO_ON;
+}
+
+/* header cache */
+
+/* element must already be removed from the headers_queue */
+static void stat_cache_headers_remove(liStatCache *sc, stat_cache_headers *sch) {
+	g_hash_table_remove(sc->headers, sch->path);
+	g_string_free(sch->path, TRUE);
+	if (NULL != sch->etag) g_string_free(sch->etag, TRUE);
+	if (NULL != sch->last_modified) g_string_free(sch->last_modified, TRUE);
+	g_slice_free(stat_cache_headers, sch);
+}
+
+static void stat_cache_headers_delete_cb(liWaitQueue *wq, gpointer data) {
+	liStatCache *sc = data;
+	liWaitQueueElem *wqe;
+
+	while ((wqe = li_waitqueue_pop(wq)) != NULL) {
+		stat_cache_headers_remove(sc, wqe->data);
+	}
+
+	li_waitqueue_update(wq);
+}
+
+gboolean li_stat_cache_get_headers(liVRequest *vr, GString *path, struct stat *st, GString **etag, GString **last_modified) {
+	liStatCache *sc;
+	stat_cache_headers *sch;
+	guint flags;
+
+	if (!vr || !(sc = vr->wrk->stat_cache))
+		return FALSE;
+
+	flags = CORE_OPTION(LI_CORE_OPTION_ETAG_FLAGS).number;
+
+	sch = g_hash_table_lookup(sc->headers, path);
+	if (NULL != sch) {
+		if (stat_cache_same_file(&sch->st, st) && sch->etag_flags == flags) {
+			/* most recently used: move to the end */
+			li_waitqueue_push(&sc->headers_queue, &sch->queue_elem);
+			*etag = sch->etag;
+			*last_modified = sch->last_modified;
+			return TRUE;
+		}
+
+		li_waitqueue_remove(&sc->headers_queue, &sch->queue_elem);
+		stat_cache_headers_remove(sc, sch);
+	}
+
+	if (g_hash_table_size(sc->headers) >= sc->headers_max) {
+		/* full: drop the least recently used entry */
+		liWaitQueueElem *wqe = li_waitqueue_pop_force(&sc->headers_queue);
+		if (NULL != wqe) stat_cache_headers_remove(sc, wqe->data);
+	}
+
+	sch = g_slice_new0(stat_cache_headers);
+	sch->path = g_string_new_len(GSTR_LEN(path));
+	sch->st = *st;
+	sch->etag_flags = flags;
+	if (0 != flags) {
+		sch->etag = g_string_sized_new(15);
+		li_etag_format(sch->etag, flags, st);
+	}
+	sch->last_modified = g_string_sized_new(31);
+	if (!li_etag_format_last_modified(sch->last_modified, st->st_mtime)) {
+		g_string_free(sch->last_modified, TRUE);
+		sch->last_modified = NULL;
+	}
+	sch->queue_elem.data = sch;
+	g_hash_table_insert(sc->headers, sch->path, sch);
+	li_waitqueue_push(&sc->headers_queue, &sch->queue_elem);
+
+	*etag = sch->etag;
+	*last_modified = sch->last_modified;
+	return TRUE;
+}
+
+/* shared stat cache */
+
+#define STAT_CACHE_SHARED_WAYS 4
+
+liStatCacheShared* li_stat_cache_shared_new(guint entries, gdouble ttl) {
+	liStatCacheShared *shared;
+	guint size = STAT_CACHE_SHARED_WAYS;
+
+	while (size < entries && size < (1u << 30)) size <<= 1;
+
+	shared = g_slice_new0(liStatCacheShared);
+	shared->slots = g_new0(liStatCacheSharedSlot, size);
+	shared->mask = size - 1;
+	shared->ttl = ttl;
+	shared->write_lock = g_mutex_new();
+
+	return shared;
+}
+
+void li_stat_cache_shared_free(liStatCacheShared *shared) {
+	if (!shared)
+		return;
+
+	g_mutex_free(shared->write_lock);
+	g_free(shared->slots);
+	g_slice_free(liStatCacheShared, shared);
+}
+
+static liStatCacheSharedSlot* stat_cache_shared_set(liStatCacheShared *shared, guint hash) {
+	return &shared->slots[hash & shared->mask & ~(guint) (STAT_CACHE_SHARED_WAYS - 1)];
+}
+
+gboolean li_stat_cache_shared_lookup(liStatCacheShared *shared, GString *path, li_tstamp now, struct stat *st, int *err, gboolean *failed) {
+	guint hash, i;
+	liStatCacheSharedSlot *set;
+
+	if (path->len == 0 || path->len > LI_STAT_CACHE_SHARED_PATH_MAX) return FALSE;
+
+	hash = g_string_hash(path);
+	set = stat_cache_shared_set(shared, hash);
+
+	for (i = 0; i < STAT_CACHE_SHARED_WAYS; i++) {
+		liStatCacheSharedSlot *slot = &set[i];
+		gint seq;
+		li_tstamp ts;
+		gboolean match;
+
+		/* unlocked pre-check; verified below */
+		if (slot->hash != hash || slot->path_len != path->len) continue;
+
+		/* seqlock read: the copies below are plain loads and may race with a writer; the fence before the
+		 * second seq read keeps them from being reordered after it (weakly ordered CPUs), so a torn copy
+		 * is always detected */
+		seq = g_atomic_int_get(&slot->seq);
+		if (seq & 1) return FALSE; /* writer active */
+
+		match = (slot->hash == hash && slot->path_len == path->len && 0 == memcmp(slot->path, path->str, path->len));
+		ts = slot->ts;
+		*st = slot->st;
+		*err = slot->err;
+		*failed = slot->failed;
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (seq != g_atomic_int_get(&slot->seq)) return FALSE; /* slot changed while reading */
+
+		if (!match) continue;
+
+		return (now - ts < shared->ttl);
+	}
+
+	return FALSE;
+}
+
+static void stat_cache_shared_write(liStatCacheSharedSlot *slot, GString *path, guint hash, li_tstamp now, const struct stat *st, int err, gboolean failed) {
+	g_atomic_int_inc(&slot->seq); /* odd: readers ignore the slot */
+	/* the odd seq has to be visible before any of the field stores */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->hash = hash;
+	slot->path_len = (NULL != path) ? path->len : 0;
+	if (NULL != path) memcpy(slot->path, path->str, path->len);
+	slot->ts = now;
+	if (NULL != st) slot->st = *st;
+	slot->err = err;
+	slot->failed = failed;
+
+	/* ... and the fields before the even seq */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	g_atomic_int_inc(&slot->seq);
+}
+
+void li_stat_cache_shared_insert(liStatCacheShared *shared, GString *path, li_tstamp now, const struct stat *st, int err, gboolean failed) {
+	guint hash, i;
+	liStatCacheSharedSlot *set, *victim = NULL;
+
+	if (path->len == 0 || path->len > LI_STAT_CACHE_SHARED_PATH_MAX) return;
+
+	hash = g_string_hash(path);
+	set = stat_cache_shared_set(shared, hash);
+
+	g_mutex_lock(shared->write_lock);
+
+	for (i = 0; i < STAT_CACHE_SHARED_WAYS; i++) {
+		liStatCacheSharedSlot *slot = &set[i];
+
+		if (slot->hash == hash && slot->path_len == path->len && 0 == memcmp(slot->path, path->str, path->len)) {
+			victim = slot;
+			break;
+		}
+		if (NULL == victim || slot->ts < victim->ts) victim = slot;
+	}
+
+	stat_cache_shared_write(victim, path, hash, now, st, err, failed);
+
+	g_mutex_unlock(shared->write_lock);
+}
+
+void li_stat_cache_shared_remove(liStatCacheShared *shared, GString *path) {
+	guint hash, i;
+	liStatCacheSharedSlot *set;
+
+	if (path->len == 0 || path->len > LI_STAT_CACHE_SHARED_PATH_MAX) return;
+
+	hash = g_string_hash(path);
+	set = stat_cache_shared_set(shared, hash);
+
+	g_mutex_lock(shared->write_lock);
+
+	for (i = 0; i < STAT_CACHE_SHARED_WAYS; i++) {
+		liStatCacheSharedSlot *slot = &set[i];
+
+		if (slot->hash == hash && slot->path_len == path->len && 0 == memcmp(slot->path, path->str, path->len)) {
+			stat_cache_shared_write(slot, NULL, 0, 0, NULL, 0, FALSE);
+		}
+	}
+
+	g_mutex_unlock(shared->write_lock);
+}
@@ -180,6 +180,21 @@ void li_stream_again_later(liStream *stream) {
 	}
 }
 
+liHandlerResult li_stream_chunkiter_read(liStream *stream, liTaskletPool *pool, liChunkIter iter, off_t start, off_t length, char **data_start, off_t *data_len, GError **err) {
+	liJobRef *wakeup;
+	liHandlerResult res;
+
+	if (NULL == pool || NULL == stream->loop) {
+		return li_chunkiter_read(iter, start, length, data_start, data_len, err);
+	}
+
+	wakeup = li_job_ref(&stream->loop->jobqueue, &stream->new_data_job);
+	res = li_chunkiter_read_async(iter, start, length, data_start, data_len, pool, wakeup, err);
+	li_job_ref_release(wakeup);
+
+	return res;
+}
+
 void li_stream_detach(liStream *stream) {
 	stream->loop = NULL;
 	li_job_stop(&stream->new_data_job);
@@ -318,6 +333,10 @@ static void iostream_destroy(liIOStream *iostream) {
 	iostream->cb(iostream, LI_IOSTREAM_DESTROY);
 
 	fd = li_event_io_fd(&iostream->io_watcher);
+	li_network_zerocopy_close(fd, iostream->zerocopy);
+	iostream->zerocopy = NULL;
+	li_chunkpipe_release(iostream->splice_in);
+	iostream->splice_in = NULL;
 	if (-1 != fd) close(fd); /* usually this should be shutdown+closed somewhere else */
 	li_event_clear(&iostream->io_watcher);
 
@@ -357,7 +376,7 @@ static void iostream_in_cb(liStream *stream, liStreamEvent event) {
 		if (!iostream->throttled_in && !iostream->can_read && !iostream->in_closed) {
 			li_event_io_add_events(&iostream->io_watcher, LI_EV_READ);
 		}
-		if (!iostream->throttled_out && !iostream->can_write && !iostream->out_closed) {
+		if (!iostream->throttled_out && !iostream->write_pending && !iostream->can_write && !iostream->out_closed) {
 			li_event_io_add_events(&iostream->io_watcher, LI_EV_WRITE);
 		}
 		break;
@@ -402,7 +421,7 @@ static void iostream_out_cb(liStream *stream, liStreamEvent event) {
 
 	switch (event) {
 	case LI_STREAM_NEW_DATA:
-		if (!iostream->throttled_out && iostream->can_write) {
+		if (!iostream->throttled_out && !iostream->write_pending && iostream->can_write) {
 			liEventLoop *loop = li_event_get_loop(&iostream->io_watcher);
 			li_tstamp now = li_event_now(loop);
 
@@ -419,7 +438,7 @@ static void iostream_out_cb(liStream *stream, liStreamEvent event) {
 
 			if (-1 == li_event_io_fd(&iostream->io_watcher)) return;
 
-			if (iostream->can_write && !iostream->throttled_out) {
+			if (iostream->can_write && !iostream->throttled_out && !iostream->write_pending) {
 				if (stream->out->length > 0 || stream->out->is_closed) {
 					li_stream_again_later(stream);
 				}
@@ -428,7 +447,7 @@ static void iostream_out_cb(liStream *stream, liStreamEvent event) {
 		if (!iostream->throttled_in && !iostream->can_read && !iostream->in_closed) {
 			li_event_io_add_events(&iostream->io_watcher, LI_EV_READ);
 		}
-		if (!iostream->throttled_out && !iostream->can_write && !iostream->out_closed) {
+		if (!iostream->throttled_out && !iostream->write_pending && !iostream->can_write && !iostream->out_closed) {
 			li_event_io_add_events(&iostream->io_watcher, LI_EV_WRITE);
 		}
 		break;
@@ -517,6 +536,14 @@ int li_iostream_reset(liIOStream *iostream) {
 
 	fd = li_event_io_fd(&iostream->io_watcher);
 
+	/* io_uring writes are cancelled in li_stream_simple_socket_close, the only backend using them */
+
+	/* the caller closes fd */
+	li_network_zerocopy_close(fd, iostream->zerocopy);
+	iostream->zerocopy = NULL;
+	li_chunkpipe_release(iostream->splice_in);
+	iostream->splice_in = NULL;
+
 	li_event_clear(&iostream->io_watcher);
 
 	if (NULL != iostream->write_timeout_queue) {
@@ -531,6 +558,10 @@ int li_iostream_reset(liIOStream *iostream) {
 }
 
 void li_iostream_detach(liIOStream *iostream) {
+	/* completions of async writes are handled in the worker that started them */
+	LI_FORCE_ASSERT(!iostream->write_pending);
+	iostream->use_uring = FALSE;
+
 	li_event_detach(&iostream->io_watcher);
 
 	if (NULL != iostream->stream_in_limit) {
@@ -552,6 +583,12 @@ void li_iostream_attach(liIOStream *iostream, liWorker *wrk) {
 	li_event_attach(&wrk->loop, &iostream->io_watcher);
 }
 
+gboolean li_iostream_splice_in(liIOStream *iostream) {
+	if (NULL == iostream->splice_in) iostream->splice_in = li_chunkpipe_new();
+
+	return NULL != iostream->splice_in;
+}
+
 void li_iostream_throttle_clear(liIOStream *iostream) {
 	liWorker *wrk = li_worker_from_iostream(iostream);
 
@@ -1,4 +1,5 @@
 #include <lighttpd/stream_http_response.h>
+#include <lighttpd/plugin_core.h>
 
 typedef struct liStreamHttpResponse liStreamHttpResponse;
 
@@ -10,6 +11,8 @@ struct liStreamHttpResponse {
 	gboolean keepalive, response_headers_finished, transfer_encoding_chunked, wait_for_close;
 	goffset content_length;
 	liFilterChunkedDecodeState chunked_decode_state;
+
+	liIOStream *splice_backend; /* only valid while backend->stream_in is our source */
 };
 
 static void check_response_header(liStreamHttpResponse* shr) {
@@ -231,6 +234,26 @@ static void stream_http_response_data(liStreamHttpResponse* shr) {
 }
 
 
+/* connected to the vrequest output: the response headers are parsed and the filters are known */
+static void stream_http_response_splice(liStreamHttpResponse* shr) {
+	liVRequest *vr = shr->vr;
+	liIOStream *backend = shr->splice_backend;
+
+	shr->splice_backend = NULL;
+	if (NULL == vr || NULL == backend || shr->stream.source != &backend->stream_in) return;
+
+	if (!CORE_OPTION(LI_CORE_OPTION_BACKEND_SPLICE).boolean) return;
+
+	/* the data has to be read for chunked decoding and by filters (connected between us and resp);
+	 * SSL connections can't send pipe chunks */
+	if (!shr->response_headers_finished || shr->transfer_encoding_chunked) return;
+	if (shr->stream.dest != vr->coninfo->resp || !vr->coninfo->splice_out) return;
+
+	if (!li_iostream_splice_in(backend) && CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) {
+		VR_DEBUG(vr, "%s", "couldn't create pipe for splice(), copying response body");
+	}
+}
+
 static void stream_http_response_cb(liStream *stream, liStreamEvent event) {
 	liStreamHttpResponse* shr = LI_CONTAINER_OF(stream, liStreamHttpResponse, stream);
 
@@ -238,6 +261,9 @@ static void stream_http_response_cb(liStream *stream, liStreamEvent event) {
 	case LI_STREAM_NEW_DATA:
 		stream_http_response_data(shr);
 		break;
+	case LI_STREAM_CONNECTED_DEST:
+		stream_http_response_splice(shr);
+		break;
 	case LI_STREAM_DISCONNECTED_DEST:
 		shr->vr = NULL;
 		li_stream_disconnect(stream);
@@ -269,3 +295,10 @@ LI_API liStream* li_stream_http_response_handle(liStream *http_in, liVRequest *v
 	li_stream_connect(http_in, &shr->stream);
 	return &shr->stream;
 }
+
+void li_stream_http_response_allow_splice(liStream *stream, liIOStream *backend) {
+	liStreamHttpResponse* shr = LI_CONTAINER_OF(stream, liStreamHttpResponse, stream);
+
+	LI_FORCE_ASSERT(stream_http_response_cb == stream->cb);
+	shr->splice_backend = backend;
+}
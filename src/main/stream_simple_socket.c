@@ -5,6 +5,20 @@
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 
+/* zero copy completions make the socket readable (POLLERR) until they are read; the socket is closed
+ * once the kernel doesn't use our buffers anymore (or reset on timeout) */
+static gboolean stream_simple_socket_zerocopy_close(int fd, gboolean closing, gpointer data) {
+	liNetworkZeroCopy *zc = data;
+
+	if (closing) {
+		li_network_zerocopy_close(fd, zc);
+		return FALSE;
+	}
+
+	li_network_zerocopy_reap(fd, zc);
+	return li_network_zerocopy_pending(zc);
+}
+
 void li_stream_simple_socket_close(liIOStream *stream, gboolean aborted) {
 	int fd = li_event_io_fd(&stream->io_watcher);
 
@@ -12,25 +26,32 @@ void li_stream_simple_socket_close(liIOStream *stream, gboolean aborted) {
 
 	if (-1 == fd) return;
 
+	if (stream->write_pending) {
+		/* submits the write before the fd gets closed below */
+		li_uring_cancel(li_worker_from_iostream(stream)->uring, stream->write_op);
+	}
+
 	stream->out_closed = stream->in_closed = TRUE;
 	stream->can_read = stream->can_write = FALSE;
 	if (NULL != stream->stream_in.out) {
 		stream->stream_in.out->is_closed = TRUE;
 	}
 
-	if (aborted || stream->in_closed) {
+	if (aborted || !li_network_zerocopy_pending(stream->zerocopy)) {
+		/* resets the connection if aborted while the kernel still sends from our buffers */
 		fd = li_iostream_reset(stream);
 		if (-1 != fd) {
 			shutdown(fd, SHUT_RDWR);
 			close(fd);
 		}
 	} else {
+		/* zero copy sends not completed yet: close normally (FIN) after the kernel is done with the buffers */
 		liWorker *wrk = li_worker_from_iostream(stream);
-		li_event_clear(&stream->io_watcher); /* sets io_fd to -1 */
+		liNetworkZeroCopy *zc = stream->zerocopy;
 
-		shutdown(fd, SHUT_WR);
-		li_stream_disconnect(&stream->stream_out);
-		li_worker_add_closing_socket(wrk, fd);
+		stream->zerocopy = NULL;
+		fd = li_iostream_reset(stream);
+		li_worker_add_closing_socket_cb(wrk, fd, stream_simple_socket_zerocopy_close, zc);
 	}
 	LI_FORCE_ASSERT(-1 == li_event_io_fd(&stream->io_watcher));
 }
@@ -58,28 +79,27 @@ static void stream_simple_socket_read(liIOStream *stream, gpointer *data) {
 		}
 	}
 
-	if (NULL == *data && NULL != wrk->network_read_buf) {
-		/* reuse worker buf if needed */
-		*data = wrk->network_read_buf;
-		wrk->network_read_buf = NULL;
-	}
+	/* zero copy completions make the socket readable */
+	if (li_network_zerocopy_pending(stream->zerocopy)) li_network_zerocopy_reap(fd, stream->zerocopy);
 
 	{
 		goffset current_in_bytes = raw_in->bytes_in;
+		guint64 current_syscalls = stream->read_state.syscalls;
 		liBuffer *raw_in_buffer = *data;
-		res = li_network_read(fd, raw_in, max_read, &raw_in_buffer, &err);
+		if (NULL != stream->splice_in) {
+			res = li_network_read_splice(fd, raw_in, max_read, stream->splice_in, &raw_in_buffer, wrk->buffer_pool, &stream->read_state, &err);
+		} else {
+			res = li_network_read(fd, raw_in, max_read, &raw_in_buffer, wrk->buffer_pool, &stream->read_state, &err);
+		}
 		*data = raw_in_buffer;
+		wrk->stats.read_syscalls += stream->read_state.syscalls - current_syscalls;
 		if (NULL != stream->throttle_in) {
 			li_throttle_update(stream->throttle_in, raw_in->bytes_in - current_in_bytes);
 		}
 	}
 
-	if (NULL == wrk->network_read_buf && NULL != *data
-		&& 1 == g_atomic_int_get(&((liBuffer*)*data)->refcount)) {
-		/* move buffer back to worker if we didn't use it */
-		wrk->network_read_buf = *data;
-		*data = NULL;
-	}
+	/* put buffer back into the worker pool if we didn't use it */
+	li_stream_simple_socket_release_buffer(data);
 
 	switch (res) {
 	case LI_NETWORK_STATUS_SUCCESS:
@@ -101,6 +121,94 @@ static void stream_simple_socket_read(liIOStream *stream, gpointer *data) {
 	}
 }
 
+/* async writes through the worker io_uring (see uring.h) for memory chunks; file chunks still use
+ * the synchronous path (sendfile).
+ * at most one write per stream is in flight; the data stays in raw_out until the write completed (only
+ * stream_simple_socket_write removes data from raw_out, and the operation keeps a reference to
+ * stream_out). the result is applied in the next stream_simple_socket_write call, so the callers see
+ * the written bytes as if the write was synchronous.
+ */
+typedef struct simple_socket_write_op simple_socket_write_op;
+struct simple_socket_write_op {
+	liUringOp op;
+	liIOStream *stream;
+	goffset length; /* bytes submitted */
+	int res;
+	gboolean done;
+};
+
+static void stream_simple_socket_write_done(liUringOp *op, int res) {
+	simple_socket_write_op *wop = LI_CONTAINER_OF(op, simple_socket_write_op, op);
+	liIOStream *stream = wop->stream;
+
+	wop->res = res;
+	wop->done = TRUE;
+	stream->write_pending = FALSE;
+
+	li_stream_again_later(&stream->stream_out);
+	li_stream_release(&stream->stream_out); /* reference from stream_simple_socket_write_submit */
+}
+
+static gboolean stream_simple_socket_write_submit(liIOStream *stream, liUring *uring, int fd, liChunkQueue *raw_out, goffset write_max) {
+	simple_socket_write_op *wop;
+	liChunkIter ci = li_chunkqueue_iter(raw_out);
+	liChunk *c = li_chunkiter_chunk(ci);
+	goffset we_have = 0;
+
+	if (STRING_CHUNK != c->type && MEM_CHUNK != c->type && BUFFER_CHUNK != c->type) return FALSE;
+
+	if (NULL == stream->write_op) {
+		wop = g_slice_new0(simple_socket_write_op);
+		wop->op.callback = stream_simple_socket_write_done;
+		wop->stream = stream;
+		stream->write_op = &wop->op;
+	} else {
+		wop = LI_CONTAINER_OF(stream->write_op, simple_socket_write_op, op);
+	}
+
+	wop->op.iovcnt = li_chunkiter_gather_iovec(&ci, wop->op.iov, LI_URING_IOV_MAX, write_max, &we_have);
+
+	if (!li_uring_writev(uring, &wop->op, fd)) return FALSE;
+
+	wop->length = we_have;
+	wop->done = FALSE;
+	stream->write_pending = TRUE;
+	li_stream_acquire(&stream->stream_out);
+
+	return TRUE;
+}
+
+static liNetworkStatus stream_simple_socket_write_result(liIOStream *stream, liChunkQueue *raw_out, GError **err) {
+	simple_socket_write_op *wop = LI_CONTAINER_OF(stream->write_op, simple_socket_write_op, op);
+	int fd = li_event_io_fd(&stream->io_watcher);
+
+	wop->done = FALSE;
+
+	if (wop->res >= 0) {
+		li_chunkqueue_skip(raw_out, wop->res);
+		/* short write: socket buffer is full */
+		return (wop->res < wop->length) ? LI_NETWORK_STATUS_WAIT_FOR_EVENT : LI_NETWORK_STATUS_SUCCESS;
+	}
+
+	switch (-wop->res) {
+	case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+	case EWOULDBLOCK:
+#endif
+		return LI_NETWORK_STATUS_WAIT_FOR_EVENT;
+	case EINTR:
+		return LI_NETWORK_STATUS_SUCCESS; /* try again */
+	case ECONNRESET:
+	case EPIPE:
+	case ETIMEDOUT:
+	case ECANCELED:
+		return LI_NETWORK_STATUS_CONNECTION_CLOSE;
+	default:
+		g_set_error(err, LI_NETWORK_ERROR, 0, "io_uring writev to fd=%d failed: %s", fd, g_strerror(-wop->res));
+		return LI_NETWORK_STATUS_FATAL_ERROR;
+	}
+}
+
 static void stream_simple_socket_write_throttle_notify(liThrottleState *state, gpointer data) {
 	liIOStream *stream = data;
 	UNUSED(state);
@@ -108,6 +216,24 @@ static void stream_simple_socket_write_throttle_notify(liThrottleState *state, g
 	stream->can_write = TRUE;
 	li_stream_again(&stream->stream_out);
 }
+static void stream_simple_socket_write_status(liIOStream *stream, liNetworkStatus res, GError *err) {
+	switch (res) {
+	case LI_NETWORK_STATUS_SUCCESS:
+		break;
+	case LI_NETWORK_STATUS_FATAL_ERROR:
+		ERROR(li_worker_from_iostream(stream)->srv, "network write fatal error: %s", NULL != err ? err->message : "(unknown)");
+		if (NULL != err) g_error_free(err);
+		li_stream_simple_socket_close(stream, TRUE);
+		break;
+	case LI_NETWORK_STATUS_CONNECTION_CLOSE:
+		li_stream_simple_socket_close(stream, TRUE);
+		break;
+	case LI_NETWORK_STATUS_WAIT_FOR_EVENT:
+		stream->can_write = FALSE;
+		break;
+	}
+}
+
 static void stream_simple_socket_write(liIOStream *stream) {
 	liNetworkStatus res;
 	liChunkQueue *raw_out = stream->stream_out.out;
@@ -117,41 +243,53 @@ static void stream_simple_socket_write(liIOStream *stream) {
 
 	if (NULL != from) li_chunkqueue_steal_all(raw_out, from);
 
+	if (NULL != stream->write_op && LI_CONTAINER_OF(stream->write_op, simple_socket_write_op, op)->done) {
+		GError *err = NULL;
+
+		res = stream_simple_socket_write_result(stream, raw_out, &err);
+		if (LI_NETWORK_STATUS_SUCCESS != res) {
+			stream_simple_socket_write_status(stream, res, err);
+			return;
+		}
+	}
+
 	if (raw_out->length > 0) {
 		static const goffset WRITE_MAX = 256*1024; /* 256kB */
 		goffset write_max, current_out_bytes = raw_out->bytes_out;
 		GError *err = NULL;
 
 		write_max = MAX(WRITE_MAX, raw_out->length);
+		if (stream->notsent_lowat > 0 && raw_out->length > stream->notsent_lowat) {
+			/* keep at most about twice the low-water mark unsent in the kernel; the socket is
+			 * writable again (LI_EV_WRITE) when less than notsent_lowat bytes are left */
+			goffset unsent = li_network_unsent_bytes(fd);
+			if (unsent >= 0) {
+				if (unsent >= stream->notsent_lowat) {
+					stream_simple_socket_write_status(stream, LI_NETWORK_STATUS_WAIT_FOR_EVENT, NULL);
+					return;
+				}
+				write_max = MIN(write_max, 2 * stream->notsent_lowat - unsent);
+			}
+		}
 		if (NULL != stream->throttle_out) {
 			write_max = li_throttle_query(wrk, stream->throttle_out, write_max, stream_simple_socket_write_throttle_notify, stream);
 			if (0 == write_max) {
 				stream->throttled_out = TRUE;
 				return;
 			}
+		} else if (stream->use_uring && NULL != wrk->uring
+		           && !(NULL != stream->zerocopy && raw_out->length >= wrk->srv->zerocopy_min_size)) {
+			/* large responses rather go with zero copy if enabled */
+			if (stream_simple_socket_write_submit(stream, wrk->uring, fd, raw_out, write_max)) return;
 		}
 
-		res = li_network_write(fd, raw_out, write_max, &err);
+		res = li_network_write(fd, raw_out, write_max, stream->zerocopy, &err);
 
 		if (NULL != stream->throttle_out) {
 			li_throttle_update(stream->throttle_out, raw_out->bytes_out - current_out_bytes);
 		}
 
-		switch (res) {
-		case LI_NETWORK_STATUS_SUCCESS:
-			break;
-		case LI_NETWORK_STATUS_FATAL_ERROR:
-			ERROR(wrk->srv, "network write fatal error: %s", NULL != err ? err->message : "(unknown)");
-			g_error_free(err);
-			li_stream_simple_socket_close(stream, TRUE);
-			break;
-		case LI_NETWORK_STATUS_CONNECTION_CLOSE:
-			li_stream_simple_socket_close(stream, TRUE);
-			break;
-		case LI_NETWORK_STATUS_WAIT_FOR_EVENT:
-			stream->can_write = FALSE;
-			break;
-		}
+		stream_simple_socket_write_status(stream, res, err);
 	}
 
 	if (0 == raw_out->length && raw_out->is_closed) {
@@ -181,11 +319,26 @@ void li_stream_simple_socket_io_cb_with_context(liIOStream *stream, liIOStreamEv
 			li_buffer_release(*data);
 			*data = NULL;
 		}
+		if (NULL != stream->write_op) {
+			/* the operation keeps stream_out alive while in flight */
+			LI_FORCE_ASSERT(!stream->write_op->in_flight);
+			g_slice_free(simple_socket_write_op, LI_CONTAINER_OF(stream->write_op, simple_socket_write_op, op));
+			stream->write_op = NULL;
+		}
 	default:
 		break;
 	}
 }
 
+void li_stream_simple_socket_release_buffer(gpointer *data) {
+	liBuffer *buf = *data;
+
+	if (NULL != buf && 1 == g_atomic_int_get(&buf->refcount)) {
+		li_buffer_release(buf);
+		*data = NULL;
+	}
+}
+
 void li_stream_simple_socket_flush(liIOStream *stream) {
 	int val = 1;
 	int fd = li_event_io_fd(&stream->io_watcher);
@@ -0,0 +1,203 @@
+#include <lighttpd/base.h>
+
+#ifdef HAVE_LIBURING
+
+#include <liburing.h>
+
+struct liUring {
+	struct io_uring ring;
+	liEventIO ring_watcher;
+	liEventPrepare submit_watcher;
+
+	guint queued;        /* prepared sqes, not submitted yet */
+	guint in_flight;     /* operations without completion */
+	guint max_in_flight; /* don't overflow the completion queue; half of it is kept for cancel completions */
+};
+
+static void uring_reap(liUring *uring) {
+	struct io_uring_cqe *cqe;
+
+	while (0 == io_uring_peek_cqe(&uring->ring, &cqe)) {
+		liUringOp *op = io_uring_cqe_get_data(cqe);
+		int res = cqe->res;
+
+		io_uring_cqe_seen(&uring->ring, cqe);
+
+		if (NULL == op) continue; /* cancel request */
+
+		uring->in_flight--;
+		op->in_flight = FALSE;
+		op->callback(op, res);
+	}
+}
+
+static void uring_submit(liUring *uring) {
+	int r;
+
+	while (uring->queued > 0) {
+		r = io_uring_submit(&uring->ring);
+		if (r >= 0) {
+			uring->queued = (guint) r < uring->queued ? uring->queued - r : 0;
+			continue;
+		}
+		if (-EINTR == r) continue;
+		/* -EBUSY/-EAGAIN: completions have to be reaped first; ring fd is readable then and we try again
+		 * in the next loop iteration */
+		break;
+	}
+}
+
+/* submit all queued sqes now; the kernel takes its own reference to the files of the submitted
+ * operations, so the fds can be closed (and the numbers reused) afterwards.
+ * the completion queue can't overflow (see max_in_flight), so -EBUSY doesn't happen and -EAGAIN
+ * (no memory for the requests right now) is only temporary. returns FALSE if the ring is broken.
+ */
+static gboolean uring_flush(liUring *uring) {
+	int r;
+
+	while (uring->queued > 0) {
+		r = io_uring_submit(&uring->ring);
+		if (r >= 0) {
+			uring->queued = (guint) r < uring->queued ? uring->queued - r : 0;
+			continue;
+		}
+		if (-EINTR == r || -EAGAIN == r) continue;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void uring_ring_cb(liEventBase *watcher, int events) {
+	liUring *uring = LI_CONTAINER_OF(li_event_io_from(watcher), liUring, ring_watcher);
+	UNUSED(events);
+
+	uring_reap(uring);
+}
+
+static void uring_submit_cb(liEventBase *watcher, int events) {
+	liUring *uring = LI_CONTAINER_OF(li_event_prepare_from(watcher), liUring, submit_watcher);
+	UNUSED(events);
+
+	uring_submit(uring);
+}
+
+liUring* li_uring_new(liEventLoop *loop, guint entries, GError **err) {
+	liUring *uring = g_slice_new0(liUring);
+	int r;
+
+	if (0 != (r = io_uring_queue_init(entries, &uring->ring, 0))) {
+		g_set_error(err, LI_NETWORK_ERROR, 0, "io_uring_queue_init(%u) failed: %s", entries, g_strerror(-r));
+		g_slice_free(liUring, uring);
+		return NULL;
+	}
+
+	/* every write gets at most one cancel, which has its own completion */
+	uring->max_in_flight = *uring->ring.cq.kring_entries / 2;
+
+	li_event_io_init(loop, "io_uring", &uring->ring_watcher, uring_ring_cb, uring->ring.ring_fd, LI_EV_READ);
+	li_event_set_keep_loop_alive(&uring->ring_watcher, FALSE);
+	li_event_start(&uring->ring_watcher);
+
+	li_event_prepare_init(loop, "io_uring submit", &uring->submit_watcher, uring_submit_cb);
+	li_event_prepare_run_last(&uring->submit_watcher);
+
+	return uring;
+}
+
+void li_uring_free(liUring *uring) {
+	if (NULL == uring) return;
+
+	li_event_clear(&uring->submit_watcher);
+	li_event_clear(&uring->ring_watcher);
+
+	/* called after all connections were closed, which cancelled their operations, so this shouldn't
+	 * take long; don't hang forever though (the kernel cancels whatever is left in io_uring_queue_exit) */
+	while (uring->in_flight > 0) {
+		struct io_uring_cqe *cqe;
+		struct __kernel_timespec ts = { 1, 0 };
+
+		if (uring->queued > 0) uring_submit(uring);
+		if (0 != io_uring_wait_cqe_timeout(&uring->ring, &cqe, &ts)) break;
+		uring_reap(uring);
+	}
+
+	io_uring_queue_exit(&uring->ring);
+	g_slice_free(liUring, uring);
+}
+
+static struct io_uring_sqe* uring_get_sqe(liUring *uring) {
+	struct io_uring_sqe *sqe;
+
+	if (NULL != (sqe = io_uring_get_sqe(&uring->ring))) return sqe;
+
+	/* submission queue full: submit early */
+	uring_submit(uring);
+	return io_uring_get_sqe(&uring->ring);
+}
+
+gboolean li_uring_writev(liUring *uring, liUringOp *op, int fd) {
+	struct io_uring_sqe *sqe;
+
+	LI_FORCE_ASSERT(!op->in_flight);
+	LI_FORCE_ASSERT(op->iovcnt > 0 && op->iovcnt <= LI_URING_IOV_MAX);
+
+	if (uring->in_flight >= uring->max_in_flight) return FALSE;
+	if (NULL == (sqe = uring_get_sqe(uring))) return FALSE;
+
+	io_uring_prep_writev(sqe, fd, op->iov, op->iovcnt, 0);
+	io_uring_sqe_set_data(sqe, op);
+
+	op->in_flight = TRUE;
+	op->cancelled = FALSE;
+	uring->queued++;
+	uring->in_flight++;
+
+	return TRUE;
+}
+
+void li_uring_cancel(liUring *uring, liUringOp *op) {
+	struct io_uring_sqe *sqe;
+
+	if (NULL == uring || !op->in_flight || op->cancelled) return;
+
+	/* submission queue full: make room */
+	while (NULL == (sqe = io_uring_get_sqe(&uring->ring))) {
+		if (!uring_flush(uring)) break;
+	}
+
+	if (NULL != sqe) {
+		io_uring_prep_cancel(sqe, op, 0);
+		io_uring_sqe_set_data(sqe, NULL);
+		uring->queued++;
+		op->cancelled = TRUE;
+	}
+
+	/* the caller closes the fd next: the operation must not be submitted after that */
+	uring_flush(uring);
+}
+
+#else
+
+liUring* li_uring_new(liEventLoop *loop, guint entries, GError **err) {
+	UNUSED(loop); UNUSED(entries);
+
+	g_set_error(err, LI_NETWORK_ERROR, 0, "%s", "io_uring support not compiled in (needs liburing)");
+	return NULL;
+}
+
+void li_uring_free(liUring *uring) {
+	UNUSED(uring);
+}
+
+gboolean li_uring_writev(liUring *uring, liUringOp *op, int fd) {
+	UNUSED(uring); UNUSED(op); UNUSED(fd);
+
+	return FALSE;
+}
+
+void li_uring_cancel(liUring *uring, liUringOp *op) {
+	UNUSED(uring); UNUSED(op);
+}
+
+#endif
@@ -43,6 +43,7 @@ liVRequest* li_vrequest_new(liWorker *wrk, liConInfo *coninfo) {
 	li_vrequest_filters_init(vr);
 
 	li_action_stack_init(&vr->action_stack);
+	li_condition_cache_init(&vr->condition_cache);
 
 	li_job_init(&vr->job, vrequest_job_cb);
 
@@ -68,6 +69,7 @@ void li_vrequest_free(liVRequest* vr) {
 		vr->state = LI_VRS_CLEAN;
 		vr->backend = NULL;
 	}
+	li_condition_cache_clear(&vr->condition_cache);
 	g_ptr_array_free(vr->plugin_ctx, TRUE);
 	vr->plugin_ctx = NULL;
 
@@ -112,6 +114,7 @@ void li_vrequest_reset(liVRequest *vr, gboolean keepalive) {
 	li_stream_safe_reset_and_release(&vr->wait_for_request_body_stream);
 
 	li_action_stack_reset(vr, &vr->action_stack);
+	li_condition_cache_reset(&vr->condition_cache);
 	if (vr->state != LI_VRS_CLEAN) {
 		li_plugins_handle_vrclose(vr);
 		vr->state = LI_VRS_CLEAN;
@@ -9,17 +9,22 @@ static liConnection* worker_con_get(liWorker *wrk);
 /* closing sockets - wait for proper shutdown */
 
 void li_worker_add_closing_socket(liWorker *wrk, int fd) {
+	li_worker_add_closing_socket_cb(wrk, fd, NULL, NULL);
+}
+
+void li_worker_add_closing_socket_cb(liWorker *wrk, int fd, liEventClosingSocketCB cb, gpointer data) {
 	liServerState state = g_atomic_int_get(&wrk->srv->state);
 
 	if (-1 == fd) return;
 
 	if (LI_SERVER_RUNNING != state && LI_SERVER_WARMUP != state) {
 		shutdown(fd, SHUT_WR);
+		if (NULL != cb) cb(fd, TRUE, data);
 		close(fd);
 		return;
 	}
 
-	li_event_add_closing_socket(&wrk->loop, fd);
+	li_event_add_closing_socket_cb(&wrk->loop, fd, cb, data);
 }
 
 /* Keep alive */
@@ -193,24 +198,64 @@ static void li_worker_exit_cb(liEventBase *watcher, int events) {
 	li_worker_exit(wrk, wrk);
 }
 
+/* listen watcher */
+static void worker_listen_update(liWorker *wrk) {
+	gboolean active = g_atomic_int_get(&wrk->listen_active);
+	guint i;
+
+	if (!active) wrk->listen_limit_hit = FALSE;
+
+	for (i = 0; i < wrk->listen_sockets->len; i++) {
+		liServerSocket *sock = g_ptr_array_index(wrk->listen_sockets, i);
+		if (active && !wrk->listen_limit_hit) {
+			li_event_start(&sock->watcher);
+		} else {
+			li_event_stop(&sock->watcher);
+		}
+	}
+}
+
+static void li_worker_listen_cb(liEventBase *watcher, int events) {
+	liWorker *wrk = LI_CONTAINER_OF(li_event_async_from(watcher), liWorker, worker_listen_watcher);
+	UNUSED(events);
+
+	worker_listen_update(wrk);
+}
+
 typedef struct li_worker_new_con_data li_worker_new_con_data;
 struct li_worker_new_con_data {
-	liSocketAddress remote_addr;
-	int s;
-	liServerSocket *srv_sock;
+	li_tstamp ts_accepted;
+	guint count;
+	liWorkerNewCon cons[];
 };
 
-/* new con watcher */
-void li_worker_new_con(liWorker *ctx, liWorker *wrk, liSocketAddress remote_addr, int s, liServerSocket *srv_sock) {
-	if (ctx == wrk) {
+static void worker_start_cons(liWorker *wrk, const liWorkerNewCon *cons, guint count, li_tstamp ts_accepted) {
+	li_tstamp latency = li_event_monotonic_time() - ts_accepted, limit;
+	guint i;
+
+	for (i = 0, limit = 0.0001; i < LI_ACCEPT_LATENCY_BUCKETS - 1 && latency >= limit; i++, limit *= 10) ;
+	wrk->stats.accept_latency[i] += count;
+	wrk->stats.accepted += count;
+	wrk->stats.accept_handoffs++;
+
+	for (i = 0; i < count; i++) {
 		liConnection *con = worker_con_get(wrk);
 
-		li_connection_start(con, remote_addr, s, srv_sock);
+		li_connection_start(con, &cons[i].remote_addr, cons[i].remote_addr_len, cons[i].s, cons[i].srv_sock);
+	}
+}
+
+/* new con watcher */
+void li_worker_new_cons(liWorker *ctx, liWorker *wrk, const liWorkerNewCon *cons, guint count, li_tstamp ts_accepted) {
+	if (0 == count) return;
+
+	if (ctx == wrk) {
+		worker_start_cons(wrk, cons, count, ts_accepted);
 	} else {
-		li_worker_new_con_data *d = g_slice_new(li_worker_new_con_data);
-		d->remote_addr = remote_addr;
-		d->s = s;
-		d->srv_sock = srv_sock;
+		li_worker_new_con_data *d = g_malloc(sizeof(li_worker_new_con_data) + count * sizeof(liWorkerNewCon));
+		d->ts_accepted = ts_accepted;
+		d->count = count;
+		memcpy(d->cons, cons, count * sizeof(liWorkerNewCon));
 		g_async_queue_push(wrk->new_con_queue, d);
 		li_event_async_send(&wrk->new_con_watcher);
 	}
@@ -222,8 +267,8 @@ static void li_worker_new_con_cb(liEventBase *watcher, int events) {
 	UNUSED(events);
 
 	while (NULL != (d = g_async_queue_try_pop(wrk->new_con_queue))) {
-		li_worker_new_con(wrk, wrk, d->remote_addr, d->s, d->srv_sock);
-		g_slice_free(li_worker_new_con_data, d);
+		worker_start_cons(wrk, d->cons, d->count, d->ts_accepted);
+		g_free(d);
 	}
 }
 
@@ -264,10 +309,22 @@ static void worker_stats_watcher_cb(liEventBase *watcher, int events) {
 		wrk->stats.peak.active_cons = MAX(wrk->stats.peak.active_cons, wrk->connections_active);
 
 		wrk->stats.last_avg = now;
+
+		/* free read buffers which weren't needed in the last 5 seconds */
+		li_buffer_pool_trim(wrk->buffer_pool);
 	}
 
 	wrk->stats.active_cons_cum += wrk->connections_active;
 
+	if (wrk->listen_limit_hit) {
+		guint srv_cur_load = g_atomic_int_get(&wrk->srv->connection_load);
+		guint srv_max_load = g_atomic_int_get(&wrk->srv->max_connections);
+		if (srv_cur_load <= (srv_max_load - srv_max_load/8)) { /* cur_load <= 7/8 * max_load */
+			wrk->listen_limit_hit = FALSE;
+			worker_listen_update(wrk);
+		}
+	}
+
 	wrk->stats.last_requests = wrk->stats.requests;
 	wrk->stats.last_update = now;
 
@@ -312,6 +369,9 @@ liWorker* li_worker_new(liServer *srv, struct ev_loop *loop) {
 	li_event_async_init(&wrk->loop, "worker stopping", &wrk->worker_stopping_watcher, li_worker_stopping_cb);
 	li_event_async_init(&wrk->loop, "worker exit", &wrk->worker_exit_watcher, li_worker_exit_cb);
 	li_event_async_init(&wrk->loop, "worker suspend", &wrk->worker_suspend_watcher, li_worker_suspend_cb);
+	li_event_async_init(&wrk->loop, "worker listen", &wrk->worker_listen_watcher, li_worker_listen_cb);
+
+	wrk->listen_sockets = g_ptr_array_new();
 
 	li_event_async_init(&wrk->loop, "worker new connection", &wrk->new_con_watcher, li_worker_new_con_cb);
 	wrk->new_con_queue = g_async_queue_new();
@@ -331,8 +391,6 @@ liWorker* li_worker_new(liServer *srv, struct ev_loop *loop) {
 
 	wrk->tasklets = li_tasklet_pool_new(&wrk->loop, srv->tasklet_pool_threads);
 
-	wrk->network_read_buf = NULL;
-
 	return wrk;
 }
 
@@ -360,6 +418,10 @@ struct ev_loop* li_worker_free(liWorker *wrk) {
 		g_array_free(wrk->connections, TRUE);
 	}
 
+	/* closing the connections cancelled their writes; the completions release the streams */
+	li_uring_free(wrk->uring);
+	wrk->uring = NULL;
+
 	{ /* free timestamps */
 		guint i;
 		for (i = 0; i < wrk->timestamps_gmt->len; i++) {
@@ -377,6 +439,10 @@ struct ev_loop* li_worker_free(liWorker *wrk) {
 	li_event_clear(&wrk->worker_stopping_watcher);
 	li_event_clear(&wrk->worker_suspend_watcher);
 	li_event_clear(&wrk->worker_exit_watcher);
+	li_event_clear(&wrk->worker_listen_watcher);
+
+	g_ptr_array_free(wrk->listen_sockets, TRUE);
+	wrk->listen_sockets = NULL;
 
 	li_event_clear(&wrk->new_con_watcher);
 	g_async_queue_unref(wrk->new_con_queue);
@@ -394,12 +460,13 @@ struct ev_loop* li_worker_free(liWorker *wrk) {
 	g_string_free(wrk->tmp_str, TRUE);
 
 	li_stat_cache_free(wrk->stat_cache);
+	li_content_cache_free(wrk->content_cache);
 
 	li_tasklet_pool_free(wrk->tasklets);
 
 	li_lua_clear(&wrk->LL);
 
-	li_buffer_release(wrk->network_read_buf);
+	li_buffer_pool_free(wrk->buffer_pool);
 
 	evloop = li_event_loop_clear(&wrk->loop);
 
@@ -428,7 +495,23 @@ void li_worker_run(liWorker *wrk) {
 
 	/* setup stat cache if necessary */
 	if (wrk->srv->stat_cache_ttl && !wrk->stat_cache)
-		wrk->stat_cache = li_stat_cache_new(wrk, wrk->srv->stat_cache_ttl);
+		wrk->stat_cache = li_stat_cache_new(wrk, wrk->srv->stat_cache_ttl, wrk->srv->stat_cache_inotify_ttl);
+
+	/* the buffer pool belongs to the thread running the worker */
+	if (!wrk->buffer_pool)
+		wrk->buffer_pool = li_buffer_pool_new(wrk->srv->buffer_pool_max_free);
+
+	/* every worker gets an equal share of the content cache memory */
+	if (wrk->srv->content_cache_memory && !wrk->content_cache)
+		wrk->content_cache = li_content_cache_new(wrk->srv->content_cache_memory / wrk->srv->worker_count, wrk->srv->content_cache_max_file_size);
+
+	if (wrk->srv->io_uring_entries && !wrk->uring) {
+		GError *err = NULL;
+		if (NULL == (wrk->uring = li_uring_new(&wrk->loop, wrk->srv->io_uring_entries, &err))) {
+			ERROR(wrk->srv, "io.uring: %s, using the normal network backend", err->message);
+			g_error_free(err);
+		}
+	}
 
 	li_event_loop_run(&wrk->loop);
 }
@@ -442,11 +525,14 @@ void li_worker_stop(liWorker *context, liWorker *wrk) {
 		li_event_stop(&wrk->worker_stop_watcher);
 		li_event_stop(&wrk->worker_stopping_watcher);
 		li_event_stop(&wrk->worker_suspend_watcher);
+		li_event_stop(&wrk->worker_listen_watcher);
+
+		g_atomic_int_set(&wrk->listen_active, FALSE);
+		worker_listen_update(wrk);
 
 		li_event_stop(&wrk->new_con_watcher);
 
-		if (wrk->stat_cache)
-			li_waitqueue_stop(&wrk->stat_cache->delete_queue);
+		li_stat_cache_stop(wrk->stat_cache);
 		/* handle remaining new connections. there shouldn't be any, we'll kill them soon anyway */
 		li_worker_new_con_cb(&wrk->new_con_watcher.base, 0);
 
@@ -527,6 +613,29 @@ void li_worker_exit(liWorker *context, liWorker *wrk) {
 	}
 }
 
+void li_worker_listen(liWorker *context, liWorker *wrk, gboolean active) {
+	if (0 == wrk->listen_sockets->len) return;
+
+	g_atomic_int_set(&wrk->listen_active, active);
+
+	if (context == wrk) {
+		worker_listen_update(wrk);
+	} else {
+		li_event_async_send(&wrk->worker_listen_watcher);
+	}
+}
+
+void li_worker_listen_limit_hit(liWorker *wrk) {
+	guint i;
+
+	for (i = 0; i < wrk->listen_sockets->len; i++) {
+		liServerSocket *sock = g_ptr_array_index(wrk->listen_sockets, i);
+		li_event_stop(&sock->watcher);
+	}
+
+	wrk->listen_limit_hit = TRUE; /* stats timer checks once a second to re-enable */
+}
+
 
 static liConnection* worker_con_get(liWorker *wrk) {
 	liConnection *con;
@@ -71,7 +71,7 @@ static ssize_t stream_pushv(gnutls_transport_ptr_t trans, const li_iovec_t * iov
 
 		while (len > 0) {
 			size_t bufsize, do_write;
-			if (NULL == buf) buf = li_buffer_new(blocksize);
+			if (NULL == buf) buf = li_buffer_pool_get(f->wrk->buffer_pool, blocksize);
 
 			bufsize = buf->alloc_size - buf->used;
 			do_write = (bufsize > len) ? len : bufsize;
@@ -327,7 +327,7 @@ static void do_gnutls_read(liGnuTLSFilter *f) {
 				f->raw_in_buffer = buf = NULL;
 			}
 			if (buf == NULL) {
-				f->raw_in_buffer = buf = li_buffer_new(blocksize);
+				f->raw_in_buffer = buf = li_buffer_pool_get(f->wrk->buffer_pool, blocksize);
 			}
 		}
 		LI_FORCE_ASSERT(f->raw_in_buffer == buf);
@@ -419,9 +419,12 @@ static void do_gnutls_write(liGnuTLSFilter *f) {
 		if (0 == cq->length) break;
 
 		ci = li_chunkqueue_iter(cq);
-		switch (li_chunkiter_read(ci, 0, blocksize, &block_data, &block_len, &err)) {
+		switch (li_stream_chunkiter_read(&f->plain_drain, f->wrk->tasklets, ci, 0, blocksize, &block_data, &block_len, &err)) {
 		case LI_HANDLER_GO_ON:
 			break;
+		case LI_HANDLER_WAIT_FOR_EVENT:
+			/* file data is loaded in the background, plain_drain gets woken up */
+			goto out;
 		case LI_HANDLER_ERROR:
 			if (NULL != err) {
 				_ERROR(f->srv, f->wrk, f->log_context, "Couldn't read data from chunkqueue: %s", err->message);
@@ -203,7 +203,7 @@ static liHandlerResult deflate_filter_zlib(liVRequest *vr, liFilter *f) {
 
 		ci = li_chunkqueue_iter(f->in);
 
-		if (LI_HANDLER_GO_ON != (res = li_chunkiter_read(ci, 0, blocksize, &data, &len, &err))) {
+		if (LI_HANDLER_GO_ON != (res = li_filter_chunkiter_read(f, ci, 0, blocksize, &data, &len, &err))) {
 			if (NULL != err) {
 				if (NULL != vr) VR_ERROR(vr, "Couldn't read data from chunkqueue: %s", err->message);
 				g_error_free(err);
@@ -402,7 +402,7 @@ static liHandlerResult deflate_filter_bzip2(liVRequest *vr, liFilter *f) {
 
 		ci = li_chunkqueue_iter(f->in);
 
-		if (LI_HANDLER_GO_ON != (res = li_chunkiter_read(ci, 0, blocksize, &data, &len, &err))) {
+		if (LI_HANDLER_GO_ON != (res = li_filter_chunkiter_read(f, ci, 0, blocksize, &data, &len, &err))) {
 			if (NULL != err) {
 				if (NULL != vr) VR_ERROR(vr, "Couldn't read data from chunkqueue: %s", err->message);
 				g_error_free(err);
@@ -489,8 +489,7 @@ static gboolean cached_handle_etag(liVRequest *vr, gboolean debug, liHttpHeader
 	g_string_append_len(s, CONST_STR_LEN("-"));
 	g_string_append_len(s, enc_name, strlen(enc_name));
 	li_etag_mutate(s, s);
-	g_string_truncate(hh_etag->data, hh_etag->keylen + 2);
-	g_string_append_len(hh_etag->data, GSTR_LEN(s));
+	li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("ETag"), GSTR_LEN(s));
 
 	if (200 == vr->response.http_status && li_http_response_handle_cachable(vr)) {
 		if (debug || CORE_OPTION(LI_CORE_OPTION_DEBUG_REQUEST_HANDLING).boolean) {
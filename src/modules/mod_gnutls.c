@@ -503,10 +503,17 @@ static liThrottleState* gnutls_tcp_throttle_in(liConnection *con) {
 	return conctx->sock_stream->throttle_in;
 }
 
+static void gnutls_tcp_idle(liConnection *con) {
+	mod_connection_ctx *conctx = con->con_sock.data;
+	if (NULL == conctx) return;
+	li_stream_simple_socket_release_buffer(&conctx->simple_socket_data);
+}
+
 static const liConnectionSocketCallbacks gnutls_tcp_cbs = {
 	gnutls_tcp_finished,
 	gnutls_tcp_throttle_out,
-	gnutls_tcp_throttle_in
+	gnutls_tcp_throttle_in,
+	gnutls_tcp_idle
 };
 
 #ifdef USE_SNI
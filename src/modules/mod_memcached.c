@@ -246,15 +246,15 @@ option_failed:
 }
 
 static void mc_ctx_build_key(GString *dest, memcached_ctx *ctx, liVRequest *vr) {
-	GMatchInfo *match_info = NULL;
+	liRegexMatch *match = NULL;
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(dest, 0);
-	li_pattern_eval(vr, dest, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match_info);
+	li_pattern_eval(vr, dest, ctx->pattern, NULL, NULL, li_pattern_regex_cb, match);
 
 	li_memcached_mutate_key(dest);
 }
@@ -468,7 +468,7 @@ static liHandlerResult memcache_store_filter(liVRequest *vr, liFilter *f) {
 
 		ci = li_chunkqueue_iter(f->in);
 
-		if (LI_HANDLER_GO_ON != (res = li_chunkiter_read(ci, 0, 16*1024, &data, &len, &err))) {
+		if (LI_HANDLER_GO_ON != (res = li_filter_chunkiter_read(f, ci, 0, 16*1024, &data, &len, &err))) {
 			if (NULL != err) {
 				VR_ERROR(vr, "Couldn't read data from chunkqueue: %s", err->message);
 				g_error_free(err);
@@ -48,6 +48,7 @@ struct openssl_context {
 	gint refcount;
 
 	SSL_CTX *ssl_ctx;
+	gboolean ktls;
 };
 
 enum {
@@ -192,10 +193,17 @@ static liThrottleState* openssl_tcp_throttle_in(liConnection *con) {
 	return conctx->sock_stream->throttle_in;
 }
 
+static void openssl_tcp_idle(liConnection *con) {
+	openssl_connection_ctx *conctx = con->con_sock.data;
+	if (NULL == conctx) return;
+	li_stream_simple_socket_release_buffer(&conctx->simple_socket_data);
+}
+
 static const liConnectionSocketCallbacks openssl_tcp_cbs = {
 	openssl_tcp_finished,
 	openssl_tcp_throttle_out,
-	openssl_tcp_throttle_in
+	openssl_tcp_throttle_in,
+	openssl_tcp_idle
 };
 
 static gboolean openssl_con_new(liConnection *con, int fd) {
@@ -218,6 +226,8 @@ static gboolean openssl_con_new(liConnection *con, int fd) {
 		return FALSE;
 	}
 
+	if (ctx->ktls) li_openssl_filter_enable_ktls(conctx->ssl_filter, conctx->sock_stream);
+
 	conctx->con = con;
 	con->con_sock.data = conctx;
 	con->con_sock.callbacks = &openssl_tcp_cbs;
@@ -516,7 +526,8 @@ static gboolean openssl_setup(liServer *srv, liPlugin* p, liValue *val, gpointer
 		have_verify_parameter = FALSE,
 		have_verify_depth_parameter = FALSE,
 		have_verify_any_parameter = FALSE,
-		have_verify_require_parameter = FALSE;
+		have_verify_require_parameter = FALSE,
+		have_ktls_parameter = FALSE;
 	const char
 		*ciphers = NULL, *pemfile = NULL, *ca_file = NULL, *client_ca_file = NULL, *dh_params_file = NULL, *ecdh_curve = NULL;
 	long
@@ -531,7 +542,8 @@ static gboolean openssl_setup(liServer *srv, liPlugin* p, liValue *val, gpointer
 	guint
 		verify_mode = 0, verify_depth = 1;
 	gboolean
-		verify_any = FALSE;
+		verify_any = FALSE,
+		ktls = FALSE;
 
 	UNUSED(p); UNUSED(userdata);
 
@@ -693,6 +705,17 @@ static gboolean openssl_setup(liServer *srv, liPlugin* p, liValue *val, gpointer
 				return FALSE;
 			}
 			client_ca_file = entryValue->data.string->str;
+		} else if (g_str_equal(entryKeyStr->str, "ktls")) {
+			if (LI_VALUE_BOOLEAN != li_value_type(entryValue)) {
+				ERROR(srv, "%s", "openssl ktls expects a boolean as parameter");
+				return FALSE;
+			}
+			if (have_ktls_parameter) {
+				ERROR(srv, "openssl unexpected duplicate parameter %s", entryKeyStr->str);
+				return FALSE;
+			}
+			have_ktls_parameter = TRUE;
+			ktls = entryValue->data.boolean;
 		} else {
 			ERROR(srv, "invalid parameter for openssl: %s", entryKeyStr->str);
 			return FALSE;
@@ -710,7 +733,15 @@ static gboolean openssl_setup(liServer *srv, liPlugin* p, liValue *val, gpointer
 		return FALSE;
 	}
 
+#ifndef USE_OPENSSL_KTLS
+	if (ktls) {
+		WARNING(srv, "%s", "openssl: kTLS not supported (needs OpenSSL 3 built with kTLS support), ignoring ktls parameter");
+		ktls = FALSE;
+	}
+#endif
+
 	ctx = mod_openssl_context_new();
+	ctx->ktls = ktls;
 
 	if (NULL == (ctx->ssl_ctx = SSL_CTX_new(SSLv23_server_method()))) {
 		ERROR(srv, "SSL_CTX_new: %s", ERR_error_string(ERR_get_error(), NULL));
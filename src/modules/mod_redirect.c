@@ -21,7 +21,7 @@ LI_API gboolean mod_redirect_free(liModules *mods, liModule *mod);
 typedef struct redirect_rule redirect_rule;
 struct redirect_rule {
 	liPattern *pattern;
-	GRegex *regex;
+	liRegex *regex;
 	enum {
 		REDIRECT_ABSOLUTE_URI,
 		REDIRECT_ABSOLUTE_PATH,
@@ -59,7 +59,7 @@ static gboolean redirect_rule_parse(liServer *srv, GString *regex, GString *str,
 
 	if (NULL != regex) {
 		GError *err = NULL;
-		rule->regex = g_regex_new(regex->str, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &err);
+		rule->regex = li_regex_new(regex->str, &err);
 
 		if (NULL == rule->regex || NULL != err) {
 			ERROR(srv, "redirect: error compiling regex \"%s\": %s", regex->str, NULL != err ? err->message : "unknown error");
@@ -76,7 +76,7 @@ error:
 		rule->pattern = NULL;
 	}
 	if (NULL != rule->regex) {
-		g_regex_unref(rule->regex);
+		li_regex_release(rule->regex);
 		rule->regex = NULL;
 	}
 
@@ -85,22 +85,26 @@ error:
 
 static gboolean redirect_internal(liVRequest *vr, GString *dest, redirect_rule *rule) {
 	gchar *path;
-	GMatchInfo *match_info = NULL;
-	GMatchInfo *prev_match_info = NULL;
+	liRegexMatch *match = NULL;
+	liRegexMatch *prev_match = NULL;
 
 	path = vr->request.uri.path->str;
 
-	if (NULL != rule->regex && !g_regex_match(rule->regex, path, 0, &match_info)) {
-		if (match_info) {
-			g_match_info_free(match_info);
-		}
+	if (NULL != rule->regex) {
+		GError *err = NULL;
 
-		return FALSE;
+		if (!li_regex_match(rule->regex, path, &match, &err)) {
+			if (NULL != err) {
+				VR_ERROR(vr, "redirect: %s", err->message);
+				g_error_free(err);
+			}
+			return FALSE;
+		}
 	}
 
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		prev_match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		prev_match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(dest, 0);
@@ -139,11 +143,9 @@ static gboolean redirect_internal(liVRequest *vr, GString *dest, redirect_rule *
 		break;
 	}
 
-	li_pattern_eval(vr, dest, rule->pattern, li_pattern_regex_cb, match_info, li_pattern_regex_cb, prev_match_info);
+	li_pattern_eval(vr, dest, rule->pattern, li_pattern_regex_cb, match, li_pattern_regex_cb, prev_match);
 
-	if (match_info) {
-		g_match_info_free(match_info);
-	}
+	li_regex_match_free(match);
 
 	return TRUE;
 }
@@ -193,7 +195,7 @@ static void redirect_free(liServer *srv, gpointer param) {
 		li_pattern_free(rule->pattern);
 
 		if (NULL != rule->regex)
-			g_regex_unref(rule->regex);
+			li_regex_release(rule->regex);
 	}
 
 	g_array_free(rd->rules, TRUE);
@@ -19,12 +19,13 @@ LI_API gboolean mod_rewrite_free(liModules *mods, liModule *mod);
 typedef struct rewrite_rule rewrite_rule;
 struct rewrite_rule {
 	liPattern *path, *querystring;
-	GRegex *regex;
+	liRegex *regex;
 };
 
 typedef struct rewrite_data rewrite_data;
 struct rewrite_data {
 	GArray *rules;
+	liRegexSet *set; /* finds the first matching rule if there are several */
 	liPlugin *p;
 };
 
@@ -60,7 +61,7 @@ static gboolean rewrite_rule_parse(liServer *srv, GString *regex, GString *str,
 
 	if (NULL != regex) {
 		GError *err = NULL;
-		rule->regex = g_regex_new(regex->str, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &err);
+		rule->regex = li_regex_new(regex->str, &err);
 
 		if (NULL == rule->regex || NULL != err) {
 			ERROR(srv, "rewrite: error compiling regex \"%s\": %s", regex->str, NULL != err ? err->message : "unknown error");
@@ -85,7 +86,7 @@ error:
 		rule->path = NULL;
 	}
 	if (NULL != rule->regex) {
-		g_regex_unref(rule->regex);
+		li_regex_release(rule->regex);
 		rule->regex = NULL;
 	}
 
@@ -96,61 +97,74 @@ error:
 	return FALSE;
 }
 
-static gboolean rewrite_internal(liVRequest *vr, GString *dest_path, GString *dest_query, rewrite_rule *rule, gchar *path) {
-	GMatchInfo *match_info = NULL;
-	GMatchInfo *prev_match_info = NULL;
+/* first rule matching path; the caller has to free *match */
+static rewrite_rule* rewrite_find(liVRequest *vr, rewrite_data *rd, gchar *path, liRegexMatch **match) {
+	rewrite_rule *rule = NULL;
+	GError *err = NULL;
+	guint i;
+
+	*match = NULL;
+
+	if (NULL != rd->set) {
+		gint ndx = li_regex_set_match(rd->set, path, match, &err);
+		if (ndx >= 0) rule = &g_array_index(rd->rules, rewrite_rule, ndx);
+	} else {
+		for (i = 0; i < rd->rules->len; i++) {
+			rewrite_rule *r = &g_array_index(rd->rules, rewrite_rule, i);
 
-	if (NULL != rule->regex && !g_regex_match(rule->regex, path, 0, &match_info)) {
-		if (NULL != match_info) {
-			g_match_info_free(match_info);
+			if (NULL == r->regex || li_regex_match(r->regex, path, match, (NULL == err) ? &err : NULL)) {
+				rule = r;
+				break;
+			}
 		}
+	}
 
-		return FALSE;
+	if (NULL != err) {
+		VR_ERROR(vr, "rewrite: %s", err->message);
+		g_error_free(err);
 	}
 
+	return rule;
+}
+
+static void rewrite_internal(liVRequest *vr, GString *dest_path, GString *dest_query, rewrite_rule *rule, liRegexMatch *match) {
+	liRegexMatch *prev_match = NULL;
+
 	if (vr->action_stack.regex_stack->len) {
 		GArray *rs = vr->action_stack.regex_stack;
-		prev_match_info = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match_info;
+		prev_match = g_array_index(rs, liActionRegexStackElement, rs->len - 1).match;
 	}
 
 	g_string_truncate(dest_path, 0);
 	if (NULL != dest_query) g_string_truncate(dest_query, 0);
 
-	li_pattern_eval(vr, dest_path, rule->path, li_pattern_regex_cb, match_info, li_pattern_regex_cb, prev_match_info);
+	li_pattern_eval(vr, dest_path, rule->path, li_pattern_regex_cb, match, li_pattern_regex_cb, prev_match);
 	if (NULL != rule->querystring) {
 		LI_FORCE_ASSERT(NULL != dest_query);
-		li_pattern_eval(vr, dest_query, rule->querystring, li_pattern_regex_cb, match_info, li_pattern_regex_cb, prev_match_info);
+		li_pattern_eval(vr, dest_query, rule->querystring, li_pattern_regex_cb, match, li_pattern_regex_cb, prev_match);
 	}
 
-	g_match_info_free(match_info);
-
-	return TRUE;
+	li_regex_match_free(match);
 }
 
 static liHandlerResult rewrite_raw(liVRequest *vr, gpointer param, gpointer *context) {
-	guint i;
 	rewrite_rule *rule;
 	rewrite_data *rd = param;
 	gboolean debug = _OPTION(vr, rd->p, 0).boolean;
 	gchar *path = vr->request.uri.raw_path->str;
+	GString *dest_path = vr->wrk->tmp_str;
+	liRegexMatch *match;
 	UNUSED(context);
 
-	for (i = 0; i < rd->rules->len; i++) {
-		GString *dest_path = vr->wrk->tmp_str;
-
-		rule = &g_array_index(rd->rules, rewrite_rule, i);
+	/* stop at first matching regex */
+	if (NULL != (rule = rewrite_find(vr, rd, path, &match))) {
+		rewrite_internal(vr, dest_path, NULL, rule, match);
 
-		if (rewrite_internal(vr, dest_path, NULL, rule, path)) {
-			/* regex matched */
-			if (debug) {
-				VR_DEBUG(vr, "rewrite_raw: path \"%s\" => \"%s\"", path, dest_path->str);
-			}
-
-			if (!li_parse_raw_path(&vr->request.uri, dest_path)) return LI_HANDLER_ERROR;
-
-			/* stop at first matching regex */
-			break;
+		if (debug) {
+			VR_DEBUG(vr, "rewrite_raw: path \"%s\" => \"%s\"", path, dest_path->str);
 		}
+
+		if (!li_parse_raw_path(&vr->request.uri, dest_path)) return LI_HANDLER_ERROR;
 	}
 
 	return LI_HANDLER_GO_ON;
@@ -159,58 +173,54 @@ static liHandlerResult rewrite_raw(liVRequest *vr, gpointer param, gpointer *con
 
 
 static liHandlerResult rewrite(liVRequest *vr, gpointer param, gpointer *context) {
-	guint i;
 	rewrite_rule *rule;
 	rewrite_data *rd = param;
 	gboolean debug = _OPTION(vr, rd->p, 0).boolean;
-	GString *dest_query = g_string_sized_new(31);
+	GString *dest_query;
 	gchar *path = vr->request.uri.path->str;
+	GString *dest_path = vr->wrk->tmp_str;
+	liRegexMatch *match;
 	UNUSED(context);
 
-	for (i = 0; i < rd->rules->len; i++) {
-		GString *dest_path = vr->wrk->tmp_str;
-
-		rule = &g_array_index(rd->rules, rewrite_rule, i);
-
-		if (rewrite_internal(vr, dest_path, dest_query, rule, path)) {
-			/* regex matched */
-			if (debug) {
-				if (NULL != rule->querystring) {
-					VR_DEBUG(vr, "rewrite: path \"%s\" => \"%s\", query \"%s\" => \"%s\"",
-						path, dest_path->str,
-						vr->request.uri.query->str, dest_query->str
-					);
-				} else {
-					VR_DEBUG(vr, "rewrite: path \"%s\" => \"%s\"",
-						path, dest_path->str
-					);
-				}
-			}
+	/* stop at first matching regex */
+	if (NULL != (rule = rewrite_find(vr, rd, path, &match))) {
+		dest_query = g_string_sized_new(31);
+		rewrite_internal(vr, dest_path, dest_query, rule, match);
 
-			/* change request query */
+		if (debug) {
 			if (NULL != rule->querystring) {
-				g_string_truncate(vr->request.uri.query, 0);
-				g_string_append_len(vr->request.uri.query, GSTR_LEN(dest_query));
+				VR_DEBUG(vr, "rewrite: path \"%s\" => \"%s\", query \"%s\" => \"%s\"",
+					path, dest_path->str,
+					vr->request.uri.query->str, dest_query->str
+				);
+			} else {
+				VR_DEBUG(vr, "rewrite: path \"%s\" => \"%s\"",
+					path, dest_path->str
+				);
 			}
+		}
 
-			/* change request path */
-			g_string_truncate(vr->request.uri.path, 0);
-			g_string_append_len(vr->request.uri.path, GSTR_LEN(dest_path));
-			li_path_simplify(vr->request.uri.path);
+		/* change request query */
+		if (NULL != rule->querystring) {
+			g_string_truncate(vr->request.uri.query, 0);
+			g_string_append_len(vr->request.uri.query, GSTR_LEN(dest_query));
+		}
 
-			/* rebuild raw_path */
-			li_string_encode(vr->request.uri.path->str, vr->request.uri.raw_path, LI_ENCODING_URI);
-			if (vr->request.uri.query->len > 0) {
-				g_string_append_len(vr->request.uri.raw_path, CONST_STR_LEN("?"));
-				g_string_append_len(vr->request.uri.raw_path, GSTR_LEN(vr->request.uri.query));
-			}
+		/* change request path */
+		g_string_truncate(vr->request.uri.path, 0);
+		g_string_append_len(vr->request.uri.path, GSTR_LEN(dest_path));
+		li_path_simplify(vr->request.uri.path);
 
-			/* stop at first matching regex */
-			break;
+		/* rebuild raw_path */
+		li_string_encode(vr->request.uri.path->str, vr->request.uri.raw_path, LI_ENCODING_URI);
+		if (vr->request.uri.query->len > 0) {
+			g_string_append_len(vr->request.uri.raw_path, CONST_STR_LEN("?"));
+			g_string_append_len(vr->request.uri.raw_path, GSTR_LEN(vr->request.uri.query));
 		}
+
+		g_string_free(dest_query, TRUE);
 	}
 
-	g_string_free(dest_query, TRUE);
 	return LI_HANDLER_GO_ON;
 }
 
@@ -227,10 +237,11 @@ static void rewrite_free(liServer *srv, gpointer param) {
 		li_pattern_free(rule->querystring);
 
 		if (rule->regex) {
-			g_regex_unref(rule->regex);
+			li_regex_release(rule->regex);
 		}
 	}
 
+	li_regex_set_free(rd->set);
 	g_array_free(rd->rules, TRUE);
 	g_slice_free(rewrite_data, rd);
 }
@@ -250,6 +261,7 @@ static liAction* rewrite_create(liServer *srv, liWorker *wrk, liPlugin* p, liVal
 	rd = g_slice_new(rewrite_data);
 	rd->p = p;
 	rd->rules = g_array_new(FALSE, FALSE, sizeof(rewrite_rule));
+	rd->set = NULL;
 
 	if (LI_VALUE_STRING == li_value_type(val)) {
 		/* rewrite "/foo/bar"; */
@@ -293,6 +305,16 @@ static liAction* rewrite_create(liServer *srv, liWorker *wrk, liPlugin* p, liVal
 		LI_VALUE_END_FOREACH()
 	}
 
+	if (rd->rules->len > 1) {
+		guint i;
+
+		rd->set = li_regex_set_new();
+		for (i = 0; i < rd->rules->len; i++) {
+			li_regex_set_add(rd->set, g_array_index(rd->rules, rewrite_rule, i).regex);
+		}
+		li_regex_set_prepare(rd->set);
+	}
+
 	return li_action_new_function(raw ? rewrite_raw : rewrite, NULL, rewrite_free, rd);
 }
 
@@ -22,8 +22,10 @@
 LI_API gboolean mod_status_init(liModules *mods, liModule *mod);
 LI_API gboolean mod_status_free(liModules *mods, liModule *mod);
 
-static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_info, GPtrArray *result, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count);
-static GString *status_info_plain(liVRequest *vr, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count);
+typedef struct mod_status_stat_cache mod_status_stat_cache;
+
+static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_info, GPtrArray *result, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count, mod_status_stat_cache *sc_totals);
+static GString *status_info_plain(liVRequest *vr, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count, mod_status_stat_cache *sc_totals);
 static GString *status_info_auto(liVRequest *vr, guint uptime, liStatistics *totals, guint *connection_count);
 static liHandlerResult status_info_runtime(liVRequest *vr, liPlugin *p);
 static gint str_comp(gconstpointer a, gconstpointer b);
@@ -183,6 +185,100 @@ static const gchar html_status_codes[] =
 	"			</tr>\n"
 	"		</table>\n";
 
+static const gchar html_stat_cache[] =
+	"		<table cellspacing=\"0\">\n"
+	"			<tr>\n"
+	"				<th style=\"width: 100px;\">hits</th>\n"
+	"				<th style=\"width: 100px;\">misses</th>\n"
+	"				<th style=\"width: 100px;\">errors</th>\n"
+	"				<th style=\"width: 100px;\">invalidations</th>\n"
+	"				<th style=\"width: 100px;\">shared hits</th>\n"
+	"				<th style=\"width: 100px;\">shared misses</th>\n"
+	"				<th style=\"width: 100px;\">fd hits</th>\n"
+	"				<th style=\"width: 100px;\">fd misses</th>\n"
+	"			</tr>\n"
+	"			<tr>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"			</tr>\n"
+	"		</table>\n";
+
+static const gchar html_content_cache[] =
+	"		<table cellspacing=\"0\">\n"
+	"			<tr>\n"
+	"				<th style=\"width: 100px;\">hits</th>\n"
+	"				<th style=\"width: 100px;\">misses</th>\n"
+	"				<th style=\"width: 100px;\">evictions</th>\n"
+	"				<th style=\"width: 175px;\">traffic from cache</th>\n"
+	"				<th style=\"width: 175px;\">memory used</th>\n"
+	"			</tr>\n"
+	"			<tr>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%s</td>\n"
+	"				<td>%s</td>\n"
+	"			</tr>\n"
+	"		</table>\n";
+
+static const gchar html_network_reads[] =
+	"		<table cellspacing=\"0\">\n"
+	"			<tr>\n"
+	"				<th style=\"width: 175px;\">read syscalls</th>\n"
+	"				<th style=\"width: 175px;\">reads / request</th>\n"
+	"			</tr>\n"
+	"			<tr>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%.2f</td>\n"
+	"			</tr>\n"
+	"		</table>\n";
+
+static const gchar html_actions[] =
+	"		<table cellspacing=\"0\">\n"
+	"			<tr>\n"
+	"				<th style=\"width: 175px;\">actions executed</th>\n"
+	"				<th style=\"width: 175px;\">actions / request</th>\n"
+	"				<th style=\"width: 175px;\">ns / request</th>\n"
+	"			</tr>\n"
+	"			<tr>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%.2f</td>\n"
+	"				<td>%.0f</td>\n"
+	"			</tr>\n"
+	"		</table>\n";
+
+static const gchar html_accept_th[] =
+	"		<table cellspacing=\"0\">\n"
+	"			<tr>\n"
+	"				<th style=\"width: 100px;\"></th>\n"
+	"				<th style=\"width: 100px;\">accepted</th>\n"
+	"				<th style=\"width: 100px;\">handoffs</th>\n"
+	"				<th style=\"width: 100px;\">per handoff</th>\n"
+	"				<th style=\"width: 100px;\">&lt; 0.1ms</th>\n"
+	"				<th style=\"width: 100px;\">&lt; 1ms</th>\n"
+	"				<th style=\"width: 100px;\">&lt; 10ms</th>\n"
+	"				<th style=\"width: 100px;\">&lt; 100ms</th>\n"
+	"				<th style=\"width: 100px;\">more</th>\n"
+	"			</tr>\n";
+static const gchar html_accept_row[] =
+	"			<tr class=\"%s\">\n"
+	"				<td class=\"left\">%s</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%.2f</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"				<td>%" G_GUINT64_FORMAT "</td>\n"
+	"			</tr>\n";
+
 static const gchar html_connections_th[] =
 	"		<table cellspacing=\"0\">\n"
 	"			<tr>\n"
@@ -353,9 +449,19 @@ struct mod_status_con_data {
 	guint64 bytes_out_5s_diff;
 };
 
+struct mod_status_stat_cache {
+	guint64 hits, misses, errors, invalidations;
+	guint64 shared_hits, shared_misses;
+	guint64 file_hits, file_misses;
+
+	/* content cache */
+	guint64 content_hits, content_misses, content_evictions, content_bytes_served, content_mem_used;
+};
+
 struct mod_status_wrk_data {
 	guint worker_ndx;
 	liStatistics stats;
+	mod_status_stat_cache stat_cache;
 	GArray *connections;
 	guint connection_count[LI_CON_STATE_LAST+1];
 };
@@ -376,6 +482,23 @@ static gpointer status_collect_func(liWorker *wrk, gpointer fdata) {
 
 	sd->stats = wrk->stats;
 	sd->worker_ndx = wrk->ndx;
+	if (NULL != wrk->stat_cache) {
+		sd->stat_cache.hits = wrk->stat_cache->hits;
+		sd->stat_cache.misses = wrk->stat_cache->misses;
+		sd->stat_cache.errors = wrk->stat_cache->errors;
+		sd->stat_cache.invalidations = wrk->stat_cache->invalidations;
+		sd->stat_cache.shared_hits = wrk->stat_cache->shared_hits;
+		sd->stat_cache.shared_misses = wrk->stat_cache->shared_misses;
+		sd->stat_cache.file_hits = wrk->stat_cache->file_hits;
+		sd->stat_cache.file_misses = wrk->stat_cache->file_misses;
+	}
+	if (NULL != wrk->content_cache) {
+		sd->stat_cache.content_hits = wrk->content_cache->hits;
+		sd->stat_cache.content_misses = wrk->content_cache->misses;
+		sd->stat_cache.content_evictions = wrk->content_cache->evictions;
+		sd->stat_cache.content_bytes_served = wrk->content_cache->bytes_served;
+		sd->stat_cache.content_mem_used = wrk->content_cache->mem_used;
+	}
 	/* gather connection info */
 	sd->connections = g_array_sized_new(FALSE, TRUE, sizeof(mod_status_con_data), wrk->connections_active);
 	g_array_set_size(sd->connections, wrk->connections_active);
@@ -450,14 +573,11 @@ static void status_collect_cb(gpointer cbdata, gpointer fdata, GPtrArray *result
 		guint uptime, len;
 		guint total_connections = 0;
 		guint connection_count[LI_CON_STATE_LAST+1] = {0};
+		mod_status_stat_cache sc_totals = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
-		liStatistics totals = {
-			G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0),
-			G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0),
-			G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0),
-			0, 0, {G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0), G_GUINT64_CONSTANT(0)},
-			G_GUINT64_CONSTANT(0), 0, 0
-		};
+		liStatistics totals;
+
+		memset(&totals, 0, sizeof(totals));
 
 		/* clear context so it doesn't get cleaned up anymore */
 		*(job->context) = NULL;
@@ -479,6 +599,13 @@ static void status_collect_cb(gpointer cbdata, gpointer fdata, GPtrArray *result
 			totals.bytes_in += sd->stats.bytes_in;
 			totals.requests += sd->stats.requests;
 			totals.actions_executed += sd->stats.actions_executed;
+			totals.actions_ns += sd->stats.actions_ns;
+			totals.read_syscalls += sd->stats.read_syscalls;
+			totals.accepted += sd->stats.accepted;
+			totals.accept_handoffs += sd->stats.accept_handoffs;
+			for (j = 0; j < LI_ACCEPT_LATENCY_BUCKETS; ++j) {
+				totals.accept_latency[j] += sd->stats.accept_latency[j];
+			}
 			total_connections += sd->connections->len;
 
 			totals.requests_5s_diff += sd->stats.requests_5s_diff;
@@ -495,17 +622,31 @@ static void status_collect_cb(gpointer cbdata, gpointer fdata, GPtrArray *result
 			for (j = 0; j <= LI_CON_STATE_LAST; ++j) {
 				connection_count[j] += sd->connection_count[j];
 			}
+
+			sc_totals.hits += sd->stat_cache.hits;
+			sc_totals.misses += sd->stat_cache.misses;
+			sc_totals.errors += sd->stat_cache.errors;
+			sc_totals.invalidations += sd->stat_cache.invalidations;
+			sc_totals.shared_hits += sd->stat_cache.shared_hits;
+			sc_totals.shared_misses += sd->stat_cache.shared_misses;
+			sc_totals.file_hits += sd->stat_cache.file_hits;
+			sc_totals.file_misses += sd->stat_cache.file_misses;
+			sc_totals.content_hits += sd->stat_cache.content_hits;
+			sc_totals.content_misses += sd->stat_cache.content_misses;
+			sc_totals.content_evictions += sd->stat_cache.content_evictions;
+			sc_totals.content_bytes_served += sd->stat_cache.content_bytes_served;
+			sc_totals.content_mem_used += sd->stat_cache.content_mem_used;
 		}
 
 		if (li_querystring_find(vr->request.uri.query, CONST_STR_LEN("format"), &val, &len) && strncmp(val, "plain", len) == 0) {
 			/* show plain text page */
-			html = status_info_plain(vr, uptime, &totals, total_connections, &connection_count[0]);
+			html = status_info_plain(vr, uptime, &totals, total_connections, &connection_count[0], &sc_totals);
 		} else if (li_strncase_equal(vr->request.uri.query, CONST_STR_LEN("auto"))) {
 			/* show auto text page */
 			html = status_info_auto(vr, uptime, &totals, &connection_count[0]);
 		} else {
 			/* show full html page */
-			html = status_info_full(vr, p, short_info, result, uptime, &totals, total_connections, &connection_count[0]);
+			html = status_info_full(vr, p, short_info, result, uptime, &totals, total_connections, &connection_count[0], &sc_totals);
 		}
 
 		LI_FORCE_ASSERT(li_vrequest_handle_direct(vr));
@@ -533,7 +674,7 @@ static void status_collect_cb(gpointer cbdata, gpointer fdata, GPtrArray *result
 	}
 }
 
-static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_info, GPtrArray *result, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count) {
+static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_info, GPtrArray *result, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count, mod_status_stat_cache *sc_totals) {
 	GString *html, *css, *count_req, *count_bin, *count_bout, *count_mem, *tmpstr;
 	gchar *val;
 	guint i, j, len;
@@ -728,6 +869,52 @@ static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_inf
 		mod_status_response_codes[2], mod_status_response_codes[3], mod_status_response_codes[4]
 	);
 
+	/* stat cache */
+	g_string_append_len(html, CONST_STR_LEN("<div class=\"title\"><strong>Stat cache</strong> (sum)</div>\n"));
+	g_string_append_printf(html, html_stat_cache, sc_totals->hits, sc_totals->misses, sc_totals->errors,
+		sc_totals->invalidations, sc_totals->shared_hits, sc_totals->shared_misses,
+		sc_totals->file_hits, sc_totals->file_misses
+	);
+
+	/* content cache */
+	g_string_append_len(html, CONST_STR_LEN("<div class=\"title\"><strong>Content cache</strong> (sum)</div>\n"));
+	li_counter_format(sc_totals->content_bytes_served, COUNTER_BYTES, count_bout);
+	li_counter_format(sc_totals->content_mem_used, COUNTER_BYTES, count_mem);
+	g_string_append_printf(html, html_content_cache, sc_totals->content_hits, sc_totals->content_misses,
+		sc_totals->content_evictions, count_bout->str, count_mem->str
+	);
+
+	/* network reads (client and backend sockets) */
+	g_string_append_len(html, CONST_STR_LEN("<div class=\"title\"><strong>Network reads</strong> (sum)</div>\n"));
+	g_string_append_printf(html, html_network_reads, totals->read_syscalls,
+		totals->requests ? (gdouble) totals->read_syscalls / totals->requests : 0.0
+	);
+
+	/* config actions (li_action_execute) */
+	g_string_append_len(html, CONST_STR_LEN("<div class=\"title\"><strong>Actions</strong> (sum)</div>\n"));
+	g_string_append_printf(html, html_actions, totals->actions_executed,
+		totals->requests ? (gdouble) totals->actions_executed / totals->requests : 0.0,
+		totals->requests ? (gdouble) totals->actions_ns / totals->requests : 0.0
+	);
+
+	/* new connections: handoffs from the accepting thread and time until the worker started them */
+	g_string_append_len(html, CONST_STR_LEN("<div class=\"title\"><strong>Accepted connections</strong> (by time from accept to start)</div>\n"));
+	g_string_append_len(html, CONST_STR_LEN(html_accept_th));
+	#define ACCEPT_ROW(class, name, stats) \
+		g_string_append_printf(html, html_accept_row, class, name, \
+			(stats).accepted, (stats).accept_handoffs, \
+			(stats).accept_handoffs ? (gdouble) (stats).accepted / (stats).accept_handoffs : 0.0, \
+			(stats).accept_latency[0], (stats).accept_latency[1], (stats).accept_latency[2], \
+			(stats).accept_latency[3], (stats).accept_latency[4])
+	for (i = 0; i < result->len; i++) {
+		mod_status_wrk_data *sd = g_ptr_array_index(result, i);
+		g_string_printf(tmpstr, "Worker #%u", i+1);
+		ACCEPT_ROW("", tmpstr->str, sd->stats);
+	}
+	ACCEPT_ROW("totals", "Total", *totals);
+	#undef ACCEPT_ROW
+	g_string_append_len(html, CONST_STR_LEN("		</table>\n"));
+
 
 	/* list connections */
 	if (!short_info) {
@@ -807,7 +994,7 @@ static GString *status_info_full(liVRequest *vr, liPlugin *p, gboolean short_inf
 	return html;
 }
 
-static GString *status_info_plain(liVRequest *vr, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count) {
+static GString *status_info_plain(liVRequest *vr, guint uptime, liStatistics *totals, guint total_connections, guint *connection_count, mod_status_stat_cache *sc_totals) {
 	GString *html;
 
 	html = g_string_sized_new(1024 - 1);
@@ -867,6 +1054,61 @@ static GString *status_info_plain(liVRequest *vr, guint uptime, liStatistics *to
 	li_string_append_int(html, mod_status_response_codes[3]);
 	g_string_append_len(html, CONST_STR_LEN("\nstatus_5xx: "));
 	li_string_append_int(html, mod_status_response_codes[4]);
+	/* stat cache */
+	g_string_append_len(html, CONST_STR_LEN("\n\n# Stat Cache (since start)\nstat_cache_hits: "));
+	li_string_append_int(html, sc_totals->hits);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_misses: "));
+	li_string_append_int(html, sc_totals->misses);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_errors: "));
+	li_string_append_int(html, sc_totals->errors);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_invalidations: "));
+	li_string_append_int(html, sc_totals->invalidations);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_shared_hits: "));
+	li_string_append_int(html, sc_totals->shared_hits);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_shared_misses: "));
+	li_string_append_int(html, sc_totals->shared_misses);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_fd_hits: "));
+	li_string_append_int(html, sc_totals->file_hits);
+	g_string_append_len(html, CONST_STR_LEN("\nstat_cache_fd_misses: "));
+	li_string_append_int(html, sc_totals->file_misses);
+	/* content cache */
+	g_string_append_len(html, CONST_STR_LEN("\n\n# Content Cache (since start)\ncontent_cache_hits: "));
+	li_string_append_int(html, sc_totals->content_hits);
+	g_string_append_len(html, CONST_STR_LEN("\ncontent_cache_misses: "));
+	li_string_append_int(html, sc_totals->content_misses);
+	g_string_append_len(html, CONST_STR_LEN("\ncontent_cache_evictions: "));
+	li_string_append_int(html, sc_totals->content_evictions);
+	g_string_append_len(html, CONST_STR_LEN("\ncontent_cache_bytes_served: "));
+	li_string_append_int(html, sc_totals->content_bytes_served);
+	g_string_append_len(html, CONST_STR_LEN("\ncontent_cache_memory_used: "));
+	li_string_append_int(html, sc_totals->content_mem_used);
+	/* network reads */
+	g_string_append_len(html, CONST_STR_LEN("\n\n# Network Reads (since start)\nread_syscalls: "));
+	li_string_append_int(html, totals->read_syscalls);
+	g_string_append_len(html, CONST_STR_LEN("\nread_syscalls_per_request: "));
+	g_string_append_printf(html, "%.2f", totals->requests ? (gdouble) totals->read_syscalls / totals->requests : 0.0);
+	/* actions */
+	g_string_append_len(html, CONST_STR_LEN("\n\n# Actions (since start)\nactions_executed: "));
+	li_string_append_int(html, totals->actions_executed);
+	g_string_append_len(html, CONST_STR_LEN("\nactions_per_request: "));
+	g_string_append_printf(html, "%.2f", totals->requests ? (gdouble) totals->actions_executed / totals->requests : 0.0);
+	g_string_append_len(html, CONST_STR_LEN("\nactions_ns_per_request: "));
+	g_string_append_printf(html, "%.0f", totals->requests ? (gdouble) totals->actions_ns / totals->requests : 0.0);
+	/* accepted connections */
+	g_string_append_len(html, CONST_STR_LEN("\n\n# Accepted Connections (since start)\naccepted: "));
+	li_string_append_int(html, totals->accepted);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_handoffs: "));
+	li_string_append_int(html, totals->accept_handoffs);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_latency_100us: "));
+	li_string_append_int(html, totals->accept_latency[0]);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_latency_1ms: "));
+	li_string_append_int(html, totals->accept_latency[1]);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_latency_10ms: "));
+	li_string_append_int(html, totals->accept_latency[2]);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_latency_100ms: "));
+	li_string_append_int(html, totals->accept_latency[3]);
+	g_string_append_len(html, CONST_STR_LEN("\naccept_latency_more: "));
+	li_string_append_int(html, totals->accept_latency[4]);
 
 	li_http_header_overwrite(vr->response.headers, CONST_STR_LEN("Content-Type"), CONST_STR_LEN("text/plain"));
 
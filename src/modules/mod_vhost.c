@@ -24,7 +24,7 @@ struct vhost_map_data {
 
 typedef struct vhost_map_regex_entry vhost_map_regex_entry;
 struct vhost_map_regex_entry {
-	GRegex *regex;
+	liRegex *regex;
 	liValue *action;
 };
 
@@ -32,6 +32,7 @@ typedef struct vhost_map_regex_data vhost_map_regex_data;
 struct vhost_map_regex_data {
 	liPlugin *plugin;
 	GArray *list; /* array of vhost_map_regex_entry */
+	liRegexSet *set; /* all regexes of list */
 	liValue *default_action;
 };
 
@@ -139,24 +140,39 @@ static liHandlerResult vhost_map_regex(liVRequest *vr, gpointer param, gpointer
 	gboolean debug = _OPTION(vr, mrd->plugin, 0).boolean;
 	liValue *v = NULL;
 	vhost_map_regex_entry *entry = NULL;
+	GError *err = NULL;
 
 	UNUSED(context);
 
-	/* loop through all rules to find a match */
-	for (i = 0; i < list->len; i++) {
-		entry = &g_array_index(list, vhost_map_regex_entry, i);
+	/* find the first matching rule */
+	if (NULL != mrd->set) {
+		gint ndx = li_regex_set_match(mrd->set, vr->request.uri.host->str, NULL, &err);
+
+		if (ndx >= 0) {
+			entry = &g_array_index(list, vhost_map_regex_entry, ndx);
+			v = entry->action;
+		}
+	} else {
+		for (i = 0; i < list->len; i++) {
+			entry = &g_array_index(list, vhost_map_regex_entry, i);
 
-		if (!g_regex_match(entry->regex, vr->request.uri.host->str, 0, NULL))
-			continue;
+			if (!li_regex_match(entry->regex, vr->request.uri.host->str, NULL, (NULL == err) ? &err : NULL))
+				continue;
 
-		v = entry->action;
+			v = entry->action;
 
-		break;
+			break;
+		}
+	}
+
+	if (NULL != err) {
+		VR_ERROR(vr, "vhost_map_regex: %s", err->message);
+		g_error_free(err);
 	}
 
 	if (NULL != v) {
 		if (debug) {
-			VR_DEBUG(vr, "vhost_map_regex: host %s matches pattern \"%s\"", vr->request.uri.host->str, g_regex_get_pattern(entry->regex));
+			VR_DEBUG(vr, "vhost_map_regex: host %s matches pattern \"%s\"", vr->request.uri.host->str, li_regex_get_pattern(entry->regex));
 		}
 		li_action_enter(vr, v->data.val_action.action);
 	} else if (NULL != mrd->default_action) {
@@ -182,9 +198,10 @@ static void vhost_map_regex_free(liServer *srv, gpointer param) {
 	for (i = 0; i < list->len; i++) {
 		vhost_map_regex_entry *entry = &g_array_index(list, vhost_map_regex_entry, i);
 
-		g_regex_unref(entry->regex);
+		li_regex_release(entry->regex);
 		li_value_free(entry->action);
 	}
+	li_regex_set_free(mrd->set);
 	g_array_free(list, TRUE);
 
 	if (NULL != mrd->default_action) {
@@ -240,7 +257,7 @@ static liAction* vhost_map_regex_create(liServer *srv, liWorker *wrk, liPlugin*
 			GError *err = NULL;
 			vhost_map_regex_entry map_entry;
 
-			map_entry.regex = g_regex_new(entryKeyStr->str, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &err);
+			map_entry.regex = li_regex_new(entryKeyStr->str, &err);
 			g_string_free(entryKeyStr, TRUE);
 
 			if (NULL == map_entry.regex) {
@@ -258,6 +275,16 @@ static liAction* vhost_map_regex_create(liServer *srv, liWorker *wrk, liPlugin*
 		}
 	LI_VALUE_END_FOREACH()
 
+	if (mrd->list->len > 1) {
+		guint i;
+
+		mrd->set = li_regex_set_new();
+		for (i = 0; i < mrd->list->len; i++) {
+			li_regex_set_add(mrd->set, g_array_index(mrd->list, vhost_map_regex_entry, i).regex);
+		}
+		li_regex_set_prepare(mrd->set);
+	}
+
 	return li_action_new_function(vhost_map_regex, NULL, vhost_map_regex_free, mrd);
 }
 
@@ -5,6 +5,13 @@
 #include <openssl/err.h>
 #include <openssl/rand.h>
 
+#ifdef USE_OPENSSL_KTLS
+enum {
+	KTLS_NONE,
+	KTLS_ENABLED, /* SSL_OP_ENABLE_KTLS set, OpenSSL writes the handshake to the socket directly */
+	KTLS_ACTIVE   /* OpenSSL installed the keys in the socket, the kernel encrypts */
+};
+#endif
 
 struct liOpenSSLFilter {
 	int refcount;
@@ -28,8 +35,60 @@ struct liOpenSSLFilter {
 	unsigned int client_initiated_renegotiation:1;
 	unsigned int closing:1, aborted:1;
 	unsigned int write_wants_read:1;
+
+#ifdef USE_OPENSSL_KTLS
+	unsigned int ktls_state:2;
+	liEventIO ktls_write_watcher; /* socket buffer full while writing the handshake */
+#endif
 };
 
+#ifdef USE_OPENSSL_KTLS
+
+/* the socket is writable again: continue the handshake (done in do_ssl_read) */
+static void ktls_write_watcher_cb(liEventBase *watcher, int events) {
+	liOpenSSLFilter *f = LI_CONTAINER_OF(li_event_io_from(watcher), liOpenSSLFilter, ktls_write_watcher);
+	UNUSED(events);
+
+	li_event_stop(&f->ktls_write_watcher);
+	li_stream_again_later(&f->plain_source);
+}
+
+/* OpenSSL tried to install the keys in the socket (BIO_set_ktls on the socket BIO) when it got them */
+static void ktls_handshake_done(liOpenSSLFilter *f) {
+	li_event_clear(&f->ktls_write_watcher);
+
+	if (BIO_get_ktls_send(SSL_get_wbio(f->ssl))) {
+		f->ktls_state = KTLS_ACTIVE;
+		/* OpenSSL would write a close_notify alert to the socket directly, ahead of the response data
+		 * still queued in userspace; just close the connection instead */
+		SSL_set_quiet_shutdown(f->ssl, 1);
+	} else {
+		/* no tls kernel module or unsupported cipher: encrypt in userspace, buffer the records in
+		 * crypt_source again */
+		f->ktls_state = KTLS_NONE;
+		BIO_up_ref(f->bio);
+		SSL_set0_wbio(f->ssl, f->bio);
+	}
+}
+
+/* the kernel encrypts: pass the plain data on to the socket, file chunks get sent with sendfile() */
+static void ktls_forward_plain(liOpenSSLFilter *f) {
+	liChunkQueue *cq = f->plain_drain.out, *out = f->crypt_source.out;
+	liChunk *c;
+	gboolean moved = FALSE;
+
+	while (NULL != (c = li_chunkqueue_first_chunk(cq))) {
+		/* file chunks don't count for the limit */
+		if (FILE_CHUNK != c->type && 0 == li_chunkqueue_limit_available(out)) break;
+		li_chunkqueue_steal_chunk(out, cq);
+		moved = TRUE;
+	}
+
+	if (moved) li_stream_notify_later(&f->crypt_source);
+}
+
+#endif
+
 #define BIO_TYPE_LI_STREAM (127|BIO_TYPE_SOURCE_SINK)
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L || defined(LIBRESSL_VERSION_NUMBER)
@@ -257,6 +316,10 @@ static void f_close_ssl(liOpenSSLFilter *f) {
 
 		f->closing = TRUE;
 
+#ifdef USE_OPENSSL_KTLS
+		li_event_clear(&f->ktls_write_watcher);
+#endif
+
 		LI_FORCE_ASSERT(NULL != f->crypt_source.out);
 		LI_FORCE_ASSERT(NULL != f->crypt_source.out->limit);
 		limit = f->crypt_source.out->limit;
@@ -319,6 +382,17 @@ static void do_handle_error(liOpenSSLFilter *f, const char *sslfunc, int r, gboo
 	case SSL_ERROR_WANT_READ:
 		if (writing) f->write_wants_read = TRUE;
 		break;
+#ifdef USE_OPENSSL_KTLS
+	case SSL_ERROR_WANT_WRITE:
+		/* only the socket BIO for kTLS doesn't buffer writes; after the handshake the connection is gone
+		 * anyway if OpenSSL has to write something (alerts) */
+		if (KTLS_ENABLED == f->ktls_state) {
+			li_event_start(&f->ktls_write_watcher);
+		} else {
+			f_abort_ssl(f);
+		}
+		break;
+#endif
 	/*
 	case SSL_ERROR_WANT_WRITE:
 		we buffer all writes, can't happen! - handle as fatal error below
@@ -392,6 +466,9 @@ static gboolean do_ssl_handshake(liOpenSSLFilter *f, gboolean writing) {
 		f->ssl->s3->flags |= SSL3_FLAGS_NO_RENEGOTIATE_CIPHERS;
 #else
 		/* hopefully openssl_info_callback catches this... */
+#endif
+#ifdef USE_OPENSSL_KTLS
+		if (KTLS_ENABLED == f->ktls_state) ktls_handshake_done(f);
 #endif
 		li_stream_acquire(&f->plain_source);
 		li_stream_acquire(&f->plain_drain);
@@ -444,7 +521,7 @@ static void do_ssl_read(liOpenSSLFilter *f) {
 				f->raw_in_buffer = buf = NULL;
 			}
 			if (buf == NULL) {
-				f->raw_in_buffer = buf = li_buffer_new(blocksize);
+				f->raw_in_buffer = buf = li_buffer_pool_get(f->wrk->buffer_pool, blocksize);
 			}
 		}
 		LI_FORCE_ASSERT(f->raw_in_buffer == buf);
@@ -529,6 +606,13 @@ static void do_ssl_write(liOpenSSLFilter *f) {
 		goto out;
 	}
 
+#ifdef USE_OPENSSL_KTLS
+	if (KTLS_ACTIVE == f->ktls_state) {
+		ktls_forward_plain(f);
+		goto check_closed;
+	}
+#endif
+
 	do {
 		GError *err = NULL;
 		liChunkIter ci;
@@ -536,9 +620,12 @@ static void do_ssl_write(liOpenSSLFilter *f) {
 		if (0 == cq->length) break;
 
 		ci = li_chunkqueue_iter(cq);
-		switch (li_chunkiter_read(ci, 0, blocksize, &block_data, &block_len, &err)) {
+		switch (li_stream_chunkiter_read(&f->plain_drain, f->wrk->tasklets, ci, 0, blocksize, &block_data, &block_len, &err)) {
 		case LI_HANDLER_GO_ON:
 			break;
+		case LI_HANDLER_WAIT_FOR_EVENT:
+			/* file data is loaded in the background, plain_drain gets woken up */
+			goto out;
 		case LI_HANDLER_ERROR:
 			if (NULL != err) {
 				_ERROR(f->srv, f->wrk, f->log_context, "Couldn't read data from chunkqueue: %s", err->message);
@@ -576,6 +663,9 @@ static void do_ssl_write(liOpenSSLFilter *f) {
 		write_max -= r;
 	} while (r == block_len && write_max > 0);
 
+#ifdef USE_OPENSSL_KTLS
+check_closed:
+#endif
 	if (cq->is_closed && 0 == cq->length) {
 		r = SSL_shutdown(f->ssl);
 		switch (r) {
@@ -822,3 +912,27 @@ void li_openssl_filter_free(liOpenSSLFilter *f) {
 SSL* li_openssl_filter_ssl(liOpenSSLFilter *f) {
 	return f->ssl;
 }
+
+gboolean li_openssl_filter_enable_ktls(liOpenSSLFilter *f, liIOStream *sock_stream) {
+#ifdef USE_OPENSSL_KTLS
+	int fd = li_event_io_fd(&sock_stream->io_watcher);
+	BIO *wbio;
+
+	LI_FORCE_ASSERT(f->crypt_source.dest == &sock_stream->stream_out);
+
+	if (NULL == f->ssl || f->initial_handshaked_finished || -1 == fd) return FALSE;
+
+	/* OpenSSL only offloads to socket BIOs; nothing else gets sent before the handshake, so it can write
+	 * the handshake to the socket itself. reading still goes through the chunkqueue BIO */
+	if (NULL == (wbio = BIO_new_socket(fd, BIO_NOCLOSE))) return FALSE;
+	SSL_set0_wbio(f->ssl, wbio);
+	SSL_set_options(f->ssl, SSL_OP_ENABLE_KTLS);
+
+	li_event_io_init(&f->wrk->loop, "openssl ktls", &f->ktls_write_watcher, ktls_write_watcher_cb, fd, LI_EV_WRITE);
+	f->ktls_state = KTLS_ENABLED;
+	return TRUE;
+#else
+	UNUSED(f); UNUSED(sock_stream);
+	return FALSE;
+#endif
+}
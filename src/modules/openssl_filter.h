@@ -5,6 +5,12 @@
 
 #include <openssl/ssl.h>
 
+/* kernel TLS (TX only): OpenSSL 3 built with kTLS support installs the keys in the socket itself */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER) \
+	&& defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+# define USE_OPENSSL_KTLS
+#endif
+
 typedef struct liOpenSSLFilter liOpenSSLFilter;
 
 typedef void (*liOpenSSLFilterHandshakeCB)(liOpenSSLFilter *f, gpointer data, liStream *plain_source, liStream *plain_drain);
@@ -26,4 +32,10 @@ LI_API void li_openssl_filter_free(liOpenSSLFilter *f);
 
 LI_API SSL* li_openssl_filter_ssl(liOpenSSLFilter *f);
 
+/* let the kernel encrypt outgoing data after the handshake if possible (kTLS); the plain data is passed
+ * on to sock_stream then, so file chunks can be sent with sendfile().
+ * sock_stream->stream_out has to be the crypt_drain the filter was created with; call before the handshake.
+ * returns FALSE if not supported (falls back to encryption in userspace silently otherwise) */
+LI_API gboolean li_openssl_filter_enable_ktls(liOpenSSLFilter *f, liIOStream *sock_stream);
+
 #endif
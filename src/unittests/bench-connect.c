@@ -0,0 +1,121 @@
+
+#include <lighttpd/base.h>
+
+/* connect-rate benchmark: open connections to a running lighttpd2, send a minimal
+ * HTTP/1.0 request and read the response until EOF.
+ *
+ * compare the accept modes by running it against a config with
+ *   setup { workers 8; listen "127.0.0.1:8080"; }
+ * and one with
+ *   setup { workers 8; listen.reuse_port "127.0.0.1:8080"; }
+ *
+ * usage: bench-connect <socket-address> [threads] [seconds]
+ */
+
+typedef struct bench_thread bench_thread;
+struct bench_thread {
+	liSocketAddress *addr;
+	guint64 connections, errors;
+};
+
+static gint bench_stop = 0;
+
+static const char bench_request[] = "GET / HTTP/1.0\r\nHost: bench\r\n\r\n";
+
+static gboolean bench_one(liSocketAddress *addr) {
+	char buf[4096];
+	ssize_t r;
+	int s;
+
+	if (-1 == (s = socket(addr->addr->plain.sa_family, SOCK_STREAM, 0))) return FALSE;
+
+	if (-1 == connect(s, &addr->addr->plain, addr->len)) goto error;
+	if ((ssize_t) (sizeof(bench_request) - 1) != write(s, bench_request, sizeof(bench_request) - 1)) goto error;
+
+	for (;;) {
+		r = read(s, buf, sizeof(buf));
+		if (0 == r) break;
+		if (r < 0) {
+			if (EINTR == errno) continue;
+			goto error;
+		}
+	}
+
+	close(s);
+	return TRUE;
+
+error:
+	close(s);
+	return FALSE;
+}
+
+static gpointer bench_thread_cb(gpointer data) {
+	bench_thread *t = data;
+
+	while (!g_atomic_int_get(&bench_stop)) {
+		if (bench_one(t->addr)) {
+			t->connections++;
+		} else {
+			t->errors++;
+		}
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	liSocketAddress addr;
+	GString *addrstr;
+	bench_thread *threads;
+	GThread **handles;
+	guint nthreads = 16, seconds = 10, i;
+	guint64 connections = 0, errors = 0;
+	GTimer *timer;
+	gdouble elapsed;
+
+	if (argc < 2) {
+		g_printerr("usage: %s <socket-address> [threads] [seconds]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) nthreads = MAX(1, atoi(argv[2]));
+	if (argc > 3) seconds = MAX(1, atoi(argv[3]));
+
+	g_thread_init(NULL);
+
+	addrstr = g_string_new(argv[1]);
+	addr = li_sockaddr_from_string(addrstr, 80);
+	g_string_free(addrstr, TRUE);
+	if (NULL == addr.addr) {
+		g_printerr("invalid socket address: '%s'\n", argv[1]);
+		return 1;
+	}
+
+	threads = g_new0(bench_thread, nthreads);
+	handles = g_new0(GThread*, nthreads);
+
+	timer = g_timer_new();
+	for (i = 0; i < nthreads; i++) {
+		threads[i].addr = &addr;
+		handles[i] = g_thread_create(bench_thread_cb, &threads[i], TRUE, NULL);
+	}
+
+	g_usleep((gulong) seconds * G_USEC_PER_SEC);
+	g_atomic_int_set(&bench_stop, 1);
+
+	for (i = 0; i < nthreads; i++) {
+		g_thread_join(handles[i]);
+		connections += threads[i].connections;
+		errors += threads[i].errors;
+	}
+	elapsed = g_timer_elapsed(timer, NULL);
+
+	g_print("%s: %u threads, %.2f s: %" G_GUINT64_FORMAT " connections (%.0f/s), %" G_GUINT64_FORMAT " errors\n",
+		argv[1], nthreads, elapsed, connections, connections / elapsed, errors);
+
+	g_timer_destroy(timer);
+	g_free(handles);
+	g_free(threads);
+	li_sockaddr_clear(&addr);
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+
+#include <lighttpd/base.h>
+
+/* mempool benchmark: multi-threaded li_mempool_alloc/li_mempool_free (compared with g_malloc/g_free)
+ *
+ * local:  each thread frees the chunks it allocated
+ * remote: each thread hands batches of allocated chunks to the next thread, which frees them
+ *         (like buffers handed between workers)
+ *
+ * usage: bench-mempool [max-threads] [seconds-per-run]
+ */
+
+#define BENCH_BATCH 64
+
+static const gsize bench_sizes[] = { 4*1024, 16*1024, 64*1024 };
+
+typedef enum { BENCH_MEMPOOL, BENCH_MALLOC } bench_allocator;
+
+typedef struct bench_run bench_run;
+typedef struct bench_thread bench_thread;
+typedef struct bench_batch bench_batch;
+
+struct bench_batch {
+	liMempoolPtr ptrs[BENCH_BATCH];
+	gsize sizes[BENCH_BATCH];
+};
+
+struct bench_run {
+	bench_allocator allocator;
+	gboolean remote;
+	guint nthreads;
+	bench_thread *threads;
+	gint stop;
+};
+
+struct bench_thread {
+	bench_run *run;
+	guint ndx;
+	GAsyncQueue *incoming; /* bench_batch* from the previous thread */
+	guint64 ops;
+};
+
+static void bench_batch_alloc(bench_run *run, bench_batch *b, guint seed) {
+	guint i;
+
+	for (i = 0; i < BENCH_BATCH; i++) {
+		gsize size = bench_sizes[(seed + i) % G_N_ELEMENTS(bench_sizes)];
+		b->sizes[i] = size;
+		if (BENCH_MEMPOOL == run->allocator) {
+			b->ptrs[i] = li_mempool_alloc(size);
+		} else {
+			b->ptrs[i].priv_data = NULL;
+			b->ptrs[i].data = g_malloc(size);
+		}
+		/* touch the memory */
+		((gchar*) b->ptrs[i].data)[0] = 1;
+	}
+}
+
+static void bench_batch_free(bench_run *run, bench_batch *b) {
+	guint i;
+
+	for (i = 0; i < BENCH_BATCH; i++) {
+		if (BENCH_MEMPOOL == run->allocator) {
+			li_mempool_free(b->ptrs[i], b->sizes[i]);
+		} else {
+			g_free(b->ptrs[i].data);
+		}
+	}
+}
+
+static gpointer bench_thread_cb(gpointer data) {
+	bench_thread *t = data;
+	bench_run *run = t->run;
+	GAsyncQueue *next = run->threads[(t->ndx + 1) % run->nthreads].incoming;
+	guint seed = t->ndx;
+	bench_batch *b;
+
+	while (!g_atomic_int_get(&run->stop)) {
+		b = g_slice_new(bench_batch);
+		bench_batch_alloc(run, b, seed++);
+
+		if (run->remote) {
+			g_async_queue_push(next, b);
+
+			/* free what the previous thread sent, don't get too far ahead */
+			while (NULL != (b = g_async_queue_try_pop(t->incoming))) {
+				bench_batch_free(run, b);
+				g_slice_free(bench_batch, b);
+			}
+			while (g_async_queue_length(next) > 16 && !g_atomic_int_get(&run->stop)) g_thread_yield();
+		} else {
+			bench_batch_free(run, b);
+			g_slice_free(bench_batch, b);
+		}
+
+		t->ops += BENCH_BATCH;
+	}
+
+	return NULL;
+}
+
+static void bench(guint nthreads, guint seconds, bench_allocator allocator, gboolean remote) {
+	bench_run run;
+	GThread **handles = g_new0(GThread*, nthreads);
+	GTimer *timer;
+	guint64 ops = 0;
+	gdouble elapsed;
+	bench_batch *b;
+	guint i;
+
+	run.allocator = allocator;
+	run.remote = remote;
+	run.nthreads = nthreads;
+	run.threads = g_new0(bench_thread, nthreads);
+	run.stop = 0;
+
+	for (i = 0; i < nthreads; i++) {
+		run.threads[i].run = &run;
+		run.threads[i].ndx = i;
+		run.threads[i].incoming = g_async_queue_new();
+	}
+
+	timer = g_timer_new();
+	for (i = 0; i < nthreads; i++) {
+		handles[i] = g_thread_create(bench_thread_cb, &run.threads[i], TRUE, NULL);
+	}
+
+	g_usleep((gulong) seconds * G_USEC_PER_SEC);
+	g_atomic_int_set(&run.stop, 1);
+
+	for (i = 0; i < nthreads; i++) {
+		g_thread_join(handles[i]);
+		ops += run.threads[i].ops;
+	}
+	elapsed = g_timer_elapsed(timer, NULL);
+
+	g_print("%-7s %-6s %3u threads: %12.0f alloc+free/s\n",
+		BENCH_MEMPOOL == allocator ? "mempool" : "malloc", remote ? "remote" : "local", nthreads, ops / elapsed);
+
+	for (i = 0; i < nthreads; i++) {
+		while (NULL != (b = g_async_queue_try_pop(run.threads[i].incoming))) {
+			bench_batch_free(&run, b);
+			g_slice_free(bench_batch, b);
+		}
+		g_async_queue_unref(run.threads[i].incoming);
+	}
+
+	g_timer_destroy(timer);
+	g_free(run.threads);
+	g_free(handles);
+}
+
+int main(int argc, char **argv) {
+	guint max_threads = 16, seconds = 3, n;
+
+	if (argc > 1) max_threads = MAX(1, atoi(argv[1]));
+	if (argc > 2) seconds = MAX(1, atoi(argv[2]));
+
+	g_thread_init(NULL);
+
+	for (n = 1; n <= max_threads; n *= 2) {
+		bench(n, seconds, BENCH_MEMPOOL, FALSE);
+		bench(n, seconds, BENCH_MALLOC, FALSE);
+		bench(n, seconds, BENCH_MEMPOOL, TRUE);
+		bench(n, seconds, BENCH_MALLOC, TRUE);
+	}
+
+	li_mempool_cleanup();
+
+	return 0;
+}
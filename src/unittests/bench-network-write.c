@@ -0,0 +1,241 @@
+
+#include <lighttpd/base.h>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+/* network write benchmark: per round every connection gets one small response (header + body in
+ * memory chunks), like a worker answering a burst of keep-alive requests on many connections.
+ *
+ * writev:   li_network_write() for each connection (one writev() syscall per connection)
+ * sendfile: body is a file chunk: li_network_write() sends the header with MSG_MORE and the body
+ *           with sendfile() (two syscalls per connection)
+ * inline:   body is read from the file with pread() first (static.inline_max_size), then sent
+ *           together with the header in one writev() (two syscalls per connection, one on the socket)
+ * io_uring: one writev per connection queued in a liUring, all submitted with one io_uring_enter()
+ *           in the loop iteration (only available if built with liburing)
+ *
+ * connections are unix socketpairs; the peers are drained after each round (not timed).
+ * needs 2 fds per connection, the fd limit is raised to the hard limit.
+ *
+ * usage: bench-network-write [connections] [body-size] [rounds]
+ */
+
+typedef struct bench_con bench_con;
+struct bench_con {
+	liUringOp op;
+	int fd, peer;
+	liChunkQueue *cq;
+};
+
+static guint bench_pending = 0;
+static guint64 bench_short_writes = 0, bench_errors = 0;
+
+static const char bench_header[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nServer: bench\r\n\r\n";
+
+static void bench_fill(bench_con *bc, const gchar *body, gsize body_size) {
+	li_chunkqueue_append_mem(bc->cq, bench_header, sizeof(bench_header) - 1);
+	li_chunkqueue_append_mem(bc->cq, body, body_size);
+}
+
+static void bench_fill_file(bench_con *bc, liChunkFile *cf, gsize body_size) {
+	li_chunkqueue_append_mem(bc->cq, bench_header, sizeof(bench_header) - 1);
+	li_chunkqueue_append_chunkfile(bc->cq, cf, 0, body_size);
+}
+
+static void bench_fill_inline(bench_con *bc, liChunkFile *cf, gsize body_size) {
+	liBuffer *buf = li_buffer_new(MAX(body_size, 1));
+
+	li_chunkqueue_append_mem(bc->cq, bench_header, sizeof(bench_header) - 1);
+	while (buf->used < body_size) {
+		ssize_t r = pread(cf->fd, buf->addr + buf->used, body_size - buf->used, buf->used);
+		if (r <= 0) {
+			bench_errors++;
+			break;
+		}
+		buf->used += r;
+	}
+	li_chunkqueue_append_buffer2(bc->cq, buf, 0, buf->used);
+}
+
+static void bench_drain(bench_con *cons, guint ncons) {
+	char buf[16*1024];
+	guint i;
+
+	for (i = 0; i < ncons; i++) {
+		while (0 < read(cons[i].peer, buf, sizeof(buf))) ;
+	}
+}
+
+static void bench_uring_done(liUringOp *op, int res) {
+	bench_con *bc = LI_CONTAINER_OF(op, bench_con, op);
+
+	if (res < 0) {
+		bench_errors++;
+	} else {
+		if (res < bc->cq->length) bench_short_writes++;
+		li_chunkqueue_skip(bc->cq, res);
+	}
+
+	bench_pending--;
+}
+
+/* inline_file: fill (pread) in the timed section */
+static gdouble bench_writev_round(bench_con *cons, guint ncons, liChunkFile *inline_file, gsize body_size) {
+	GTimer *timer = g_timer_new();
+	gdouble elapsed;
+	guint i;
+
+	for (i = 0; i < ncons; i++) {
+		GError *err = NULL;
+
+		if (NULL != inline_file) bench_fill_inline(&cons[i], inline_file, body_size);
+
+		if (LI_NETWORK_STATUS_SUCCESS != li_network_write(cons[i].fd, cons[i].cq, 256*1024, NULL, &err)) {
+			bench_errors++;
+			if (NULL != err) g_error_free(err);
+		}
+		if (cons[i].cq->length > 0) bench_short_writes++;
+	}
+
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+	return elapsed;
+}
+
+static gdouble bench_uring_round(liEventLoop *loop, liUring *uring, bench_con *cons, guint ncons) {
+	GTimer *timer = g_timer_new();
+	gdouble elapsed;
+	guint i;
+
+	for (i = 0; i < ncons; i++) {
+		liUringOp *op = &cons[i].op;
+		liChunkIter ci = li_chunkqueue_iter(cons[i].cq);
+		goffset len;
+
+		op->iovcnt = li_chunkiter_gather_iovec(&ci, op->iov, LI_URING_IOV_MAX, cons[i].cq->length, &len);
+
+		while (!li_uring_writev(uring, op, cons[i].fd)) {
+			/* ring full: let the loop submit and reap first */
+			ev_run(loop->loop, EVRUN_ONCE);
+		}
+		bench_pending++;
+	}
+
+	/* prepare watcher submits, ring watcher reaps */
+	while (bench_pending > 0) ev_run(loop->loop, EVRUN_ONCE);
+
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+	return elapsed;
+}
+
+static void bench_print(const gchar *mode, guint ncons, guint rounds, gdouble elapsed) {
+	g_print("%-9s %6u connections: %8.3f s, %10.0f responses/s, %" G_GUINT64_FORMAT " short writes, %" G_GUINT64_FORMAT " errors\n",
+		mode, ncons, elapsed, (gdouble) ncons * rounds / elapsed, bench_short_writes, bench_errors);
+}
+
+int main(int argc, char **argv) {
+	guint ncons = 10000, rounds = 100, i, r;
+	gsize body_size = 1024;
+	gchar *body;
+	bench_con *cons;
+	struct rlimit rlim;
+	liEventLoop loop;
+	liUring *uring;
+	liChunkFile *cf;
+	GError *err = NULL;
+	gdouble elapsed;
+	gchar file_tmpl[] = "/tmp/bench-network-write-XXXXXX";
+	int file_fd;
+
+	if (argc > 1) ncons = MAX(1, atoi(argv[1]));
+	if (argc > 2) body_size = MAX(0, atoi(argv[2]));
+	if (argc > 3) rounds = MAX(1, atoi(argv[3]));
+
+	if (0 == getrlimit(RLIMIT_NOFILE, &rlim)) {
+		rlim.rlim_cur = rlim.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rlim);
+	}
+
+	li_event_loop_init(&loop, ev_loop_new(EVFLAG_AUTO));
+
+	body = g_malloc(body_size + 1);
+	memset(body, 'x', body_size);
+
+	if (-1 == (file_fd = mkstemp(file_tmpl)) || (gssize) body_size != write(file_fd, body, body_size)) {
+		g_printerr("couldn't create body file: %s\n", g_strerror(errno));
+		return 1;
+	}
+	unlink(file_tmpl);
+	cf = li_chunkfile_new(NULL, file_fd, FALSE);
+
+	cons = g_new0(bench_con, ncons);
+	for (i = 0; i < ncons; i++) {
+		int fds[2];
+
+		if (-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+			g_printerr("socketpair failed after %u connections: %s\n", i, g_strerror(errno));
+			return 1;
+		}
+		li_fd_no_block(fds[0]);
+		li_fd_no_block(fds[1]);
+		cons[i].fd = fds[0];
+		cons[i].peer = fds[1];
+		cons[i].cq = li_chunkqueue_new();
+		cons[i].op.callback = bench_uring_done;
+	}
+
+	for (elapsed = 0, r = 0; r < rounds; r++) {
+		for (i = 0; i < ncons; i++) bench_fill(&cons[i], body, body_size);
+		elapsed += bench_writev_round(cons, ncons, NULL, body_size);
+		bench_drain(cons, ncons);
+		for (i = 0; i < ncons; i++) li_chunkqueue_reset(cons[i].cq);
+	}
+	bench_print("writev", ncons, rounds, elapsed);
+
+	bench_short_writes = bench_errors = 0;
+	for (elapsed = 0, r = 0; r < rounds; r++) {
+		for (i = 0; i < ncons; i++) bench_fill_file(&cons[i], cf, body_size);
+		elapsed += bench_writev_round(cons, ncons, NULL, body_size);
+		bench_drain(cons, ncons);
+		for (i = 0; i < ncons; i++) li_chunkqueue_reset(cons[i].cq);
+	}
+	bench_print("sendfile", ncons, rounds, elapsed);
+
+	bench_short_writes = bench_errors = 0;
+	for (elapsed = 0, r = 0; r < rounds; r++) {
+		elapsed += bench_writev_round(cons, ncons, cf, body_size);
+		bench_drain(cons, ncons);
+		for (i = 0; i < ncons; i++) li_chunkqueue_reset(cons[i].cq);
+	}
+	bench_print("inline", ncons, rounds, elapsed);
+
+	if (NULL == (uring = li_uring_new(&loop, LI_URING_DEFAULT_ENTRIES, &err))) {
+		g_print("%-9s skipped: %s\n", "io_uring", err->message);
+		g_error_free(err);
+	} else {
+		bench_short_writes = bench_errors = 0;
+		for (elapsed = 0, r = 0; r < rounds; r++) {
+			for (i = 0; i < ncons; i++) bench_fill(&cons[i], body, body_size);
+			elapsed += bench_uring_round(&loop, uring, cons, ncons);
+			bench_drain(cons, ncons);
+			for (i = 0; i < ncons; i++) li_chunkqueue_reset(cons[i].cq);
+		}
+		bench_print("io_uring", ncons, rounds, elapsed);
+		li_uring_free(uring);
+	}
+
+	for (i = 0; i < ncons; i++) {
+		close(cons[i].fd);
+		close(cons[i].peer);
+		li_chunkqueue_free(cons[i].cq);
+	}
+	g_free(cons);
+	g_free(body);
+	li_chunkfile_release(cf);
+
+	ev_loop_destroy(li_event_loop_clear(&loop));
+
+	return 0;
+}
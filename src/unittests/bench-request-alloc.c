@@ -0,0 +1,151 @@
+
+#include <lighttpd/base.h>
+
+/* request allocation benchmark: builds request and response headers like a keep-alive chain of
+ * requests does (insert, lookups, overwrite, remove, reset) with plain header lists and with arena
+ * backed header lists (as used for vrequests), and reports allocator calls and time per request.
+ *
+ * allocator calls are counted by wrapping malloc/calloc/realloc (glibc only); G_SLICE=always-malloc
+ * makes g_slice allocations visible too.
+ *
+ * usage: bench-request-alloc [requests]
+ */
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static guint64 bench_allocs = 0;
+
+void *malloc(size_t size) {
+	bench_allocs++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+	bench_allocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	bench_allocs++;
+	return __libc_realloc(ptr, size);
+}
+# define BENCH_COUNT_ALLOCS 1
+#else
+static guint64 bench_allocs = 0;
+# define BENCH_COUNT_ALLOCS 0
+#endif
+
+typedef struct {
+	const gchar *key, *value;
+} bench_header;
+
+static const bench_header bench_request_headers[] = {
+	{ "Host", "www.example.com" },
+	{ "User-Agent", "Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0" },
+	{ "Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8" },
+	{ "Accept-Language", "en-US,en;q=0.5" },
+	{ "Accept-Encoding", "gzip, deflate, br" },
+	{ "Referer", "https://www.example.com/index.html" },
+	{ "Connection", "keep-alive" },
+	{ "Cookie", "session=0123456789abcdef0123456789abcdef; theme=dark; lang=en" },
+	{ "Upgrade-Insecure-Requests", "1" },
+	{ "Sec-Fetch-Dest", "document" },
+	{ "Sec-Fetch-Mode", "navigate" },
+	{ "Sec-Fetch-Site", "same-origin" },
+	{ "Sec-Fetch-User", "?1" },
+	{ "If-Modified-Since", "Tue, 10 Oct 2023 10:00:00 GMT" },
+	{ "If-None-Match", "\"1234-5678-9abc\"" },
+	{ "Cache-Control", "max-age=0" },
+	{ "Pragma", "no-cache" },
+	{ "DNT", "1" },
+	{ "X-Forwarded-For", "192.0.2.1" },
+	{ "X-Requested-With", "XMLHttpRequest" },
+	{ NULL, NULL }
+};
+
+static void bench_one_request(liHttpHeaders *req, liHttpHeaders *resp, GString *tmp) {
+	const bench_header *bh;
+
+	/* parser */
+	for (bh = bench_request_headers; NULL != bh->key; bh++) {
+		li_http_header_insert(req, bh->key, strlen(bh->key), bh->value, strlen(bh->value));
+	}
+
+	/* request handling */
+	li_http_header_lookup(req, CONST_STR_LEN("host"));
+	li_http_header_lookup(req, CONST_STR_LEN("range"));
+	li_http_header_lookup(req, CONST_STR_LEN("if-none-match"));
+	li_http_header_lookup(req, CONST_STR_LEN("if-modified-since"));
+	li_http_header_get_all(tmp, req, CONST_STR_LEN("accept-encoding"));
+
+	li_http_header_overwrite(resp, CONST_STR_LEN("Content-Type"), CONST_STR_LEN("text/html; charset=utf-8"));
+	li_http_header_overwrite(resp, CONST_STR_LEN("Accept-Ranges"), CONST_STR_LEN("bytes"));
+	li_http_header_overwrite(resp, CONST_STR_LEN("ETag"), CONST_STR_LEN("\"1234-5678-9abc\""));
+	li_http_header_overwrite(resp, CONST_STR_LEN("Last-Modified"), CONST_STR_LEN("Tue, 10 Oct 2023 10:00:00 GMT"));
+	li_http_header_append(resp, CONST_STR_LEN("Vary"), CONST_STR_LEN("Accept-Encoding"));
+	li_http_header_insert(resp, CONST_STR_LEN("X-Powered-By"), CONST_STR_LEN("bench"));
+	li_http_header_remove(resp, CONST_STR_LEN("x-powered-by"));
+	li_http_header_overwrite(resp, CONST_STR_LEN("Content-Length"), CONST_STR_LEN("12345"));
+	li_http_header_overwrite(resp, CONST_STR_LEN("ETag"), CONST_STR_LEN("\"1234-5678-9abc-gzip\""));
+
+	/* li_vrequest_reset */
+	li_http_headers_reset(req);
+	li_http_headers_reset(resp);
+}
+
+static void bench(guint requests, gboolean arena) {
+	liHttpHeaders *req, *resp;
+	GString *tmp = g_string_sized_new(1023);
+	GTimer *timer;
+	guint64 allocs;
+	gdouble elapsed;
+	guint i;
+
+	if (arena) {
+		req = li_http_headers_new_with_arena(LI_HTTP_HEADERS_ARENA_BLOCK_SIZE);
+		resp = li_http_headers_new_with_arena(LI_HTTP_HEADERS_ARENA_BLOCK_SIZE);
+	} else {
+		req = li_http_headers_new();
+		resp = li_http_headers_new();
+	}
+
+	/* warm up: first request of a connection */
+	bench_one_request(req, resp, tmp);
+
+	allocs = bench_allocs;
+	timer = g_timer_new();
+	for (i = 0; i < requests; i++) {
+		bench_one_request(req, resp, tmp);
+	}
+	elapsed = g_timer_elapsed(timer, NULL);
+	allocs = bench_allocs - allocs;
+
+	if (BENCH_COUNT_ALLOCS) {
+		g_print("%-6s %8.1f allocations/request %8.0f ns/request\n",
+			arena ? "arena" : "plain", (gdouble) allocs / requests, elapsed * 1e9 / requests);
+	} else {
+		g_print("%-6s %8.0f ns/request\n", arena ? "arena" : "plain", elapsed * 1e9 / requests);
+	}
+
+	g_timer_destroy(timer);
+	li_http_headers_free(req);
+	li_http_headers_free(resp);
+	g_string_free(tmp, TRUE);
+}
+
+int main(int argc, char **argv) {
+	guint requests = 1000000;
+
+	/* must be set before the first g_slice allocation */
+	g_setenv("G_SLICE", "always-malloc", TRUE);
+
+	if (argc > 1) requests = MAX(1, atoi(argv[1]));
+
+	bench(requests, FALSE);
+	bench(requests, TRUE);
+
+	return 0;
+}
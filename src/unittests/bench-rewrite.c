@@ -0,0 +1,211 @@
+
+#include <lighttpd/base.h>
+
+/* rewrite rule matching benchmark: finding the first matching regex of a rule set, like mod_rewrite and
+ * vhost.map_regex do for each request.
+ *
+ * linear: li_regex_match for each rule in order until one matches (what mod_rewrite did before liRegexSet)
+ * set:    li_regex_set_match (literal prefilter, only candidates are matched)
+ *
+ * rule sets (with [rules] rules each):
+ * routes: REST style routes "^/api/v1/<name>/([0-9]+)$" and "^/api/v1/<name>/?$", a catch-all at the end
+ * mixed:  anchored prefixes, unanchored suffixes ("\.php$") and patterns without literal ("^/([a-z]+)/([0-9]+)$")
+ *
+ * paths hit rules spread over the whole set, 10% don't match any rule.
+ *
+ * engine: "pcre2" (default if available) or "glib"
+ *
+ * usage: bench-rewrite [rules] [lookups] [engine]
+ */
+
+typedef struct bench_rules bench_rules;
+struct bench_rules {
+	GPtrArray *regexes;
+	liRegexSet *set;
+	GPtrArray *paths;
+};
+
+static void bench_rules_add(bench_rules *br, const gchar *pattern) {
+	GError *err = NULL;
+	liRegex *regex = li_regex_new(pattern, &err);
+
+	if (NULL == regex) {
+		g_printerr("couldn't compile \"%s\": %s\n", pattern, err->message);
+		exit(1);
+	}
+	g_ptr_array_add(br->regexes, regex);
+}
+
+static void bench_rules_init(bench_rules *br) {
+	br->regexes = g_ptr_array_new_with_free_func((GDestroyNotify) li_regex_release);
+	br->paths = g_ptr_array_new_with_free_func(g_free);
+	br->set = NULL;
+}
+
+static void bench_rules_prepare(bench_rules *br) {
+	guint i;
+
+	br->set = li_regex_set_new();
+	for (i = 0; i < br->regexes->len; i++) {
+		li_regex_set_add(br->set, g_ptr_array_index(br->regexes, i));
+	}
+	li_regex_set_prepare(br->set);
+}
+
+static void bench_rules_clear(bench_rules *br) {
+	li_regex_set_free(br->set);
+	g_ptr_array_free(br->regexes, TRUE);
+	g_ptr_array_free(br->paths, TRUE);
+}
+
+static void bench_routes(bench_rules *br, guint rules) {
+	guint i;
+	gchar *pattern;
+
+	for (i = 0; i + 1 < rules; i += 2) {
+		pattern = g_strdup_printf("^/api/v1/resource%u/([0-9]+)$", i / 2);
+		bench_rules_add(br, pattern);
+		g_free(pattern);
+		pattern = g_strdup_printf("^/api/v1/resource%u/?$", i / 2);
+		bench_rules_add(br, pattern);
+		g_free(pattern);
+	}
+	bench_rules_add(br, "^/api/(.*)$");
+
+	for (i = 0; i < 100; i++) {
+		guint r = g_random_int_range(0, MAX(rules / 2, 1));
+
+		if (i % 10 == 9) {
+			g_ptr_array_add(br->paths, g_strdup_printf("/static/img/%u.png", r));
+		} else if (i % 2) {
+			g_ptr_array_add(br->paths, g_strdup_printf("/api/v1/resource%u/%u", r, g_random_int_range(1, 100000)));
+		} else {
+			g_ptr_array_add(br->paths, g_strdup_printf("/api/v1/resource%u/", r));
+		}
+	}
+}
+
+static void bench_mixed(bench_rules *br, guint rules) {
+	guint i;
+	gchar *pattern;
+
+	for (i = 0; i < rules; i++) {
+		switch (i % 4) {
+		case 0:
+			pattern = g_strdup_printf("^/section%u/article/([0-9]+)/([^/]+)$", i);
+			break;
+		case 1:
+			pattern = g_strdup_printf("^/(.*)/page%u\\.html$", i);
+			break;
+		case 2:
+			pattern = g_strdup_printf("^/download/file%u\\.(zip|tar\\.gz)$", i);
+			break;
+		default:
+			pattern = g_strdup_printf("^/([a-z]+)/item%u/([0-9]+)$", i);
+			break;
+		}
+		bench_rules_add(br, pattern);
+		g_free(pattern);
+	}
+	bench_rules_add(br, "^/([a-z]+)/([0-9]+)$");
+
+	for (i = 0; i < 100; i++) {
+		guint r = g_random_int_range(0, MAX(rules, 1));
+
+		if (i % 10 == 9) {
+			g_ptr_array_add(br->paths, g_strdup_printf("/nothing/here/%u", r));
+			continue;
+		}
+		switch (r % 4) {
+		case 0:
+			g_ptr_array_add(br->paths, g_strdup_printf("/section%u/article/%u/some-title", r, r * 7));
+			break;
+		case 1:
+			g_ptr_array_add(br->paths, g_strdup_printf("/docs/guide/page%u.html", r));
+			break;
+		case 2:
+			g_ptr_array_add(br->paths, g_strdup_printf("/download/file%u.zip", r));
+			break;
+		default:
+			g_ptr_array_add(br->paths, g_strdup_printf("/shop/item%u/%u", r, r * 3));
+			break;
+		}
+	}
+}
+
+static gint bench_linear_match(bench_rules *br, const gchar *path, liRegexMatch **match) {
+	guint i;
+
+	for (i = 0; i < br->regexes->len; i++) {
+		if (li_regex_match(g_ptr_array_index(br->regexes, i), path, match, NULL)) return i;
+	}
+
+	return -1;
+}
+
+static void bench_run(const gchar *name, bench_rules *br, guint lookups) {
+	GTimer *timer;
+	gdouble linear, set;
+	guint i, mismatches = 0, matched = 0;
+
+	timer = g_timer_new();
+	for (i = 0; i < lookups; i++) {
+		liRegexMatch *match = NULL;
+		if (bench_linear_match(br, g_ptr_array_index(br->paths, i % br->paths->len), &match) >= 0) matched++;
+		li_regex_match_free(match);
+	}
+	linear = g_timer_elapsed(timer, NULL);
+
+	g_timer_start(timer);
+	for (i = 0; i < lookups; i++) {
+		liRegexMatch *match = NULL;
+		li_regex_set_match(br->set, g_ptr_array_index(br->paths, i % br->paths->len), &match, NULL);
+		li_regex_match_free(match);
+	}
+	set = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	/* both have to find the same rules */
+	for (i = 0; i < br->paths->len; i++) {
+		const gchar *path = g_ptr_array_index(br->paths, i);
+		liRegexMatch *m1 = NULL, *m2 = NULL;
+		if (bench_linear_match(br, path, &m1) != li_regex_set_match(br->set, path, &m2, NULL)) mismatches++;
+		li_regex_match_free(m1);
+		li_regex_match_free(m2);
+	}
+
+	g_print("%-7s %4u rules: linear %8.3f s (%10.0f lookups/s), set %8.3f s (%10.0f lookups/s), %5.1fx, %u%% matched, %u mismatches\n",
+		name, br->regexes->len,
+		linear, lookups / linear, set, lookups / set, linear / set,
+		lookups ? matched * 100 / lookups : 0, mismatches);
+}
+
+int main(int argc, char **argv) {
+	guint rules = 400, lookups = 200000;
+	bench_rules br;
+
+	if (argc > 1) rules = MAX(2, atoi(argv[1]));
+	if (argc > 2) lookups = MAX(1, atoi(argv[2]));
+
+	if (argc > 3 && !li_regex_engine_set(g_str_equal(argv[3], "glib") ? LI_REGEX_ENGINE_GLIB : LI_REGEX_ENGINE_PCRE2)) {
+		g_printerr("regex engine \"%s\" not available\n", argv[3]);
+		return 1;
+	}
+	g_print("regex engine: %s\n", li_regex_engine_name(li_regex_engine_get()));
+
+	g_random_set_seed(42);
+
+	bench_rules_init(&br);
+	bench_routes(&br, rules);
+	bench_rules_prepare(&br);
+	bench_run("routes", &br, lookups);
+	bench_rules_clear(&br);
+
+	bench_rules_init(&br);
+	bench_mixed(&br, rules);
+	bench_rules_prepare(&br);
+	bench_run("mixed", &br, lookups);
+	bench_rules_clear(&br);
+
+	return 0;
+}
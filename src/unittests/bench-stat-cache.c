@@ -0,0 +1,164 @@
+
+#include <lighttpd/base.h>
+
+#include <fcntl.h>
+
+/* stat cache benchmark: compares the per-worker stat cache with the shared stat cache (stat_cache.shared)
+ * for a growing number of workers (threads).
+ *
+ * per-worker: each thread has its own hashtable of cached paths; like li_stat_cache_get (without fd) a hit
+ *             still does a stat() (the per-worker cache only keeps the stat() in the tasklet pool off the hot path).
+ * shared:     all threads use one liStatCacheShared; a hit copies the cached result, only misses stat().
+ *
+ * usage: bench-stat-cache [files] [max-threads] [seconds-per-run]
+ */
+
+#define BENCH_TTL 1.0
+
+typedef struct bench_run bench_run;
+typedef struct bench_thread bench_thread;
+
+struct bench_run {
+	GPtrArray *paths;
+	liStatCacheShared *shared; /* NULL: per-worker mode */
+	GTimer *timer;
+	gint stop;
+};
+
+struct bench_thread {
+	bench_run *run;
+	guint ndx;
+	guint64 lookups, stats;
+};
+
+static gpointer bench_thread_cb(gpointer data) {
+	bench_thread *t = data;
+	bench_run *run = t->run;
+	GHashTable *local = NULL;
+	guint i = t->ndx * 7919;
+	struct stat st;
+	int err;
+	gboolean failed;
+
+	if (NULL == run->shared) local = g_hash_table_new((GHashFunc) g_string_hash, (GEqualFunc) g_string_equal);
+
+	while (!g_atomic_int_get(&run->stop)) {
+		GString *path = g_ptr_array_index(run->paths, i++ % run->paths->len);
+		li_tstamp now = g_timer_elapsed(run->timer, NULL);
+
+		if (NULL != local) {
+			gdouble *ts = g_hash_table_lookup(local, path);
+			if (NULL == ts) {
+				ts = g_new(gdouble, 1);
+				g_hash_table_insert(local, path, ts);
+				*ts = now;
+			} else if (now - *ts >= BENCH_TTL) {
+				*ts = now;
+			}
+			/* hit or miss: per-worker cache stat()s */
+			stat(path->str, &st);
+			t->stats++;
+		} else if (!li_stat_cache_shared_lookup(run->shared, path, now, &st, &err, &failed)) {
+			failed = (-1 == stat(path->str, &st));
+			err = failed ? errno : 0;
+			li_stat_cache_shared_insert(run->shared, path, now, &st, err, failed);
+			t->stats++;
+		}
+
+		t->lookups++;
+	}
+
+	if (NULL != local) {
+		GHashTableIter iter;
+		gpointer v;
+		g_hash_table_iter_init(&iter, local);
+		while (g_hash_table_iter_next(&iter, NULL, &v)) g_free(v);
+		g_hash_table_destroy(local);
+	}
+
+	return NULL;
+}
+
+static void bench(GPtrArray *paths, guint nthreads, guint seconds, gboolean shared) {
+	bench_run run;
+	bench_thread *threads = g_new0(bench_thread, nthreads);
+	GThread **handles = g_new0(GThread*, nthreads);
+	guint64 lookups = 0, stats = 0;
+	gdouble elapsed;
+	guint i;
+
+	run.paths = paths;
+	run.shared = shared ? li_stat_cache_shared_new(paths->len * 2, BENCH_TTL) : NULL;
+	run.timer = g_timer_new();
+	run.stop = 0;
+
+	for (i = 0; i < nthreads; i++) {
+		threads[i].run = &run;
+		threads[i].ndx = i;
+		handles[i] = g_thread_create(bench_thread_cb, &threads[i], TRUE, NULL);
+	}
+
+	g_usleep((gulong) seconds * G_USEC_PER_SEC);
+	g_atomic_int_set(&run.stop, 1);
+
+	for (i = 0; i < nthreads; i++) {
+		g_thread_join(handles[i]);
+		lookups += threads[i].lookups;
+		stats += threads[i].stats;
+	}
+	elapsed = g_timer_elapsed(run.timer, NULL);
+
+	g_print("%-10s %3u workers: %12.0f lookups/s %12.0f stat()/s\n",
+		shared ? "shared" : "per-worker", nthreads, lookups / elapsed, stats / elapsed);
+
+	li_stat_cache_shared_free(run.shared);
+	g_timer_destroy(run.timer);
+	g_free(handles);
+	g_free(threads);
+}
+
+int main(int argc, char **argv) {
+	guint nfiles = 1000, max_threads = 16, seconds = 3, i, n;
+	GPtrArray *paths;
+	gchar dir[] = "/tmp/bench-stat-cache-XXXXXX";
+
+	if (argc > 1) nfiles = MAX(1, atoi(argv[1]));
+	if (argc > 2) max_threads = MAX(1, atoi(argv[2]));
+	if (argc > 3) seconds = MAX(1, atoi(argv[3]));
+
+	g_thread_init(NULL);
+
+	if (NULL == mkdtemp(dir)) {
+		g_printerr("mkdtemp failed: %s\n", g_strerror(errno));
+		return 1;
+	}
+
+	paths = g_ptr_array_new();
+	for (i = 0; i < nfiles; i++) {
+		GString *path = g_string_new(NULL);
+		int fd;
+
+		g_string_printf(path, "%s/file-%u", dir, i);
+		if (-1 == (fd = open(path->str, O_CREAT | O_WRONLY, 0644))) {
+			g_printerr("couldn't create '%s': %s\n", path->str, g_strerror(errno));
+			return 1;
+		}
+		close(fd);
+		g_ptr_array_add(paths, path);
+	}
+
+	for (n = 1; n <= max_threads; n *= 2) {
+		bench(paths, n, seconds, FALSE);
+		bench(paths, n, seconds, TRUE);
+	}
+
+	for (i = 0; i < paths->len; i++) {
+		GString *path = g_ptr_array_index(paths, i);
+		unlink(path->str);
+		g_string_free(path, TRUE);
+	}
+	g_ptr_array_free(paths, TRUE);
+	rmdir(dir);
+
+	return 0;
+}
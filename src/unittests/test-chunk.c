@@ -1,6 +1,8 @@
 
 #include <lighttpd/base.h>
 
+#include <sys/socket.h>
+
 #define perror(msg) g_error("(%s:%i) %s failed: %s", __FILE__, __LINE__, msg, g_strerror(errno))
 
 #if 0
@@ -50,10 +52,209 @@ static void test_filter_chunked_decode(void) {
 	li_chunkqueue_free(cq2);
 }
 
+static void test_chunkiter_gather_iovec(void) {
+	liChunkQueue *cq = li_chunkqueue_new();
+	liChunkFile *cf = li_chunkfile_new(NULL, -1, FALSE);
+	liChunkIter ci;
+	struct iovec iov[4];
+	goffset len;
+
+	li_chunkqueue_append_mem(cq, CONST_STR_LEN("abc"));
+	li_chunkqueue_append_string(cq, g_string_new("defg"));
+	li_chunkqueue_append_chunkfile(cq, cf, 0, 10);
+	li_chunkqueue_append_mem(cq, CONST_STR_LEN("xyz"));
+	li_chunkqueue_skip(cq, 1);
+
+	/* stops at the file chunk */
+	ci = li_chunkqueue_iter(cq);
+	g_assert_cmpuint(li_chunkiter_gather_iovec(&ci, iov, G_N_ELEMENTS(iov), cq->length, &len), ==, 2);
+	g_assert_cmpint(len, ==, 6);
+	g_assert(0 == memcmp(iov[0].iov_base, "bc", 2) && 2 == iov[0].iov_len);
+	g_assert(0 == memcmp(iov[1].iov_base, "defg", 4) && 4 == iov[1].iov_len);
+	g_assert(FILE_CHUNK == li_chunkiter_chunk(ci)->type);
+
+	/* max_length cuts the last chunk */
+	ci = li_chunkqueue_iter(cq);
+	g_assert_cmpuint(li_chunkiter_gather_iovec(&ci, iov, G_N_ELEMENTS(iov), 3, &len), ==, 2);
+	g_assert_cmpint(len, ==, 3);
+	g_assert_cmpuint(iov[1].iov_len, ==, 1);
+
+	/* iov_max */
+	ci = li_chunkqueue_iter(cq);
+	g_assert_cmpuint(li_chunkiter_gather_iovec(&ci, iov, 1, cq->length, &len), ==, 1);
+	g_assert_cmpint(len, ==, 2);
+	g_assert(STRING_CHUNK == li_chunkiter_chunk(ci)->type);
+
+	/* nothing to gather at a file chunk */
+	li_chunkqueue_skip(cq, 6);
+	ci = li_chunkqueue_iter(cq);
+	g_assert_cmpuint(li_chunkiter_gather_iovec(&ci, iov, G_N_ELEMENTS(iov), cq->length, &len), ==, 0);
+	g_assert_cmpint(len, ==, 0);
+
+	li_chunkqueue_free(cq);
+	li_chunkfile_release(cf);
+}
+
+static void test_chunkqueue_pipe(void) {
+	liChunkQueue *cq, *cq2;
+	liChunkPipe *cp;
+	int fds[2];
+	char buf[16];
+	ssize_t r;
+
+	if (NULL == (cp = li_chunkpipe_new())) return; /* no splice() */
+	if (-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) perror("socketpair");
+
+	cq = li_chunkqueue_new();
+	cq2 = li_chunkqueue_new();
+
+	g_assert_cmpint(10, ==, write(cp->fd_write, "0123456789", 10));
+	li_chunkqueue_append_pipe(cq, cp, 4);
+	li_chunkqueue_append_pipe(cq, cp, 6);
+	li_chunkpipe_release(cp);
+	g_assert_cmpuint(1, ==, cq->queue.length); /* contiguous data is merged */
+	g_assert_cmpint(10, ==, cq->length);
+	g_assert_cmpint(10, ==, cq->mem_usage);
+
+	/* split and skip: the skipped data is dropped from the pipe when sending "56789" */
+	g_assert_cmpint(3, ==, li_chunkqueue_steal_len(cq2, cq, 3));
+	g_assert_cmpint(2, ==, li_chunkqueue_skip(cq, 2));
+
+	g_assert(LI_NETWORK_STATUS_SUCCESS == li_network_write(fds[0], cq2, 1024, NULL, NULL));
+	g_assert(LI_NETWORK_STATUS_SUCCESS == li_network_write(fds[0], cq, 1024, NULL, NULL));
+	g_assert_cmpint(0, ==, cq->length);
+	g_assert_cmpint(0, ==, cq->mem_usage);
+
+	r = read(fds[1], buf, sizeof(buf));
+	g_assert_cmpint(8, ==, r);
+	g_assert(0 == memcmp(buf, "01256789", 8));
+
+	li_chunkqueue_free(cq);
+	li_chunkqueue_free(cq2);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void test_network_read(void) {
+	liChunkQueue *cq;
+	liNetworkReadState state;
+	int fds[2];
+
+	if (-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) perror("socketpair");
+	li_fd_no_block(fds[1]);
+
+	cq = li_chunkqueue_new();
+	memset(&state, 0, sizeof(state));
+
+	/* a short read drains the socket: no second read() just to get EAGAIN */
+	g_assert_cmpint(10, ==, write(fds[0], "0123456789", 10));
+	g_assert(LI_NETWORK_STATUS_WAIT_FOR_EVENT == li_network_read(fds[1], cq, 256*1024, NULL, NULL, &state, NULL));
+	g_assert_cmpint(10, ==, cq->length);
+	g_assert_cmpuint(1, ==, state.syscalls);
+
+	/* read_max reached: there might be more */
+	g_assert_cmpint(10, ==, write(fds[0], "abcdefghij", 10));
+	g_assert(LI_NETWORK_STATUS_SUCCESS == li_network_read(fds[1], cq, 4, NULL, NULL, &state, NULL));
+	g_assert_cmpint(14, ==, cq->length);
+	g_assert_cmpuint(2, ==, state.syscalls);
+
+	g_assert(LI_NETWORK_STATUS_WAIT_FOR_EVENT == li_network_read(fds[1], cq, 256*1024, NULL, NULL, &state, NULL));
+	g_assert_cmpint(20, ==, cq->length);
+	g_assert_cmpuint(3, ==, state.syscalls);
+	cq_assert_eq(cq, CONST_STR_LEN("0123456789abcdefghij"));
+
+	g_assert(LI_NETWORK_STATUS_WAIT_FOR_EVENT == li_network_read(fds[1], cq, 256*1024, NULL, NULL, &state, NULL));
+	close(fds[0]);
+	g_assert(LI_NETWORK_STATUS_CONNECTION_CLOSE == li_network_read(fds[1], cq, 256*1024, NULL, NULL, &state, NULL));
+
+	li_chunkqueue_free(cq);
+	close(fds[1]);
+}
+
+static gboolean async_read_woken;
+
+static void async_read_wakeup_cb(liJob *job) {
+	UNUSED(job);
+	async_read_woken = TRUE;
+}
+
+static void test_chunkiter_read_async(void) {
+	liEventLoop loop;
+	liTaskletPool *pool;
+	liJob job;
+	liJobRef *wakeup;
+	liChunkQueue *cq;
+	liChunkFile *cf;
+	liChunkIter ci;
+	gchar tmpl[] = "/tmp/test-chunk-XXXXXX";
+	char *data;
+	off_t len;
+	int fd, i;
+
+	li_event_loop_init(&loop, ev_loop_new(EVFLAG_AUTO));
+	pool = li_tasklet_pool_new(&loop, 0);
+	li_job_init(&job, async_read_wakeup_cb);
+	wakeup = li_job_ref(&loop.jobqueue, &job);
+
+	if (-1 == (fd = mkstemp(tmpl))) perror("mkstemp");
+	unlink(tmpl);
+	g_assert_cmpint(10, ==, write(fd, "0123456789", 10));
+	cf = li_chunkfile_new(NULL, fd, FALSE);
+
+	cq = li_chunkqueue_new();
+	li_chunkqueue_append_mem(cq, CONST_STR_LEN("ab"));
+	li_chunkqueue_append_chunkfile(cq, cf, 2, 6);
+
+	/* memory is returned directly */
+	ci = li_chunkqueue_iter(cq);
+	g_assert(LI_HANDLER_GO_ON == li_chunkiter_read_async(ci, 0, 10, &data, &len, pool, wakeup, NULL));
+	g_assert_cmpint(2, ==, len);
+	li_chunkqueue_skip(cq, 3);
+
+	/* file data is loaded in the background */
+	async_read_woken = FALSE;
+	ci = li_chunkqueue_iter(cq);
+	g_assert(LI_HANDLER_WAIT_FOR_EVENT == li_chunkiter_read_async(ci, 0, 10, &data, &len, pool, wakeup, NULL));
+	g_assert(LI_HANDLER_WAIT_FOR_EVENT == li_chunkiter_read_async(ci, 0, 10, &data, &len, pool, wakeup, NULL));
+	for (i = 0; i < 100 && !async_read_woken; i++) ev_run(loop.loop, EVRUN_NOWAIT);
+	g_assert(async_read_woken);
+
+	g_assert(LI_HANDLER_GO_ON == li_chunkiter_read_async(ci, 0, 10, &data, &len, pool, wakeup, NULL));
+	g_assert_cmpint(5, ==, len);
+	g_assert(0 == memcmp(data, "34567", 5));
+
+	/* li_chunkiter_read uses the loaded data too */
+	li_chunkqueue_skip(cq, 1);
+	ci = li_chunkqueue_iter(cq);
+	g_assert(LI_HANDLER_GO_ON == li_chunkiter_read(ci, 0, 10, &data, &len, NULL));
+	g_assert_cmpint(4, ==, len);
+	g_assert(0 == memcmp(data, "4567", 4));
+
+	/* chunk freed while reading */
+	async_read_woken = FALSE;
+	li_chunkqueue_reset(cq);
+	li_chunkqueue_append_chunkfile(cq, cf, 0, 10);
+	ci = li_chunkqueue_iter(cq);
+	g_assert(LI_HANDLER_WAIT_FOR_EVENT == li_chunkiter_read_async(ci, 0, 10, &data, &len, pool, wakeup, NULL));
+	li_chunkqueue_free(cq);
+	li_chunkfile_release(cf);
+	for (i = 0; i < 10; i++) ev_run(loop.loop, EVRUN_NOWAIT);
+	g_assert(!async_read_woken);
+
+	li_job_ref_release(wakeup);
+	li_job_clear(&job);
+	li_tasklet_pool_free(pool);
+	ev_loop_destroy(li_event_loop_clear(&loop));
+}
+
 int main(int argc, char **argv) {
 	g_test_init(&argc, &argv, NULL);
 
 	g_test_add_func("/chunk/filter_chunked_decode", test_filter_chunked_decode);
+	g_test_add_func("/chunk/chunkiter_gather_iovec", test_chunkiter_gather_iovec);
+	g_test_add_func("/chunk/chunkqueue_pipe", test_chunkqueue_pipe);
+	g_test_add_func("/chunk/network_read", test_network_read);
+	g_test_add_func("/chunk/chunkiter_read_async", test_chunkiter_read_async);
 
 	return g_test_run();
 }
@@ -0,0 +1,223 @@
+
+#include <lighttpd/base.h>
+
+/* li_condition_switch_match must find the same entry as checking the conditions in order */
+
+static gboolean linear_match(liCompOperator op, const gchar *val, const gchar *rule) {
+	switch (op) {
+	case LI_CONFIG_COND_EQ: return g_str_equal(val, rule);
+	case LI_CONFIG_COND_PREFIX: return g_str_has_prefix(val, rule);
+	case LI_CONFIG_COND_SUFFIX: return g_str_has_suffix(val, rule);
+	default: g_assert_not_reached();
+	}
+	return FALSE;
+}
+
+static guint linear_first(liCompOperator op, const gchar *val, const gchar * const *rules, guint n) {
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		if (linear_match(op, val, rules[i])) return i;
+	}
+
+	return G_MAXUINT;
+}
+
+static void check_value(liConditionSwitch *sw, liCompOperator op, const gchar *val, const gchar * const *rules, guint n) {
+	guint expected = linear_first(op, val, rules, n), got = li_condition_switch_match(sw, val, strlen(val));
+
+	if (expected != got) {
+		g_error("%s '%s': switch found entry %i, linear evaluation %i", li_comp_op_to_string(op), val, (gint) got, (gint) expected);
+	}
+}
+
+static liConditionSwitch* switch_new(liCompOperator op, const gchar * const *rules, guint n) {
+	liConditionLValue *lvalue = li_condition_lvalue_new(LI_COMP_REQUEST_PATH, NULL);
+	liConditionSwitch *sw = NULL;
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		liCondition *cond;
+
+		li_condition_lvalue_acquire(lvalue);
+		cond = li_condition_new_string(NULL, op, lvalue, g_string_new(rules[i]));
+		g_assert(NULL != cond);
+
+		if (NULL == sw) {
+			sw = li_condition_switch_new(cond);
+			g_assert(NULL != sw);
+		} else {
+			g_assert(li_condition_switch_add(sw, cond));
+		}
+
+		li_condition_release(NULL, cond);
+	}
+
+	li_condition_lvalue_release(lvalue);
+	g_assert_cmpuint(n, ==, li_condition_switch_count(sw));
+
+	return sw;
+}
+
+/* checks the rules themselves and values around them, plus the given values */
+static void check_rules(liCompOperator op, const gchar * const *rules, guint n, const gchar * const *values) {
+	liConditionSwitch *sw = switch_new(op, rules, n);
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		gsize len = strlen(rules[i]);
+		gchar *s;
+
+		check_value(sw, op, rules[i], rules, n);
+
+		s = g_strconcat(rules[i], "x", NULL);
+		check_value(sw, op, s, rules, n);
+		g_free(s);
+
+		s = g_strconcat("x", rules[i], NULL);
+		check_value(sw, op, s, rules, n);
+		g_free(s);
+
+		if (len > 0) {
+			s = g_strndup(rules[i], len - 1);
+			check_value(sw, op, s, rules, n);
+			g_free(s);
+
+			check_value(sw, op, rules[i] + 1, rules, n);
+		}
+	}
+
+	for (; NULL != values && NULL != *values; values++) {
+		check_value(sw, op, *values, rules, n);
+	}
+
+	li_condition_switch_free(sw);
+}
+
+#define CHECK_RULES(op, rules, values) check_rules(op, rules, G_N_ELEMENTS(rules), values)
+
+static const gchar * const path_values[] = {
+	"", "/", "/a", "/a/", "/a/b", "/a/b/", "/a/b/c", "/a/b/c/", "/a/b/c/d", "/ab", "/b/a", "a", "x", NULL
+};
+
+static void test_prefix(void) {
+	static const gchar * const longest_first[] = { "/a/b/c/", "/a/b/", "/a/", "/" };
+	static const gchar * const shortest_first[] = { "/", "/a/", "/a/b/", "/a/b/c/" };
+	static const gchar * const mixed[] = { "/a/b/c", "/x", "/a", "/a/b", "/a", "/a/b/c/d", "/ab", "/b" };
+	static const gchar * const shorter_later[] = { "/a/b/c/d", "/a/b", "/a/b/c", "/a", "/a/b/c/d/e" };
+	static const gchar * const empty_middle[] = { "/a/b", "/x", "", "/a", "/y" };
+	static const gchar * const empty_first[] = { "", "/a", "/a/b", "/b" };
+	static const gchar * const empty_last[] = { "/a/b", "/a", "/b", "" };
+	static const gchar * const one[] = { "/a" };
+	static const gchar * const two[] = { "/a/b", "/a" };
+	static const gchar * const three[] = { "/a", "", "/a/b" };
+
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, longest_first, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, shortest_first, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, mixed, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, shorter_later, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, empty_middle, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, empty_first, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, empty_last, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, one, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, two, path_values);
+	CHECK_RULES(LI_CONFIG_COND_PREFIX, three, path_values);
+}
+
+static void test_suffix(void) {
+	static const gchar * const longest_first[] = { "x.tar.gz", ".tar.gz", ".gz", "z" };
+	static const gchar * const shortest_first[] = { "z", ".gz", ".tar.gz", "x.tar.gz" };
+	static const gchar * const mixed[] = { ".php", ".html", "x.php", ".php", "index.html", "", ".htm" };
+	static const gchar * const one[] = { ".php" };
+	static const gchar * const two[] = { "", ".php" };
+	static const gchar * const values[] = { "", "/index.php", "/x.php", "/index.html", "/a.htm", "/a.tar.gz", "/a.gz", "gz", NULL };
+
+	CHECK_RULES(LI_CONFIG_COND_SUFFIX, longest_first, values);
+	CHECK_RULES(LI_CONFIG_COND_SUFFIX, shortest_first, values);
+	CHECK_RULES(LI_CONFIG_COND_SUFFIX, mixed, values);
+	CHECK_RULES(LI_CONFIG_COND_SUFFIX, one, values);
+	CHECK_RULES(LI_CONFIG_COND_SUFFIX, two, values);
+}
+
+static void test_eq(void) {
+	static const gchar * const duplicates[] = { "/a", "/b", "/a", "", "/b", "/c" };
+	static const gchar * const one[] = { "" };
+
+	CHECK_RULES(LI_CONFIG_COND_EQ, duplicates, path_values);
+	CHECK_RULES(LI_CONFIG_COND_EQ, one, path_values);
+}
+
+/* random rules and values over a small alphabet, so there are many prefixes/suffixes of each other */
+static gchar* random_string(guint max_len) {
+	static const gchar alphabet[] = "ab/";
+	guint i, len = g_test_rand_int_range(0, max_len + 1);
+	gchar *s = g_malloc(len + 1);
+
+	for (i = 0; i < len; i++) s[i] = alphabet[g_test_rand_int_range(0, sizeof(alphabet) - 1)];
+	s[len] = '\0';
+
+	return s;
+}
+
+static void test_random_op(liCompOperator op) {
+	guint round, i;
+
+	for (round = 0; round < 50; round++) {
+		guint n = g_test_rand_int_range(1, 40);
+		gchar **rules = g_new0(gchar*, n + 1);
+		liConditionSwitch *sw;
+
+		for (i = 0; i < n; i++) rules[i] = random_string(5);
+		sw = switch_new(op, (const gchar * const *) rules, n);
+
+		for (i = 0; i < 200; i++) {
+			gchar *val = random_string(7);
+			check_value(sw, op, val, (const gchar * const *) rules, n);
+			g_free(val);
+		}
+
+		li_condition_switch_free(sw);
+		g_strfreev(rules);
+	}
+}
+
+static void test_random(void) {
+	test_random_op(LI_CONFIG_COND_EQ);
+	test_random_op(LI_CONFIG_COND_PREFIX);
+	test_random_op(LI_CONFIG_COND_SUFFIX);
+}
+
+static void test_fits(void) {
+	liConditionLValue *path = li_condition_lvalue_new(LI_COMP_REQUEST_PATH, NULL);
+	liConditionLValue *host = li_condition_lvalue_new(LI_COMP_REQUEST_HOST, NULL);
+	liCondition *first, *other_op, *other_lvalue;
+	liConditionSwitch *sw;
+
+	li_condition_lvalue_acquire(path);
+	first = li_condition_new_string(NULL, LI_CONFIG_COND_PREFIX, path, g_string_new("/a"));
+	other_op = li_condition_new_string(NULL, LI_CONFIG_COND_SUFFIX, path, g_string_new("/a"));
+	other_lvalue = li_condition_new_string(NULL, LI_CONFIG_COND_PREFIX, host, g_string_new("/a"));
+
+	sw = li_condition_switch_new(first);
+	g_assert(NULL != sw);
+	g_assert(!li_condition_switch_add(sw, other_op));
+	g_assert(!li_condition_switch_add(sw, other_lvalue));
+	g_assert_cmpuint(1, ==, li_condition_switch_count(sw));
+	li_condition_switch_free(sw);
+
+	li_condition_release(NULL, first);
+	li_condition_release(NULL, other_op);
+	li_condition_release(NULL, other_lvalue);
+}
+
+int main(int argc, char **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/condition-switch/prefix", test_prefix);
+	g_test_add_func("/condition-switch/suffix", test_suffix);
+	g_test_add_func("/condition-switch/eq", test_eq);
+	g_test_add_func("/condition-switch/random", test_random);
+	g_test_add_func("/condition-switch/fits", test_fits);
+
+	return g_test_run();
+}
@@ -0,0 +1,143 @@
+
+#include <lighttpd/base.h>
+
+static void test_header_id(void) {
+	g_assert_cmpint(li_http_header_id(CONST_STR_LEN("Content-Length")), ==, LI_HTTP_HEADER_CONTENT_LENGTH);
+	g_assert_cmpint(li_http_header_id(CONST_STR_LEN("content-length")), ==, LI_HTTP_HEADER_CONTENT_LENGTH);
+	g_assert_cmpint(li_http_header_id(CONST_STR_LEN("HOST")), ==, LI_HTTP_HEADER_HOST);
+	g_assert_cmpint(li_http_header_id(CONST_STR_LEN("X-Custom")), ==, LI_HTTP_HEADER_OTHER);
+	g_assert_cmpint(li_http_header_id(CONST_STR_LEN("Hos")), ==, LI_HTTP_HEADER_OTHER);
+}
+
+static void test_lookup(void) {
+	liHttpHeaders *headers = li_http_headers_new();
+	liHttpHeader *h;
+
+	li_http_header_insert(headers, CONST_STR_LEN("Host"), CONST_STR_LEN("example.com"));
+	li_http_header_insert(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("a"));
+	li_http_header_insert(headers, CONST_STR_LEN("x-custom"), CONST_STR_LEN("b"));
+
+	h = li_http_header_lookup(headers, CONST_STR_LEN("host"));
+	g_assert(NULL != h);
+	g_assert_cmpstr(LI_HEADER_VALUE(h), ==, "example.com");
+	g_assert_cmpint(h->id, ==, LI_HTTP_HEADER_HOST);
+
+	h = li_http_header_lookup(headers, CONST_STR_LEN("X-CUSTOM"));
+	g_assert(NULL != h);
+	g_assert_cmpstr(LI_HEADER_VALUE(h), ==, "b");
+
+	g_assert(NULL == li_http_header_lookup(headers, CONST_STR_LEN("Content-Type")));
+	g_assert(NULL == li_http_header_lookup(headers, CONST_STR_LEN("X-Other")));
+
+	li_http_headers_free(headers);
+}
+
+static void test_duplicates(void) {
+	liHttpHeaders *headers = li_http_headers_new();
+	GString *all = g_string_sized_new(0);
+
+	li_http_header_insert(headers, CONST_STR_LEN("Vary"), CONST_STR_LEN("1"));
+	li_http_header_insert(headers, CONST_STR_LEN("Host"), CONST_STR_LEN("example.com"));
+	li_http_header_insert(headers, CONST_STR_LEN("vary"), CONST_STR_LEN("2"));
+	li_http_header_insert(headers, CONST_STR_LEN("VARY"), CONST_STR_LEN("3"));
+
+	li_http_header_get_all(all, headers, CONST_STR_LEN("vary"));
+	g_assert_cmpstr(all->str, ==, "1, 2, 3");
+
+	/* remove first and last entry: index must follow */
+	li_http_header_remove_link(headers, li_http_header_find_first(headers, CONST_STR_LEN("vary")));
+	g_assert_cmpstr(LI_HEADER_VALUE((liHttpHeader*) li_http_header_find_first(headers, CONST_STR_LEN("vary"))->data), ==, "2");
+
+	li_http_header_remove_link(headers, li_http_header_find_last(headers, CONST_STR_LEN("vary")));
+	g_assert_cmpstr(LI_HEADER_VALUE(li_http_header_lookup(headers, CONST_STR_LEN("vary"))), ==, "2");
+
+	li_http_header_overwrite(headers, CONST_STR_LEN("Vary"), CONST_STR_LEN("4"));
+	li_http_header_append(headers, CONST_STR_LEN("Vary"), CONST_STR_LEN("5"));
+	li_http_header_get_all(all, headers, CONST_STR_LEN("vary"));
+	g_assert_cmpstr(all->str, ==, "4, 5");
+
+	g_assert(li_http_header_remove(headers, CONST_STR_LEN("vary")));
+	g_assert(NULL == li_http_header_find_first(headers, CONST_STR_LEN("vary")));
+	g_assert(NULL == li_http_header_find_last(headers, CONST_STR_LEN("vary")));
+	g_assert(NULL != li_http_header_lookup(headers, CONST_STR_LEN("host")));
+
+	li_http_headers_reset(headers);
+	g_assert(NULL == li_http_header_lookup(headers, CONST_STR_LEN("host")));
+
+	li_http_header_insert(headers, CONST_STR_LEN("Host"), CONST_STR_LEN("example.org"));
+	g_assert_cmpstr(LI_HEADER_VALUE(li_http_header_lookup(headers, CONST_STR_LEN("host"))), ==, "example.org");
+
+	g_string_free(all, TRUE);
+	li_http_headers_free(headers);
+}
+
+static void test_arena(void) {
+	liHttpHeaders *headers = li_http_headers_new_with_arena(256);
+	GString *all = g_string_sized_new(0);
+	guint i, round;
+
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < 50; i++) {
+			li_http_header_append(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("abcdefgh"));
+			li_http_header_insert(headers, CONST_STR_LEN("Vary"), CONST_STR_LEN("x"));
+		}
+
+		li_http_header_get_all(all, headers, CONST_STR_LEN("x-custom"));
+		g_assert_cmpuint(all->len, ==, 50 * 8 + 49 * 2);
+
+		li_http_header_overwrite(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("short"));
+		g_assert_cmpstr(LI_HEADER_VALUE(li_http_header_lookup(headers, CONST_STR_LEN("x-custom"))), ==, "short");
+
+		g_assert(li_http_header_remove(headers, CONST_STR_LEN("vary")));
+		g_assert(NULL == li_http_header_lookup(headers, CONST_STR_LEN("vary")));
+		g_assert_cmpuint(headers->entries.length, ==, 1);
+
+		li_http_headers_reset(headers);
+		g_assert_cmpuint(headers->entries.length, ==, 0);
+	}
+
+	g_string_free(all, TRUE);
+	li_http_headers_free(headers);
+}
+
+static void test_version(void) {
+	liHttpHeaders *headers = li_http_headers_new();
+	guint version = headers->version;
+
+	/* lookups don't change the list */
+	g_assert(NULL == li_http_header_lookup(headers, CONST_STR_LEN("x-custom")));
+	g_assert_cmpuint(headers->version, ==, version);
+
+	li_http_header_insert(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("a"));
+	g_assert_cmpuint(headers->version, !=, version);
+	version = headers->version;
+
+	li_http_header_append(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("b"));
+	g_assert_cmpuint(headers->version, !=, version);
+	version = headers->version;
+
+	li_http_header_overwrite(headers, CONST_STR_LEN("X-Custom"), CONST_STR_LEN("c"));
+	g_assert_cmpuint(headers->version, !=, version);
+	version = headers->version;
+
+	g_assert(li_http_header_remove(headers, CONST_STR_LEN("x-custom")));
+	g_assert_cmpuint(headers->version, !=, version);
+	version = headers->version;
+
+	li_http_headers_reset(headers);
+	g_assert_cmpuint(headers->version, !=, version);
+
+	li_http_headers_free(headers);
+}
+
+int main(int argc, char **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/http-headers/id", test_header_id);
+	g_test_add_func("/http-headers/lookup", test_lookup);
+	g_test_add_func("/http-headers/duplicates", test_duplicates);
+	g_test_add_func("/http-headers/arena", test_arena);
+	g_test_add_func("/http-headers/version", test_version);
+
+	return g_test_run();
+}
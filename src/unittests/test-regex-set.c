@@ -0,0 +1,126 @@
+
+#include <lighttpd/regex_set.h>
+
+static void test_literal(const gchar *pattern, const gchar *expected, gboolean expected_anchored) {
+	GString *literal = g_string_sized_new(0);
+	gboolean anchored;
+
+	if (NULL == expected) {
+		g_assert(!li_regex_literal(pattern, literal, &anchored));
+	} else {
+		g_assert(li_regex_literal(pattern, literal, &anchored));
+		g_assert_cmpstr(literal->str, ==, expected);
+		g_assert_cmpint(anchored, ==, expected_anchored);
+	}
+
+	g_string_free(literal, TRUE);
+}
+
+static void test_regex_literal(void) {
+	test_literal("^/api/v1/users/([0-9]+)$", "/api/v1/users/", TRUE);
+	test_literal("^/blog/(\\d+)/(.*)$", "/blog/", TRUE);
+	test_literal("\\.php$", ".php", FALSE);
+	test_literal("^/(.*)/index\\.php$", "/index.php", FALSE);
+	test_literal("^/images?/(.*)", "/image", TRUE);
+	test_literal("^/fo+bar", "/fo", TRUE);
+	test_literal("^(www\\.)?example\\.(com|org)$", "example.", FALSE);
+	test_literal("^/[a-z]+/edit$", "/edit", FALSE);
+	test_literal("a{2,3}bc", "bc", FALSE);
+
+	/* nothing usable */
+	test_literal("^(.*)$", NULL, FALSE);
+	test_literal("^/foo|^/bar", NULL, FALSE);
+	test_literal("(?i)^/foo", NULL, FALSE);
+	test_literal("^/(a)\\1", NULL, FALSE);
+	test_literal("\\x41bc", NULL, FALSE);
+	test_literal("\\Q.*\\E", NULL, FALSE);
+}
+
+static const gchar* regex_set_patterns[] = {
+	"^/api/v1/users/([0-9]+)$",
+	"^/api/v1/(.*)$",
+	"\\.php$",
+	"^/(.*)/index\\.html$",
+	"(?i)^/Download/(.*)",
+	"^/static/",
+	"^(.*)$",
+	NULL
+};
+
+static const gchar* regex_set_subjects[] = {
+	"/api/v1/users/42",
+	"/api/v1/users/x",
+	"/api/v2/users/42",
+	"/test.php",
+	"/docs/index.html",
+	"/download/file",
+	"/static/style.css",
+	"/api/v1/",
+	"",
+	NULL
+};
+
+static void test_regex_set_match(void) {
+	GPtrArray *regexes = g_ptr_array_new_with_free_func((GDestroyNotify) li_regex_release);
+	liRegexSet *set = li_regex_set_new();
+	guint i, j;
+
+	for (i = 0; NULL != regex_set_patterns[i]; i++) {
+		liRegex *regex = li_regex_new(regex_set_patterns[i], NULL);
+		g_assert(NULL != regex);
+		g_ptr_array_add(regexes, regex);
+		li_regex_set_add(set, regex);
+	}
+	li_regex_set_prepare(set);
+
+	/* same result as trying each regex in order */
+	for (j = 0; NULL != regex_set_subjects[j]; j++) {
+		const gchar *subject = regex_set_subjects[j];
+		liRegexMatch *match = NULL;
+		gint expected = -1, ndx;
+
+		for (i = 0; i < regexes->len; i++) {
+			if (li_regex_match(g_ptr_array_index(regexes, i), subject, NULL, NULL)) {
+				expected = i;
+				break;
+			}
+		}
+
+		ndx = li_regex_set_match(set, subject, &match, NULL);
+		g_assert_cmpint(ndx, ==, expected);
+		g_assert(NULL != match);
+		g_assert(li_regex_match_get_string(match) == subject);
+		li_regex_match_free(match);
+	}
+
+	li_regex_set_free(set);
+	g_ptr_array_free(regexes, TRUE);
+}
+
+static void test_regex_set_nomatch(void) {
+	liRegex *regex1 = li_regex_new("^/a/", NULL), *regex2 = li_regex_new("b$", NULL);
+	liRegexSet *set = li_regex_set_new();
+
+	li_regex_set_add(set, regex1);
+	li_regex_set_add(set, regex2);
+	li_regex_set_prepare(set);
+
+	g_assert_cmpint(li_regex_set_match(set, "/x/a/", NULL, NULL), ==, -1);
+	g_assert_cmpint(li_regex_set_match(set, "/a/b", NULL, NULL), ==, 0);
+	g_assert_cmpint(li_regex_set_match(set, "/x/b", NULL, NULL), ==, 1);
+	g_assert_cmpint(li_regex_set_match(set, "", NULL, NULL), ==, -1);
+
+	li_regex_set_free(set);
+	li_regex_release(regex1);
+	li_regex_release(regex2);
+}
+
+int main(int argc, char **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/regex-set/literal", test_regex_literal);
+	g_test_add_func("/regex-set/match", test_regex_set_match);
+	g_test_add_func("/regex-set/nomatch", test_regex_set_nomatch);
+
+	return g_test_run();
+}
@@ -0,0 +1,108 @@
+
+#include <lighttpd/regex.h>
+
+static void test_captures(liRegexEngine engine) {
+	liRegex *regex;
+	liRegexMatch *match = NULL;
+	const gchar *subject = "/blog/2024/hello";
+	gint start, end;
+
+	g_assert(li_regex_engine_set(engine));
+	regex = li_regex_new("^/blog/([0-9]+)/([a-z]+)(\\.html)?$", NULL);
+	g_assert(NULL != regex);
+	g_assert_cmpint(li_regex_get_engine(regex), ==, engine);
+	g_assert_cmpstr(li_regex_get_pattern(regex), ==, "^/blog/([0-9]+)/([a-z]+)(\\.html)?$");
+
+	g_assert(li_regex_match(regex, subject, &match, NULL));
+	g_assert(NULL != match);
+	g_assert(li_regex_match_get_string(match) == subject);
+
+	g_assert(li_regex_match_fetch_pos(match, 0, &start, &end));
+	g_assert_cmpint(start, ==, 0);
+	g_assert_cmpint(end, ==, 16);
+	g_assert(li_regex_match_fetch_pos(match, 1, &start, &end));
+	g_assert_cmpint(start, ==, 6);
+	g_assert_cmpint(end, ==, 10);
+	g_assert(li_regex_match_fetch_pos(match, 2, &start, &end));
+	g_assert_cmpint(start, ==, 11);
+	g_assert_cmpint(end, ==, 16);
+	/* optional group didn't match, group 4 doesn't exist */
+	g_assert(!li_regex_match_fetch_pos(match, 3, &start, &end));
+	g_assert(!li_regex_match_fetch_pos(match, 4, &start, &end));
+	li_regex_match_free(match);
+
+	/* no match: match isn't set */
+	match = GUINT_TO_POINTER(1);
+	g_assert(!li_regex_match(regex, "/blog/x/hello", &match, NULL));
+	g_assert(NULL == match);
+	g_assert(li_regex_match(regex, "/blog/1/a.html", NULL, NULL));
+
+	li_regex_release(regex);
+}
+
+static void test_regex_glib(void) {
+	test_captures(LI_REGEX_ENGINE_GLIB);
+}
+
+static void test_regex_pcre2(void) {
+	if (!li_regex_engine_set(LI_REGEX_ENGINE_PCRE2)) {
+		g_test_message("not built with pcre2");
+		return;
+	}
+	test_captures(LI_REGEX_ENGINE_PCRE2);
+}
+
+/* each repetition of the group needs JIT stack; more than the default 32k JIT stack (and maybe more than
+ * the per thread JIT stack, then the interpreter is used) */
+static void test_regex_long_subject(void) {
+	liRegex *regex;
+	liRegexMatch *match = NULL;
+	GError *err = NULL;
+	GString *subject;
+	gint start, end, i;
+
+	if (!li_regex_engine_set(LI_REGEX_ENGINE_PCRE2)) {
+		g_test_message("not built with pcre2");
+		return;
+	}
+
+	subject = g_string_sized_new(10000);
+	for (i = 0; i < 5000; i++) g_string_append_len(subject, CONST_STR_LEN("ab"));
+
+	regex = li_regex_new("^(a|b)*$", NULL);
+	g_assert(NULL != regex);
+	g_assert(li_regex_match(regex, subject->str, &match, &err));
+	g_assert(NULL == err);
+	g_assert(li_regex_match_fetch_pos(match, 1, &start, &end));
+	g_assert_cmpint(start, ==, 9999);
+	g_assert_cmpint(end, ==, 10000);
+	li_regex_match_free(match);
+	li_regex_release(regex);
+
+	regex = li_regex_new("^(a|b)*c$", NULL);
+	g_assert(NULL != regex);
+	g_assert(!li_regex_match(regex, subject->str, NULL, &err));
+	g_assert(NULL == err);
+	li_regex_release(regex);
+
+	g_string_free(subject, TRUE);
+}
+
+static void test_regex_error(void) {
+	GError *err = NULL;
+
+	g_assert(NULL == li_regex_new("^/(foo", &err));
+	g_assert(NULL != err);
+	g_error_free(err);
+}
+
+int main(int argc, char **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/regex/glib", test_regex_glib);
+	g_test_add_func("/regex/pcre2", test_regex_pcre2);
+	g_test_add_func("/regex/long_subject", test_regex_long_subject);
+	g_test_add_func("/regex/error", test_regex_error);
+
+	return g_test_run();
+}